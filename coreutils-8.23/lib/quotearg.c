@@ -726,30 +726,38 @@ struct slotvec
   char *val;
 };
 
+/* Give each thread its own slots where the compiler supports it, so
+   that threads can quote at the same time.  */
+#if 3 < __GNUC__ + (3 <= __GNUC_MINOR__) && defined __ELF__
+# define SLOT_THREAD_LOCAL __thread
+#else
+# define SLOT_THREAD_LOCAL
+#endif
+
 /* Preallocate a slot 0 buffer, so that the caller can always quote
-   one small component of a "memory exhausted" message in slot 0.  */
-static char slot0[256];
-static unsigned int nslots = 1;
-static struct slotvec slotvec0 = {sizeof slot0, slot0};
-static struct slotvec *slotvec = &slotvec0;
+   one small component of a "memory exhausted" message in slot 0.
+   A null SLOTVEC stands for SLOTVEC0, whose value is then SLOT0, as
+   the address of a thread-local variable is not a constant.  */
+static SLOT_THREAD_LOCAL char slot0[256];
+static SLOT_THREAD_LOCAL unsigned int nslots = 1;
+static SLOT_THREAD_LOCAL struct slotvec slotvec0;
+static SLOT_THREAD_LOCAL struct slotvec *slotvec;
 
 void
 quotearg_free (void)
 {
-  struct slotvec *sv = slotvec;
+  struct slotvec *sv = slotvec ? slotvec : &slotvec0;
   unsigned int i;
   for (i = 1; i < nslots; i++)
     free (sv[i].val);
-  if (sv[0].val != slot0)
-    {
-      free (sv[0].val);
-      slotvec0.size = sizeof slot0;
-      slotvec0.val = slot0;
-    }
+  if (sv[0].val && sv[0].val != slot0)
+    free (sv[0].val);
+  slotvec0.size = 0;
+  slotvec0.val = NULL;
   if (sv != &slotvec0)
     {
       free (sv);
-      slotvec = &slotvec0;
+      slotvec = NULL;
     }
   nslots = 1;
 }
@@ -769,11 +777,17 @@ quotearg_n_options (int n, char const *arg, size_t argsize,
   int e = errno;
 
   unsigned int n0 = n;
-  struct slotvec *sv = slotvec;
+  struct slotvec *sv = slotvec ? slotvec : &slotvec0;
 
   if (n < 0)
     abort ();
 
+  if (! sv[0].val)
+    {
+      sv[0].size = sizeof slot0;
+      sv[0].val = slot0;
+    }
+
   if (nslots <= n0)
     {
       /* FIXME: technically, the type of n1 should be 'unsigned int',
@@ -48,6 +48,22 @@
 # error "invalid BLOCKSIZE"
 #endif
 
+/* On x86-64, blocks can be processed with the SHA extensions, or
+   failing that with BMI2 rotations, if available at run time.  */
+#if defined __x86_64__ && (4 < __GNUC__ || defined __clang__)
+# define SHA256_X86_BMI2 1
+# define SHA256_INLINE inline __attribute__ ((__always_inline__))
+#else
+# define SHA256_X86_BMI2 0
+# define SHA256_INLINE inline
+#endif
+#if defined __x86_64__ && 10 < __GNUC__ && ! defined __clang__
+# define SHA256_X86_SHA 1
+# include <immintrin.h>
+#else
+# define SHA256_X86_SHA 0
+#endif
+
 #if ! HAVE_OPENSSL_SHA256
 /* This array contains the bytes used to pad the buffer to the next
    64-byte boundary.  */
@@ -441,32 +457,25 @@ static const uint32_t sha256_round_constants[64] = {
 #define F2(A,B,C) ( ( A & B ) | ( C & ( A | B ) ) )
 #define F1(E,F,G) ( G ^ ( E & ( F ^ G ) ) )
 
-/* Process LEN bytes of BUFFER, accumulating context into CTX.
+/* Process LEN bytes of BUFFER, accumulating into STATE.
    It is assumed that LEN % 64 == 0.
    Most of this code comes from GnuPG's cipher/sha1.c.  */
 
-void
-sha256_process_block (const void *buffer, size_t len, struct sha256_ctx *ctx)
+static SHA256_INLINE void
+process_block (const void *buffer, size_t len, uint32_t *state)
 {
   const uint32_t *words = buffer;
   size_t nwords = len / sizeof (uint32_t);
   const uint32_t *endp = words + nwords;
   uint32_t x[16];
-  uint32_t a = ctx->state[0];
-  uint32_t b = ctx->state[1];
-  uint32_t c = ctx->state[2];
-  uint32_t d = ctx->state[3];
-  uint32_t e = ctx->state[4];
-  uint32_t f = ctx->state[5];
-  uint32_t g = ctx->state[6];
-  uint32_t h = ctx->state[7];
-  uint32_t lolen = len;
-
-  /* First increment the byte count.  FIPS PUB 180-2 specifies the possible
-     length of the file up to 2^64 bits.  Here we only compute the
-     number of bytes.  Do a double word increment.  */
-  ctx->total[0] += lolen;
-  ctx->total[1] += (len >> 31 >> 1) + (ctx->total[0] < lolen);
+  uint32_t a = state[0];
+  uint32_t b = state[1];
+  uint32_t c = state[2];
+  uint32_t d = state[3];
+  uint32_t e = state[4];
+  uint32_t f = state[5];
+  uint32_t g = state[6];
+  uint32_t h = state[7];
 
 #define rol(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
 #define S0(x) (rol(x,25)^rol(x,14)^(x>>3))
@@ -563,14 +572,155 @@ sha256_process_block (const void *buffer, size_t len, struct sha256_ctx *ctx)
       R( c, d, e, f, g, h, a, b, K(62), M(62) );
       R( b, c, d, e, f, g, h, a, K(63), M(63) );
 
-      a = ctx->state[0] += a;
-      b = ctx->state[1] += b;
-      c = ctx->state[2] += c;
-      d = ctx->state[3] += d;
-      e = ctx->state[4] += e;
-      f = ctx->state[5] += f;
-      g = ctx->state[6] += g;
-      h = ctx->state[7] += h;
+      a = state[0] += a;
+      b = state[1] += b;
+      c = state[2] += c;
+      d = state[3] += d;
+      e = state[4] += e;
+      f = state[5] += f;
+      g = state[6] += g;
+      h = state[7] += h;
+    }
+}
+
+static void
+process_block_generic (const void *buffer, size_t len, uint32_t *state)
+{
+  process_block (buffer, len, state);
+}
+
+#if SHA256_X86_BMI2
+/* Like process_block_generic, but rotate with RORX.  */
+static void __attribute__ ((__target__ ("bmi2")))
+process_block_bmi2 (const void *buffer, size_t len, uint32_t *state)
+{
+  process_block (buffer, len, state);
+}
+#endif
+
+#if SHA256_X86_SHA
+/* Like process_block_generic, but with the SHA extensions, which do
+   two rounds per SHA256RNDS2 and the message schedule for four rounds
+   per SHA256MSG1 and SHA256MSG2.  The state is kept as the words
+   A, B, E, F and C, D, G, H.  */
+static void __attribute__ ((__target__ ("sha,sse4.1")))
+process_block_sha (const void *buffer, size_t len, uint32_t *state)
+{
+  __m128i const *p = buffer;
+  __m128i const *endp = p + len / sizeof *p;
+  __m128i const bswap = _mm_set_epi64x (0x0c0d0e0f08090a0bULL,
+                                        0x0405060700010203ULL);
+  __m128i dcba = _mm_loadu_si128 ((__m128i const *) &state[0]);
+  __m128i hgfe = _mm_loadu_si128 ((__m128i const *) &state[4]);
+  __m128i cdab = _mm_shuffle_epi32 (dcba, 0xb1);
+  __m128i efgh = _mm_shuffle_epi32 (hgfe, 0x1b);
+  __m128i abef = _mm_alignr_epi8 (cdab, efgh, 8);
+  __m128i cdgh = _mm_blend_epi16 (efgh, cdab, 0xf0);
+
+  for (; p < endp; p += 4)
+    {
+      __m128i abef0 = abef;
+      __m128i cdgh0 = cdgh;
+      __m128i w[4];
+      int i;
+
+      /* W[I] holds the message words 4*J to 4*J+3, for the J from
+         0 to 15 that is I modulo 4.  Unroll so that W is kept in
+         registers.  */
+#pragma GCC unroll 16
+      for (i = 0; i < 16; i++)
+        {
+          __m128i wk;
+          if (i < 4)
+            w[i] = _mm_shuffle_epi8 (_mm_loadu_si128 (p + i), bswap);
+          else
+            {
+              __m128i w7 = _mm_alignr_epi8 (w[(i - 1) & 3], w[(i - 2) & 3], 4);
+              w[i & 3] = _mm_sha256msg2_epu32
+                (_mm_add_epi32 (_mm_sha256msg1_epu32 (w[i & 3],
+                                                      w[(i - 3) & 3]),
+                                w7),
+                 w[(i - 1) & 3]);
+            }
+          wk = _mm_add_epi32 (w[i & 3],
+                              _mm_loadu_si128 ((__m128i const *) &K (4 * i)));
+          cdgh = _mm_sha256rnds2_epu32 (cdgh, abef, wk);
+          abef = _mm_sha256rnds2_epu32 (abef, cdgh,
+                                        _mm_shuffle_epi32 (wk, 0x0e));
+        }
+
+      abef = _mm_add_epi32 (abef, abef0);
+      cdgh = _mm_add_epi32 (cdgh, cdgh0);
     }
+
+  {
+    __m128i feba = _mm_shuffle_epi32 (abef, 0x1b);
+    __m128i dchg = _mm_shuffle_epi32 (cdgh, 0xb1);
+    _mm_storeu_si128 ((__m128i *) &state[0],
+                      _mm_blend_epi16 (feba, dchg, 0xf0));
+    _mm_storeu_si128 ((__m128i *) &state[4],
+                      _mm_alignr_epi8 (dchg, feba, 8));
+  }
+}
+#endif
+
+/* The kernel set by sha256_set_kernel, or NULL to use the fastest
+   one available.  */
+static void (*kernel) (const void *, size_t, uint32_t *);
+
+/* Process LEN bytes of BUFFER, accumulating context into CTX.
+   It is assumed that LEN % 64 == 0.  */
+
+void
+sha256_process_block (const void *buffer, size_t len, struct sha256_ctx *ctx)
+{
+  uint32_t lolen = len;
+
+  /* First increment the byte count.  FIPS PUB 180-2 specifies the possible
+     length of the file up to 2^64 bits.  Here we only compute the
+     number of bytes.  Do a double word increment.  */
+  ctx->total[0] += lolen;
+  ctx->total[1] += (len >> 31 >> 1) + (ctx->total[0] < lolen);
+
+  if (kernel)
+    {
+      kernel (buffer, len, ctx->state);
+      return;
+    }
+#if SHA256_X86_SHA
+  if (__builtin_cpu_supports ("sha") && __builtin_cpu_supports ("sse4.1"))
+    {
+      process_block_sha (buffer, len, ctx->state);
+      return;
+    }
+#endif
+#if SHA256_X86_BMI2
+  if (__builtin_cpu_supports ("bmi2"))
+    {
+      process_block_bmi2 (buffer, len, ctx->state);
+      return;
+    }
+#endif
+  process_block_generic (buffer, len, ctx->state);
+}
+
+int
+sha256_set_kernel (char const *name)
+{
+  if (strcmp (name, "generic") == 0)
+    kernel = process_block_generic;
+#if SHA256_X86_SHA
+  else if (strcmp (name, "sha") == 0
+           && __builtin_cpu_supports ("sha")
+           && __builtin_cpu_supports ("sse4.1"))
+    kernel = process_block_sha;
+#endif
+#if SHA256_X86_BMI2
+  else if (strcmp (name, "bmi2") == 0 && __builtin_cpu_supports ("bmi2"))
+    kernel = process_block_bmi2;
+#endif
+  else
+    return 0;
+  return 1;
 }
 #endif
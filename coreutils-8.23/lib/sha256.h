@@ -59,6 +59,12 @@ extern void sha224_init_ctx (struct sha256_ctx *ctx);
 extern void sha256_process_block (const void *buffer, size_t len,
                                   struct sha256_ctx *ctx);
 
+/* Make sha256_process_block use the kernel NAME, one of "generic",
+   "bmi2" and "sha", rather than the fastest one this processor
+   supports.  This is for testing.  Return 0 if NAME is unknown or
+   unsupported, 1 otherwise.  */
+extern int sha256_set_kernel (char const *name);
+
 /* Starting with the result of former calls of this function (or the
    initialization function update the context for the next LEN bytes
    starting at BUFFER.
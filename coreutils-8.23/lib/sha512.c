@@ -55,6 +55,16 @@
 # error "invalid BLOCKSIZE"
 #endif
 
+/* On x86-64, blocks can be processed with BMI2 rotations, if
+   available at run time.  */
+#if defined __x86_64__ && (4 < __GNUC__ || defined __clang__)
+# define SHA512_X86_BMI2 1
+# define SHA512_INLINE inline __attribute__ ((__always_inline__))
+#else
+# define SHA512_X86_BMI2 0
+# define SHA512_INLINE inline
+#endif
+
 #if ! HAVE_OPENSSL_SHA512
 /* This array contains the bytes used to pad the buffer to the next
    128-byte boundary.  */
@@ -473,33 +483,24 @@ static u64 const sha512_round_constants[80] = {
 #define F2(A, B, C) u64or (u64and (A, B), u64and (C, u64or (A, B)))
 #define F1(E, F, G) u64xor (G, u64and (E, u64xor (F, G)))
 
-/* Process LEN bytes of BUFFER, accumulating context into CTX.
+/* Process LEN bytes of BUFFER, accumulating into STATE.
    It is assumed that LEN % 128 == 0.
    Most of this code comes from GnuPG's cipher/sha1.c.  */
 
-void
-sha512_process_block (const void *buffer, size_t len, struct sha512_ctx *ctx)
+static SHA512_INLINE void
+process_block (const void *buffer, size_t len, u64 *state)
 {
   u64 const *words = buffer;
   u64 const *endp = words + len / sizeof (u64);
   u64 x[16];
-  u64 a = ctx->state[0];
-  u64 b = ctx->state[1];
-  u64 c = ctx->state[2];
-  u64 d = ctx->state[3];
-  u64 e = ctx->state[4];
-  u64 f = ctx->state[5];
-  u64 g = ctx->state[6];
-  u64 h = ctx->state[7];
-  u64 lolen = u64size (len);
-
-  /* First increment the byte count.  FIPS PUB 180-2 specifies the possible
-     length of the file up to 2^128 bits.  Here we only compute the
-     number of bytes.  Do a double word increment.  */
-  ctx->total[0] = u64plus (ctx->total[0], lolen);
-  ctx->total[1] = u64plus (ctx->total[1],
-                           u64plus (u64size (len >> 31 >> 31 >> 2),
-                                    u64lo (u64lt (ctx->total[0], lolen))));
+  u64 a = state[0];
+  u64 b = state[1];
+  u64 c = state[2];
+  u64 d = state[3];
+  u64 e = state[4];
+  u64 f = state[5];
+  u64 g = state[6];
+  u64 h = state[7];
 
 #define S0(x) u64xor (u64rol(x, 63), u64xor (u64rol (x, 56), u64shr (x, 7)))
 #define S1(x) u64xor (u64rol (x, 45), u64xor (u64rol (x, 3), u64shr (x, 6)))
@@ -615,14 +616,79 @@ sha512_process_block (const void *buffer, size_t len, struct sha512_ctx *ctx)
       R( c, d, e, f, g, h, a, b, K(78), M(78) );
       R( b, c, d, e, f, g, h, a, K(79), M(79) );
 
-      a = ctx->state[0] = u64plus (ctx->state[0], a);
-      b = ctx->state[1] = u64plus (ctx->state[1], b);
-      c = ctx->state[2] = u64plus (ctx->state[2], c);
-      d = ctx->state[3] = u64plus (ctx->state[3], d);
-      e = ctx->state[4] = u64plus (ctx->state[4], e);
-      f = ctx->state[5] = u64plus (ctx->state[5], f);
-      g = ctx->state[6] = u64plus (ctx->state[6], g);
-      h = ctx->state[7] = u64plus (ctx->state[7], h);
+      a = state[0] = u64plus (state[0], a);
+      b = state[1] = u64plus (state[1], b);
+      c = state[2] = u64plus (state[2], c);
+      d = state[3] = u64plus (state[3], d);
+      e = state[4] = u64plus (state[4], e);
+      f = state[5] = u64plus (state[5], f);
+      g = state[6] = u64plus (state[6], g);
+      h = state[7] = u64plus (state[7], h);
     }
 }
+
+static void
+process_block_generic (const void *buffer, size_t len, u64 *state)
+{
+  process_block (buffer, len, state);
+}
+
+#if SHA512_X86_BMI2
+/* Like process_block_generic, but rotate with RORX, which unlike ROR
+   does not overwrite its operand, saving a move per rotation.  */
+static void __attribute__ ((__target__ ("bmi2")))
+process_block_bmi2 (const void *buffer, size_t len, u64 *state)
+{
+  process_block (buffer, len, state);
+}
+#endif
+
+/* The kernel set by sha512_set_kernel, or NULL to use the fastest
+   one available.  */
+static void (*kernel) (const void *, size_t, u64 *);
+
+/* Process LEN bytes of BUFFER, accumulating context into CTX.
+   It is assumed that LEN % 128 == 0.  */
+
+void
+sha512_process_block (const void *buffer, size_t len, struct sha512_ctx *ctx)
+{
+  u64 lolen = u64size (len);
+
+  /* First increment the byte count.  FIPS PUB 180-2 specifies the possible
+     length of the file up to 2^128 bits.  Here we only compute the
+     number of bytes.  Do a double word increment.  */
+  ctx->total[0] = u64plus (ctx->total[0], lolen);
+  ctx->total[1] = u64plus (ctx->total[1],
+                           u64plus (u64size (len >> 31 >> 31 >> 2),
+                                    u64lo (u64lt (ctx->total[0], lolen))));
+
+  if (kernel)
+    {
+      kernel (buffer, len, ctx->state);
+      return;
+    }
+#if SHA512_X86_BMI2
+  if (__builtin_cpu_supports ("bmi2"))
+    {
+      process_block_bmi2 (buffer, len, ctx->state);
+      return;
+    }
+#endif
+  process_block_generic (buffer, len, ctx->state);
+}
+
+int
+sha512_set_kernel (char const *name)
+{
+  if (strcmp (name, "generic") == 0)
+    kernel = process_block_generic;
+#if SHA512_X86_BMI2
+  else if (strcmp (name, "bmi2") == 0 && __builtin_cpu_supports ("bmi2"))
+    kernel = process_block_bmi2;
+#endif
+  else
+    return 0;
+  return 1;
+}
 #endif
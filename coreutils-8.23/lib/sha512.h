@@ -59,6 +59,12 @@ extern void sha384_init_ctx (struct sha512_ctx *ctx);
 extern void sha512_process_block (const void *buffer, size_t len,
                                   struct sha512_ctx *ctx);
 
+/* Make sha512_process_block use the kernel NAME, one of "generic"
+   and "bmi2", rather than the fastest one this processor
+   supports.  This is for testing.  Return 0 if NAME is unknown or
+   unsupported, 1 otherwise.  */
+extern int sha512_set_kernel (char const *name);
+
 /* Starting with the result of former calls of this function (or the
    initialization function update the context for the next LEN bytes
    starting at BUFFER.
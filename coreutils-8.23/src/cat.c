@@ -32,6 +32,30 @@
 #endif
 #include <sys/ioctl.h>
 
+/* Whether to copy in the kernel with splice and sendfile and, if the C
+   library declares it, copy_file_range.  */
+#ifdef __linux__
+# define CAT_KERNEL_COPY 1
+# include <sys/sendfile.h>
+# if defined __GLIBC__ && (2 < __GLIBC__ + (27 <= __GLIBC_MINOR__))
+#  define CAT_COPY_FILE_RANGE 1
+# else
+#  define CAT_COPY_FILE_RANGE 0
+# endif
+#else
+# define CAT_KERNEL_COPY 0
+#endif
+
+/* Whether to scan for bytes that need conversion with SSE2, which is
+   always available on x86-64.  */
+#if (defined __x86_64__ \
+     && (4 < __GNUC__ + (9 <= __GNUC_MINOR__) || defined __clang__))
+# define CAT_X86_SIMD 1
+# include <immintrin.h>
+#else
+# define CAT_X86_SIMD 0
+#endif
+
 #include "system.h"
 #include "ioblksize.h"
 #include "error.h"
@@ -78,6 +102,12 @@ static char *line_num_end = line_buf + LINE_COUNTER_BUF_LEN - 3;
 /* Preserves the 'cat' function's local 'newlines' between invocations.  */
 static int newlines2 = 0;
 
+#if CAT_KERNEL_COPY
+/* The most bytes to copy with one system call, when copying in the
+   kernel.  */
+enum { KERNEL_COPY_MAX = 1024 * 1024 * 1024 };
+#endif
+
 void
 usage (int status)
 {
@@ -125,7 +155,7 @@ Examples:\n\
 
 /* Compute the next line number.  */
 
-static void
+static inline void
 next_line_num (void)
 {
   char *endp = line_num_end;
@@ -144,6 +174,118 @@ next_line_num (void)
     line_num_print--;
 }
 
+/* Compute the next line number, and copy it to BPOUT followed by a
+   tab.  Return the end of the copy.  */
+
+static inline char *
+write_line_num (char *bpout)
+{
+  next_line_num ();
+  return mempcpy (bpout, line_num_print,
+                  line_buf + LINE_COUNTER_BUF_LEN - 1 - line_num_print);
+}
+
+/* Return the first byte in [P, LIM) that the 'cat' function cannot
+   copy as is: a newline, a tab if SHOW_TABS, and other bytes shown in
+   ^ and M- notation if SHOW_NONPRINTING.  Return LIM if there is
+   none.  */
+
+static char * _GL_ATTRIBUTE_PURE
+find_special (char *p, char *lim, bool show_nonprinting, bool show_tabs)
+{
+  if (! (show_nonprinting || show_tabs))
+    {
+      char *nl = memchr (p, '\n', lim - p);
+      return nl ? nl : lim;
+    }
+
+#if CAT_X86_SIMD
+  {
+    __m128i const newline = _mm_set1_epi8 ('\n');
+    __m128i const tab = _mm_set1_epi8 ('\t');
+    __m128i const space = _mm_set1_epi8 (' ');
+    __m128i const del = _mm_set1_epi8 (0x7f);
+
+    for (; 16 <= lim - p; p += 16)
+      {
+        __m128i v = _mm_loadu_si128 ((__m128i const *) p);
+        __m128i is_tab = _mm_cmpeq_epi8 (v, tab);
+        __m128i special;
+        unsigned int mask;
+
+        if (show_nonprinting)
+          {
+            /* Bytes less than ' ' or greater than 0x7e are less than
+               ' ' as signed numbers, except for 0x7f.  */
+            special = _mm_or_si128 (_mm_cmplt_epi8 (v, space),
+                                    _mm_cmpeq_epi8 (v, del));
+            if (! show_tabs)
+              special = _mm_andnot_si128 (is_tab, special);
+          }
+        else
+          special = _mm_or_si128 (_mm_cmpeq_epi8 (v, newline), is_tab);
+
+        mask = _mm_movemask_epi8 (special);
+        if (mask)
+          return p + __builtin_ctz (mask);
+      }
+  }
+#endif
+
+  for (; p < lim; p++)
+    {
+      unsigned char c = *p;
+      if (c == '\n'
+          || (c == '\t'
+              ? show_tabs
+              : show_nonprinting && (c < ' ' || 0x7f <= c)))
+        return p;
+    }
+  return lim;
+}
+
+/* Copy as much as possible of the file behind 'input_desc', whose
+   status is *IN_ST, to STDOUT_FILENO, whose status is *OUT_ST, without
+   copying the data into and out of a user buffer.  Use copy_file_range
+   between regular files, splice when either file is a pipe, and
+   sendfile from a regular file to a socket.
+
+   Stop at the first system call that fails or copies nothing, and
+   leave the rest of the file, including any diagnostic, to the read
+   and write loop of simple_cat.  Each call advances the file offsets,
+   so that loop resumes where this one stopped.  It also confirms the
+   end of the input, which is not always reported correctly here: some
+   file systems have files that copy_file_range sees as empty.  */
+
+static void
+copy_in_kernel (struct stat const *in_st, struct stat const *out_st)
+{
+#if CAT_KERNEL_COPY
+  ssize_t n_copied;
+
+  do
+    {
+      if (S_ISFIFO (in_st->st_mode) || S_ISFIFO (out_st->st_mode))
+        n_copied = splice (input_desc, NULL, STDOUT_FILENO, NULL,
+                           KERNEL_COPY_MAX, 0);
+# if CAT_COPY_FILE_RANGE
+      else if (S_ISREG (in_st->st_mode) && S_ISREG (out_st->st_mode))
+        n_copied = copy_file_range (input_desc, NULL, STDOUT_FILENO, NULL,
+                                    KERNEL_COPY_MAX, 0);
+# endif
+      else if (S_ISREG (in_st->st_mode) && S_ISSOCK (out_st->st_mode))
+        n_copied = sendfile (STDOUT_FILENO, input_desc, NULL,
+                             KERNEL_COPY_MAX);
+      else
+        return;
+    }
+  while (0 < n_copied);
+#else
+  (void) in_st;
+  (void) out_st;
+#endif
+}
+
 /* Plain cat.  Copies the file behind 'input_desc' to STDOUT_FILENO.
    Return true if successful.  */
 
@@ -389,10 +531,7 @@ cat (
                   /* Are line numbers to be written at empty lines (-n)?  */
 
                   if (number && !number_nonblank)
-                    {
-                      next_line_num ();
-                      bpout = stpcpy (bpout, line_num_print);
-                    }
+                    bpout = write_line_num (bpout);
                 }
 
               /* Output a currency symbol if requested (-e).  */
@@ -411,10 +550,7 @@ cat (
       /* Are we at the beginning of a line, and line numbers are requested?  */
 
       if (newlines >= 0 && number)
-        {
-          next_line_num ();
-          bpout = stpcpy (bpout, line_num_print);
-        }
+        bpout = write_line_num (bpout);
 
       /* Here CH cannot contain a newline character.  */
 
@@ -422,12 +558,18 @@ cat (
          which means that the buffer is empty or that a proper newline
          has been found.  */
 
+      /* Each iteration of the loops below handles CH, and then copies
+         the bytes up to the next one that needs handling in one go.
+         The sentinel newline at EOB bounds that search.  */
+
       /* If quoting, i.e. at least one of -v, -e, or -t specified,
          scan for chars that need conversion.  */
       if (show_nonprinting)
         {
           while (true)
             {
+              char *run_end;
+
               if (ch >= 32)
                 {
                   if (ch < 127)
@@ -471,6 +613,9 @@ cat (
                   *bpout++ = ch + 64;
                 }
 
+              run_end = find_special (bpin, eob + 1, true, show_tabs);
+              bpout = mempcpy (bpout, bpin, run_end - bpin);
+              bpin = run_end;
               ch = *bpin++;
             }
         }
@@ -479,6 +624,8 @@ cat (
           /* Not quoting, neither of -v, -e, or -t specified.  */
           while (true)
             {
+              char *run_end;
+
               if (ch == '\t' && show_tabs)
                 {
                   *bpout++ = '^';
@@ -492,6 +639,9 @@ cat (
                   break;
                 }
 
+              run_end = find_special (bpin, eob + 1, false, show_tabs);
+              bpout = mempcpy (bpout, bpin, run_end - bpin);
+              bpin = run_end;
               ch = *bpin++;
             }
         }
@@ -527,6 +677,9 @@ main (int argc, char **argv)
   /* I-node number of the output.  */
   ino_t out_ino;
 
+  /* Status of the output.  */
+  struct stat out_stat;
+
   /* True if the output file should not be the same as any input file.  */
   bool check_redirection = true;
 
@@ -636,6 +789,7 @@ main (int argc, char **argv)
   if (fstat (STDOUT_FILENO, &stat_buf) < 0)
     error (EXIT_FAILURE, errno, _("standard output"));
 
+  out_stat = stat_buf;
   outsize = io_blksize (stat_buf);
   /* Input file can be output file for non-regular files.
      fstat on pipes returns S_IFSOCK on some systems, S_IFIFO
@@ -727,6 +881,7 @@ main (int argc, char **argv)
           insize = MAX (insize, outsize);
           inbuf = xmalloc (insize + page_size - 1);
 
+          copy_in_kernel (&stat_buf, &out_stat);
           ok &= simple_cat (ptr_align (inbuf, page_size), insize);
         }
       else
@@ -45,6 +45,7 @@
 #include "system.h"
 #include "fadvise.h"
 #include "xfreopen.h"
+#include "xstrtol.h"
 
 #ifdef CRCTAB
 
@@ -170,9 +171,213 @@ static uint_fast32_t const crctab[256] =
   0xa2f33668, 0xbcb4666d, 0xb8757bda, 0xb5365d03, 0xb1f740b4
 };
 
+/* Whether to provide the PCLMULQDQ engine.  Its code is compiled with
+   a target attribute, and used only if the processor supports it.  */
+# if (defined __x86_64__ \
+      && (4 < __GNUC__ + (9 <= __GNUC_MINOR__) || defined __clang__))
+#  define CKSUM_PCLMUL 1
+#  include <immintrin.h>
+# else
+#  define CKSUM_PCLMUL 0
+# endif
+
+/* Return the CRC of the LEN bytes at BUF, continuing from CRC, one
+   byte at a time.  This is the reference for the other engines.  */
+
+static uint_fast32_t _GL_ATTRIBUTE_PURE
+crc_bytewise (uint_fast32_t crc, unsigned char const *buf, size_t len)
+{
+  while (len--)
+    crc = (crc << 8) ^ crctab[((crc >> 24) ^ *buf++) & 0xFF];
+  return crc & 0xFFFFFFFF;
+}
+
+/* crctab8[K][B] is the CRC of byte B followed by K zero bytes, so that
+   eight bytes can be handled at once.  crctab8[0] is crctab.  */
+static uint_fast32_t crctab8[8][256];
+
+static void
+fill_crctab8 (void)
+{
+  int i;
+  int k;
+
+  for (i = 0; i < 256; i++)
+    {
+      crctab8[0][i] = crctab[i];
+      for (k = 1; k < 8; k++)
+        crctab8[k][i] = (((crctab8[k - 1][i] << 8) & 0xFFFFFFFF)
+                         ^ crctab[crctab8[k - 1][i] >> 24]);
+    }
+}
+
+/* Like crc_bytewise, but eight bytes at a time.  */
+
+static uint_fast32_t _GL_ATTRIBUTE_PURE
+crc_slice8 (uint_fast32_t crc, unsigned char const *buf, size_t len)
+{
+  for (; 8 <= len; buf += 8, len -= 8)
+    {
+      uint_fast32_t hi = crc ^ (((uint_fast32_t) buf[0] << 24)
+                                | (buf[1] << 16) | (buf[2] << 8) | buf[3]);
+      crc = (crctab8[7][hi >> 24] ^ crctab8[6][(hi >> 16) & 0xFF]
+             ^ crctab8[5][(hi >> 8) & 0xFF] ^ crctab8[4][hi & 0xFF]
+             ^ crctab8[3][buf[4]] ^ crctab8[2][buf[5]]
+             ^ crctab8[1][buf[6]] ^ crctab8[0][buf[7]]);
+    }
+  return crc_bytewise (crc, buf, len);
+}
+
+# if CKSUM_PCLMUL
+/* Return X**N modulo the generating polynomial, for the folding
+   constants of crc_pclmul.  */
+
+static uint64_t _GL_ATTRIBUTE_CONST
+xpow_mod (int n)
+{
+  uint64_t r = 1;
+
+  while (n--)
+    {
+      r <<= 1;
+      if (r >> 32)
+        r ^= 0x104C11DB7;
+    }
+  return r;
+}
+
+/* Return the 128-bit polynomial of DATA, folded forward by the number
+   of bits for which K holds X**(N+64) and X**N in its high and low
+   halves.  The result is congruent to DATA * X**N, and has degree less
+   than 96.  */
+
+static __m128i __attribute__ ((__target__ ("pclmul")))
+fold (__m128i data, __m128i k)
+{
+  return _mm_xor_si128 (_mm_clmulepi64_si128 (data, k, 0x11),
+                        _mm_clmulepi64_si128 (data, k, 0x00));
+}
+
+/* Like crc_bytewise, but with carry-less multiplication, as in Intel's
+   "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ
+   Instruction".  Each 16-byte block is loaded as a polynomial with its
+   first bit as the highest coefficient, and the CRC so far is added to
+   the first block.  Four running blocks are folded forward onto the
+   next four, and then onto each other, leaving one block congruent to
+   the data so far.  Its CRC is that of the data, and is computed a
+   byte at a time, as is that of the remaining bytes.  */
+
+static uint_fast32_t __attribute__ ((__target__ ("pclmul,ssse3")))
+crc_pclmul (uint_fast32_t crc, unsigned char const *buf, size_t len)
+{
+  static bool initialized;
+  static __m128i k128;
+  static __m128i k512;
+  __m128i const reverse = _mm_set_epi8 (0, 1, 2, 3, 4, 5, 6, 7,
+                                        8, 9, 10, 11, 12, 13, 14, 15);
+  __m128i acc[4];
+  unsigned char block[16];
+  int i;
+
+  if (len < 64)
+    return crc_slice8 (crc, buf, len);
+
+  if (! initialized)
+    {
+      k128 = _mm_set_epi64x (xpow_mod (128 + 64), xpow_mod (128));
+      k512 = _mm_set_epi64x (xpow_mod (512 + 64), xpow_mod (512));
+      initialized = true;
+    }
+
+  for (i = 0; i < 4; i++)
+    acc[i] = _mm_shuffle_epi8 (_mm_loadu_si128 ((__m128i const *) buf
+                                                + i),
+                               reverse);
+  acc[0] = _mm_xor_si128 (acc[0], _mm_set_epi32 (crc, 0, 0, 0));
+  buf += 64;
+  len -= 64;
+
+  for (; 64 <= len; buf += 64, len -= 64)
+    for (i = 0; i < 4; i++)
+      acc[i] = _mm_xor_si128 (fold (acc[i], k512),
+                              _mm_shuffle_epi8
+                              (_mm_loadu_si128 ((__m128i const *) buf + i),
+                               reverse));
+
+  for (i = 1; i < 4; i++)
+    acc[0] = _mm_xor_si128 (fold (acc[0], k128), acc[i]);
+
+  _mm_storeu_si128 ((__m128i *) block, _mm_shuffle_epi8 (acc[0], reverse));
+  crc = crc_slice8 (0, block, sizeof block);
+  return crc_slice8 (crc, buf, len);
+}
+# endif
+
+/* A way of computing the CRC, for testing.  */
+struct crc_engine
+{
+  char const *name;
+  uint_fast32_t (*update) (uint_fast32_t, unsigned char const *, size_t);
+};
+
+static struct crc_engine const crc_engines[] =
+{
+  {"bytewise", crc_bytewise},
+  {"slice8", crc_slice8},
+# if CKSUM_PCLMUL
+  {"pclmul", crc_pclmul},
+# endif
+  {NULL, NULL}
+};
+
+/* The data of each file is read into a buffer aligned to this many
+   bytes, plus BUFFER_OFFSET, which is less.  */
+enum { BUFFER_ALIGN = 64 };
+static size_t buffer_offset;
+
+/* The engine used for the data of each file.  */
+static uint_fast32_t (*crc_update) (uint_fast32_t, unsigned char const *,
+                                    size_t) = crc_slice8;
+
+/* Return whether the engine NAME can be used on this processor.  */
+
+static bool
+crc_engine_supported (char const *name)
+{
+# if CKSUM_PCLMUL
+  if (STREQ (name, "pclmul"))
+    {
+      __builtin_cpu_init ();
+      return (__builtin_cpu_supports ("pclmul")
+              && __builtin_cpu_supports ("ssse3"));
+    }
+# endif
+  return true;
+}
+
 /* Nonzero if any of the files read were the standard input. */
 static bool have_read_stdin;
 
+/* For long options that have no equivalent short option, use a
+   non-character as a pseudo short option, starting with CHAR_MAX + 1.  */
+enum
+{
+  ENGINE_OPTION = CHAR_MAX + 1,
+  BUFFER_OFFSET_OPTION
+};
+
+static struct option const long_options[] =
+{
+  /* This is solely for testing.  Do not document.  */
+  /* It selects how the CRC is computed, so that each way can be
+     compared with the others.  */
+  {"-engine", required_argument, NULL, ENGINE_OPTION},
+  /* It misaligns the data given to the engine by this many bytes, so
+     that each engine's handling of unaligned data can be checked.  */
+  {"-buffer-offset", required_argument, NULL, BUFFER_OFFSET_OPTION},
+  {NULL, 0, NULL, 0}
+};
+
 /* Calculate and print the checksum and length in bytes
    of file FILE, or of the standard input if FILE is "-".
    If PRINT_NAME is true, print FILE next to the checksum and size.
@@ -181,7 +386,8 @@ static bool have_read_stdin;
 static bool
 cksum (const char *file, bool print_name)
 {
-  unsigned char buf[BUFLEN];
+  unsigned char buf_space[BUFLEN + 2 * BUFFER_ALIGN];
+  unsigned char *buf = ptr_align (buf_space, BUFFER_ALIGN);
   uint_fast32_t crc = 0;
   uintmax_t length = 0;
   size_t bytes_read;
@@ -208,15 +414,13 @@ cksum (const char *file, bool print_name)
 
   fadvise (fp, FADVISE_SEQUENTIAL);
 
+  buf += buffer_offset;
   while ((bytes_read = fread (buf, 1, BUFLEN, fp)) > 0)
     {
-      unsigned char *cp = buf;
-
       if (length + bytes_read < length)
         error (EXIT_FAILURE, 0, _("%s: file too long"), file);
       length += bytes_read;
-      while (bytes_read--)
-        crc = (crc << 8) ^ crctab[((crc >> 24) ^ *cp++) & 0xFF];
+      crc = crc_update (crc, buf, bytes_read);
       if (feof (fp))
         break;
     }
@@ -280,6 +484,7 @@ int
 main (int argc, char **argv)
 {
   int i;
+  int c;
   bool ok;
 
   initialize_main (&argc, &argv);
@@ -296,8 +501,41 @@ main (int argc, char **argv)
 
   parse_long_options (argc, argv, PROGRAM_NAME, PACKAGE, Version,
                       usage, AUTHORS, (char const *) NULL);
-  if (getopt_long (argc, argv, "", NULL, NULL) != -1)
-    usage (EXIT_FAILURE);
+
+  fill_crctab8 ();
+# if CKSUM_PCLMUL
+  if (crc_engine_supported ("pclmul"))
+    crc_update = crc_pclmul;
+# endif
+
+  while ((c = getopt_long (argc, argv, "", long_options, NULL)) != -1)
+    switch (c)
+      {
+      case ENGINE_OPTION:
+        {
+          struct crc_engine const *e;
+          for (e = crc_engines; e->name; e++)
+            if (STREQ (e->name, optarg))
+              break;
+          if (! e->name || ! crc_engine_supported (optarg))
+            error (EXIT_FAILURE, 0, _("unsupported engine: %s"), optarg);
+          crc_update = e->update;
+        }
+        break;
+
+      case BUFFER_OFFSET_OPTION:
+        {
+          unsigned long int n;
+          if (xstrtoul (optarg, NULL, 10, &n, "") != LONGINT_OK
+              || BUFFER_ALIGN <= n)
+            error (EXIT_FAILURE, 0, _("invalid buffer offset: %s"), optarg);
+          buffer_offset = n;
+        }
+        break;
+
+      default:
+        usage (EXIT_FAILURE);
+      }
 
   have_read_stdin = false;
 
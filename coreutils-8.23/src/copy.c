@@ -19,6 +19,7 @@
 #include <config.h>
 #include <stdio.h>
 #include <assert.h>
+#include <pthread.h>
 #include <sys/ioctl.h>
 #include <sys/types.h>
 #include <selinux/selinux.h>
@@ -106,6 +107,32 @@ rpl_mkfifo (char const *file, mode_t mode)
 # define CAN_HARDLINK_SYMLINKS 0
 #endif
 
+/* Whether the C library declares copy_file_range, to copy data between
+   regular files in the kernel, and the most bytes to copy per call.  */
+#if (defined __linux__ && defined __GLIBC__ \
+     && (2 < __GLIBC__ + (27 <= __GLIBC_MINOR__)))
+# define HAVE_COPY_FILE_RANGE_CALL 1
+enum { COPY_FILE_RANGE_MAX = 1024 * 1024 * 1024 };
+#else
+# define HAVE_COPY_FILE_RANGE_CALL 0
+#endif
+
+/* Whether the kernel headers describe io_uring well enough to open,
+   read, write and close files in a ring.  The C library need not wrap
+   the system calls, so they are made directly.  */
+#if defined __linux__ && defined __has_include
+# if __has_include (<linux/io_uring.h>)
+#  include <linux/io_uring.h>
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+# endif
+#endif
+#if defined IORING_FEAT_RW_CUR_POS && defined SYS_io_uring_setup
+# define USE_IO_URING 1
+#else
+# define USE_IO_URING 0
+#endif
+
 struct dir_list
 {
   struct dir_list *parent;
@@ -113,6 +140,24 @@ struct dir_list
   dev_t dev;
 };
 
+/* With cp --parallel, the regular files found in a directory form a
+   group of jobs that copy_reg runs in threads; otherwise, the small
+   ones may form a group that io_uring copies in batches.  copy_dir
+   waits for all of them before returning, so that a directory's contents are copied
+   before copy_internal sets the directory's own metadata.  */
+struct copy_group
+{
+  /* The number of jobs queued and not yet finished.  */
+  size_t pending;
+
+  /* Whether all the finished jobs succeeded.  */
+  bool ok;
+};
+
+/* The group of the directory being read, or NULL if files are to be
+   copied at once.  Used only by the main thread.  */
+static struct copy_group *current_group;
+
 /* Initial size of the cp.dest_info hash table.  */
 #define DEST_INFO_INITIAL_CAPACITY 61
 
@@ -125,6 +170,7 @@ static bool copy_internal (char const *src_name, char const *dst_name,
                            bool *copy_into_self,
                            bool *rename_succeeded);
 static bool owner_failure_ok (struct cp_options const *x);
+static void wait_for_jobs (size_t const *pending);
 
 /* Pointers to the file names:  they're used in the diagnostic that is issued
    when we detect the user is trying to copy a directory into itself.  */
@@ -155,7 +201,15 @@ utimens_symlink (char const *file, struct timespec const *timespec)
    beyond BUF[BUF_SIZE-1].
    Set *LAST_WRITE_MADE_HOLE to true if the final operation on
    DEST_FD introduced a hole.  Set *TOTAL_N_READ to the number of
-   bytes read.  */
+   bytes read.
+
+   Unless making holes, which requires looking at the data, first let
+   the kernel copy with copy_file_range, without a user buffer.  Stop
+   at the first call that fails or copies nothing, and leave the rest,
+   including any diagnostic, to the read and write loop: that call may
+   fail only because the files are not both regular or are on
+   different file systems, and some files, e.g., in /proc, look empty
+   to copy_file_range.  */
 static bool
 sparse_copy (int src_fd, int dest_fd, char *buf, size_t buf_size,
              bool make_holes,
@@ -166,6 +220,21 @@ sparse_copy (int src_fd, int dest_fd, char *buf, size_t buf_size,
   *last_write_made_hole = false;
   *total_n_read = 0;
 
+#if HAVE_COPY_FILE_RANGE_CALL
+  if (! make_holes)
+    while (max_n_read)
+      {
+        ssize_t n_copied = copy_file_range (src_fd, NULL, dest_fd, NULL,
+                                            MIN (max_n_read,
+                                                 COPY_FILE_RANGE_MAX),
+                                            0);
+        if (n_copied <= 0)
+          break;
+        max_n_read -= n_copied;
+        *total_n_read += n_copied;
+      }
+#endif
+
   while (max_n_read)
     {
       bool make_hole = false;
@@ -229,7 +298,8 @@ sparse_copy (int src_fd, int dest_fd, char *buf, size_t buf_size,
   return true;
 }
 
-/* Perform the O(1) btrfs clone operation, if possible.
+/* Perform the O(1) btrfs clone operation, if possible.  Linux 4.5 and
+   later also support it as FICLONE on XFS and other file systems.
    Upon success, return 0.  Otherwise, return -1 and set errno.  */
 static inline int
 clone_file (int dest_fd, int src_fd)
@@ -598,6 +668,9 @@ copy_dir (char const *src_name_in, char const *dst_name_in, bool new_dst,
   struct cp_options non_command_line_options = *x;
   bool ok = true;
 
+  struct copy_group group = { 0, true };
+  struct copy_group *outer_group = current_group;
+
   name_space = savedir (src_name_in, SAVEDIR_SORT_FASTREAD);
   if (name_space == NULL)
     {
@@ -607,6 +680,9 @@ copy_dir (char const *src_name_in, char const *dst_name_in, bool new_dst,
       return false;
     }
 
+  if (1 < x->nthreads || x->io_uring)
+    current_group = &group;
+
   /* For cp's -H option, dereference command line arguments, but do not
      dereference symlinks that are found via recursive traversal.  */
   if (x->dereference == DEREF_COMMAND_LINE_ARGUMENTS)
@@ -642,6 +718,13 @@ copy_dir (char const *src_name_in, char const *dst_name_in, bool new_dst,
   free (name_space);
   *first_dir_created_per_command_line_arg = new_first_dir_created;
 
+  if (current_group == &group)
+    {
+      wait_for_jobs (&group.pending);
+      ok &= group.ok;
+      current_group = outer_group;
+    }
+
   return ok;
 }
 
@@ -1080,8 +1163,14 @@ copy_reg (char const *src_name, char const *dst_name,
       goto close_src_and_dst_desc;
     }
 
-  /* --attributes-only overrides --reflink.  */
-  if (data_copy_required && x->reflink_mode)
+  /* --attributes-only overrides --reflink.  With --reflink=auto, try
+     to clone only a nonempty file to a regular file, as other clones
+     are useless, so that the attempt costs at most one ioctl per file
+     on file systems that do not support it.  */
+  if (data_copy_required
+      && (x->reflink_mode == REFLINK_ALWAYS
+          || (x->reflink_mode == REFLINK_AUTO
+              && S_ISREG (sb.st_mode) && 0 < src_open_sb.st_size)))
     {
       bool clone_ok = clone_file (dest_desc, source_desc) == 0;
       if (clone_ok || x->reflink_mode == REFLINK_ALWAYS)
@@ -1293,6 +1382,632 @@ close_src_desc:
   return return_val;
 }
 
+
+/* A regular file queued to be copied by copy_reg, with cp --parallel.
+   The members are copy_reg's arguments.  */
+struct copy_job
+{
+  struct copy_job *next;
+  char *src_name;
+  char *dst_name;
+  struct cp_options const *x;
+  mode_t dst_mode;
+  mode_t omitted_permissions;
+  bool new_dst;
+  struct stat src_sb;
+
+  /* Whether to forget the source dev/ino if the copy fails, as
+     copy_internal does when it has just remembered them.  */
+  bool forget;
+
+  struct copy_group *group;
+};
+
+/* The most threads to copy with, and the most jobs to queue per
+   thread, beyond which the main thread runs a job itself before
+   queuing another.  */
+enum { COPY_THREADS_MAX = 256, COPY_QUEUE_PER_THREAD = 64 };
+
+/* The jobs not yet started, in the order queued, their number, and the
+   number of jobs not yet finished.  These and the members of each
+   group are protected by JOB_LOCK.  */
+static struct copy_job *job_head;
+static struct copy_job **job_tail = &job_head;
+static size_t jobs_queued;
+static size_t jobs_unfinished;
+static pthread_mutex_t job_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t job_queued = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t job_finished = PTHREAD_COND_INITIALIZER;
+
+/* Whether the threads have been started.  */
+static bool workers_started;
+
+/* Remove the job at the head of the queue and return it, or return
+   NULL if the queue is empty.  JOB_LOCK must be held.  */
+static struct copy_job *
+dequeue_job (void)
+{
+  struct copy_job *job = job_head;
+  if (job)
+    {
+      job_head = job->next;
+      if (! job_head)
+        job_tail = &job_head;
+      jobs_queued--;
+    }
+  return job;
+}
+
+/* Record in its group that JOB finished, successfully if OK, and
+   free JOB.  */
+static void
+finish_job (struct copy_job *job, bool ok)
+{
+  if (! ok && job->forget)
+    forget_created (job->src_sb.st_ino, job->src_sb.st_dev);
+
+  pthread_mutex_lock (&job_lock);
+  job->group->ok &= ok;
+  job->group->pending--;
+  jobs_unfinished--;
+  pthread_cond_broadcast (&job_finished);
+  pthread_mutex_unlock (&job_lock);
+
+  free (job->src_name);
+  free (job->dst_name);
+  free (job);
+}
+
+/* Copy the file of JOB, record the result in its group, and free JOB.  */
+static void
+run_job (struct copy_job *job)
+{
+  finish_job (job, copy_reg (job->src_name, job->dst_name, job->x,
+                             job->dst_mode, job->omitted_permissions,
+                             &job->new_dst, &job->src_sb));
+}
+
+/* Run queued jobs forever.  */
+static void *
+job_thread (void *arg _GL_UNUSED)
+{
+  while (true)
+    {
+      struct copy_job *job;
+
+      pthread_mutex_lock (&job_lock);
+      while (! (job = dequeue_job ()))
+        pthread_cond_wait (&job_queued, &job_lock);
+      pthread_mutex_unlock (&job_lock);
+
+      run_job (job);
+    }
+  return NULL;
+}
+
+/* Start the threads that run jobs, besides the main thread, which runs
+   them while waiting for them to finish.  Starting fewer, or none, is
+   not an error.  */
+static void
+start_workers (size_t nthreads)
+{
+  size_t i;
+
+  /* Compute what copy_reg caches, before threads can race to.  */
+  cached_umask ();
+  write_zeros (-1, 0);
+
+  for (i = 1; i < nthreads; i++)
+    {
+      pthread_t thread;
+      if (pthread_create (&thread, NULL, job_thread, NULL) != 0)
+        break;
+      pthread_detach (thread);
+    }
+  workers_started = true;
+}
+
+#if USE_IO_URING
+
+/* With io_uring, the most files to copy at once, the most bytes in
+   each, and the number of files whose operations to prepare before
+   submitting them.  */
+enum { URING_FILES = 32, URING_SIZE_MAX = 64 * 1024, URING_BATCH = 8 };
+
+/* The operations that copy a file with io_uring, in the order they
+   are submitted.  The source is opened beforehand, as copy_reg opens
+   it, so that it can be checked to be the file that was stat'ed.  The
+   destination is opened in the ring, and the read is linked to that,
+   so that it runs only if the open succeeded; if a clone is to be
+   tried, the read is submitted only once the clone has failed.  Once
+   the read has completed, the write and the closes are submitted
+   together, linked so that the closes run even if the write fails.  */
+enum uring_op
+{
+  URING_OPEN_DST,
+  URING_READ,
+  URING_WRITE,
+  URING_CLOSE_SRC,
+  URING_CLOSE_DST,
+  URING_OPS
+};
+
+/* A file being copied with io_uring.  */
+struct uring_file
+{
+  /* The job, or NULL if this entry is free.  */
+  struct copy_job *job;
+
+  /* The data of the file, with room for one more byte, so that a file
+     that has grown since it was stat'ed is noticed.  */
+  char *buf;
+
+  /* The source file descriptor.  The destination's is the result of
+     URING_OPEN_DST.  */
+  int src_fd;
+
+  /* The results of the operations, the number of operations submitted
+     whose results are not known yet, and whether the read and the
+     write have been submitted.  */
+  int res[URING_OPS];
+  int outstanding;
+  bool reading;
+  bool writing;
+};
+
+static struct uring_file uring_files[URING_FILES];
+
+/* The number of entries in URING_FILES in use.  */
+static size_t uring_in_flight;
+
+/* The ring's file descriptor, or -1 if it is not set up, and whether
+   setting it up failed.  */
+static int uring_fd = -1;
+static bool uring_failed;
+
+/* The submission queue: its head and tail as shared with the kernel,
+   the tail as far as entries have been prepared, its mask, and its
+   entries.  */
+static unsigned *uring_sq_head;
+static unsigned *uring_sq_tail;
+static unsigned uring_sq_next;
+static unsigned uring_sq_mask;
+static struct io_uring_sqe *uring_sqes;
+
+/* The completion queue: its head, tail, mask and entries.  */
+static unsigned *uring_cq_head;
+static unsigned *uring_cq_tail;
+static unsigned uring_cq_mask;
+static struct io_uring_cqe *uring_cqes;
+
+/* Set up the ring.  Return false, without diagnosing, if the kernel
+   cannot do so, or is too old to open and close files in it.  */
+static bool
+uring_setup (void)
+{
+  struct io_uring_params p;
+  size_t ring_size;
+  size_t sqes_size;
+  char *ring;
+  void *sqes;
+  unsigned i;
+  int fd;
+
+  memset (&p, 0, sizeof p);
+  fd = syscall (SYS_io_uring_setup, 4 * URING_FILES, &p);
+  if (fd < 0)
+    return false;
+  if (! (p.features & IORING_FEAT_SINGLE_MMAP)
+      || ! (p.features & IORING_FEAT_RW_CUR_POS))
+    goto fail;
+
+  ring_size = MAX (p.sq_off.array + p.sq_entries * sizeof (unsigned),
+                   p.cq_off.cqes + p.cq_entries * sizeof *uring_cqes);
+  ring = mmap (NULL, ring_size, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (ring == MAP_FAILED)
+    goto fail;
+  sqes_size = p.sq_entries * sizeof *uring_sqes;
+  sqes = mmap (NULL, sqes_size, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED)
+    {
+      munmap (ring, ring_size);
+      goto fail;
+    }
+
+  uring_sq_head = (unsigned *) (ring + p.sq_off.head);
+  uring_sq_tail = (unsigned *) (ring + p.sq_off.tail);
+  uring_sq_next = *uring_sq_tail;
+  uring_sq_mask = *(unsigned *) (ring + p.sq_off.ring_mask);
+  for (i = 0; i < p.sq_entries; i++)
+    ((unsigned *) (ring + p.sq_off.array))[i] = i;
+  uring_sqes = sqes;
+  uring_cq_head = (unsigned *) (ring + p.cq_off.head);
+  uring_cq_tail = (unsigned *) (ring + p.cq_off.tail);
+  uring_cq_mask = *(unsigned *) (ring + p.cq_off.ring_mask);
+  uring_cqes = (struct io_uring_cqe *) (ring + p.cq_off.cqes);
+
+  for (i = 0; i < URING_FILES; i++)
+    uring_files[i].buf = xmalloc (URING_SIZE_MAX + 1);
+  uring_fd = fd;
+  return true;
+
+ fail:
+  close (fd);
+  return false;
+}
+
+/* Return true if X asks to copy with io_uring and the kernel can.  */
+static bool
+uring_available (struct cp_options const *x)
+{
+  if (! x->io_uring || uring_failed)
+    return false;
+  if (uring_fd < 0)
+    uring_failed = ! uring_setup ();
+  return ! uring_failed;
+}
+
+/* Return true if the file with status SRC_SB can be copied with
+   io_uring to a new file, as copy_reg (..., X, ..., OMITTED_PERMISSIONS,
+   &NEW_DST, SRC_SB) would copy it, because it is small and nothing but
+   its data is to be copied.  Empty files are left to copy_reg, as
+   files in /proc that are empty by their size may not be.  */
+static bool
+uring_copy_ok (struct cp_options const *x, mode_t omitted_permissions,
+               bool new_dst, struct stat const *src_sb)
+{
+  return (new_dst && ! omitted_permissions
+          && S_ISREG (src_sb->st_mode)
+          && 0 < src_sb->st_size && src_sb->st_size <= URING_SIZE_MAX
+          && x->data_copy_required
+          && x->reflink_mode != REFLINK_ALWAYS
+          && (x->sparse_mode == SPARSE_NEVER
+              || (x->sparse_mode == SPARSE_AUTO
+                  && ! is_probably_sparse (src_sb)))
+          && ! (x->move_mode || x->preserve_timestamps
+                || x->preserve_ownership || x->preserve_mode
+                || x->preserve_xattr || x->set_mode
+                || x->explicit_no_preserve_mode
+                || x->set_security_context || x->preserve_security_context)
+          && x->nthreads <= 1
+          && uring_available (x));
+}
+
+/* Return a cleared submission queue entry for operation OP of F, with
+   opcode OPCODE and flags FLAGS.  */
+static struct io_uring_sqe *
+uring_sqe (struct uring_file *f, enum uring_op op,
+           unsigned char opcode, unsigned char flags)
+{
+  struct io_uring_sqe *sqe = &uring_sqes[uring_sq_next++ & uring_sq_mask];
+  memset (sqe, 0, sizeof *sqe);
+  sqe->opcode = opcode;
+  sqe->flags = flags;
+  sqe->user_data = (f - uring_files) * URING_OPS + op;
+  f->outstanding++;
+  return sqe;
+}
+
+/* Submit the prepared operations.  If WAIT, also wait until at least
+   one operation has completed.  */
+static void
+uring_enter (bool wait)
+{
+  __atomic_store_n (uring_sq_tail, uring_sq_next, __ATOMIC_RELEASE);
+
+  while (true)
+    {
+      unsigned to_submit =
+        uring_sq_next - __atomic_load_n (uring_sq_head, __ATOMIC_ACQUIRE);
+      if (! to_submit
+          && (! wait
+              || (*uring_cq_head
+                  != __atomic_load_n (uring_cq_tail, __ATOMIC_ACQUIRE))))
+        break;
+      if (syscall (SYS_io_uring_enter, uring_fd, to_submit, wait,
+                   wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0) < 0
+          && ! (errno == EINTR || errno == EAGAIN || errno == EBUSY))
+        error (EXIT_FAILURE, errno, _("cannot submit I/O to io_uring"));
+    }
+}
+
+/* Close whatever F's copy left open, remove any destination it
+   created, and copy the file with copy_reg instead, which diagnoses
+   any failure.  Return true if successful.  */
+static bool
+uring_fall_back (struct uring_file *f)
+{
+  struct copy_job *job = f->job;
+
+  if (! f->writing)
+    {
+      close (f->src_fd);
+      if (0 <= f->res[URING_OPEN_DST])
+        close (f->res[URING_OPEN_DST]);
+    }
+  if (0 <= f->res[URING_OPEN_DST])
+    ignore_value (unlink (job->dst_name));
+
+  return copy_reg (job->src_name, job->dst_name, job->x, job->dst_mode,
+                   job->omitted_permissions, &job->new_dst, &job->src_sb);
+}
+
+/* Try to clone the source of F to its destination, which is open,
+   as copy_reg does with --reflink=auto.  If the clone succeeds, close
+   both files and return true, setting *OK to whether that succeeded.
+   Otherwise, return false.  */
+static bool
+uring_clone (struct uring_file *f, bool *ok)
+{
+  struct copy_job *job = f->job;
+  int dst_fd = f->res[URING_OPEN_DST];
+
+  if (clone_file (dst_fd, f->src_fd) != 0)
+    return false;
+
+  *ok = true;
+  if (close (dst_fd) < 0)
+    {
+      error (0, errno, _("failed to close %s"), quote (job->dst_name));
+      *ok = false;
+    }
+  if (close (f->src_fd) < 0)
+    {
+      error (0, errno, _("failed to close %s"), quote (job->src_name));
+      *ok = false;
+    }
+  return true;
+}
+
+/* Act on the results of the operations of F, all of which have
+   completed: after the destination is opened, try a clone if one is
+   wanted, and failing that submit the read; after the read, submit the
+   write and the closes; and after those, finish F's job.  */
+static void
+uring_advance (struct uring_file *f)
+{
+  struct copy_job *job = f->job;
+  int size = job->src_sb.st_size;
+  int dst_fd = f->res[URING_OPEN_DST];
+  struct io_uring_sqe *sqe;
+  bool ok;
+
+  if (! f->writing)
+    {
+      if (0 <= dst_fd && ! f->reading)
+        {
+          if (uring_clone (f, &ok))
+            goto finish;
+          sqe = uring_sqe (f, URING_READ, IORING_OP_READ, 0);
+          sqe->fd = f->src_fd;
+          sqe->addr = (uintptr_t) f->buf;
+          sqe->len = size + 1;
+          f->reading = true;
+          return;
+        }
+      if (0 <= dst_fd && f->res[URING_READ] == size)
+        {
+          sqe = uring_sqe (f, URING_WRITE, IORING_OP_WRITE,
+                           IOSQE_IO_HARDLINK);
+          sqe->fd = dst_fd;
+          sqe->addr = (uintptr_t) f->buf;
+          sqe->len = size;
+          sqe = uring_sqe (f, URING_CLOSE_SRC, IORING_OP_CLOSE,
+                           IOSQE_IO_HARDLINK);
+          sqe->fd = f->src_fd;
+          sqe = uring_sqe (f, URING_CLOSE_DST, IORING_OP_CLOSE, 0);
+          sqe->fd = dst_fd;
+          f->writing = true;
+          return;
+        }
+      ok = uring_fall_back (f);
+    }
+  else
+    ok = ((f->res[URING_WRITE] == size && f->res[URING_CLOSE_SRC] == 0
+           && f->res[URING_CLOSE_DST] == 0)
+          || uring_fall_back (f));
+
+ finish:
+  f->job = NULL;
+  uring_in_flight--;
+  finish_job (job, ok);
+}
+
+/* Submit the prepared operations and act on those that have completed.
+   If WAIT, first wait until at least one has.  */
+static void
+uring_reap (bool wait)
+{
+  unsigned head;
+
+  uring_enter (wait);
+  for (head = *uring_cq_head;
+       head != __atomic_load_n (uring_cq_tail, __ATOMIC_ACQUIRE);
+       head++)
+    {
+      struct io_uring_cqe const *cqe = &uring_cqes[head & uring_cq_mask];
+      struct uring_file *f = &uring_files[cqe->user_data / URING_OPS];
+      f->res[cqe->user_data % URING_OPS] = cqe->res;
+      __atomic_store_n (uring_cq_head, head + 1, __ATOMIC_RELEASE);
+      if (--f->outstanding == 0)
+        uring_advance (f);
+    }
+}
+
+/* Start copying the file of JOB with io_uring, first waiting for a
+   file being copied to finish if too many are.  As in copy_reg, fail
+   if the source cannot be opened, or is not the file that was
+   stat'ed.  */
+static void
+uring_queue (struct copy_job *job)
+{
+  struct cp_options const *x = job->x;
+  struct uring_file *f;
+  struct io_uring_sqe *sqe;
+  struct stat src_open_sb;
+  bool try_clone = x->reflink_mode == REFLINK_AUTO;
+  int src_fd;
+  int i;
+
+  src_fd = open (job->src_name,
+                 (O_RDONLY | O_BINARY
+                  | (x->dereference == DEREF_NEVER ? O_NOFOLLOW : 0)));
+  if (src_fd < 0)
+    {
+      error (0, errno, _("cannot open %s for reading"),
+             quote (job->src_name));
+      finish_job (job, false);
+      return;
+    }
+  if (fstat (src_fd, &src_open_sb) != 0)
+    {
+      error (0, errno, _("cannot fstat %s"), quote (job->src_name));
+      close (src_fd);
+      finish_job (job, false);
+      return;
+    }
+  if (! SAME_INODE (job->src_sb, src_open_sb))
+    {
+      error (0, 0,
+             _("skipping file %s, as it was replaced while being copied"),
+             quote (job->src_name));
+      close (src_fd);
+      finish_job (job, false);
+      return;
+    }
+
+  while (uring_in_flight == URING_FILES)
+    uring_reap (true);
+  for (i = 0; uring_files[i].job; i++)
+    continue;
+  f = &uring_files[i];
+  f->job = job;
+  f->src_fd = src_fd;
+  f->reading = ! try_clone;
+  f->writing = false;
+  uring_in_flight++;
+
+  sqe = uring_sqe (f, URING_OPEN_DST, IORING_OP_OPENAT,
+                   try_clone ? 0 : IOSQE_IO_LINK);
+  sqe->fd = AT_FDCWD;
+  sqe->addr = (uintptr_t) job->dst_name;
+  sqe->len = job->dst_mode;
+  sqe->open_flags = O_WRONLY | O_CREAT | O_EXCL | O_BINARY;
+  if (! try_clone)
+    {
+      sqe = uring_sqe (f, URING_READ, IORING_OP_READ, 0);
+      sqe->fd = src_fd;
+      sqe->addr = (uintptr_t) f->buf;
+      sqe->len = job->src_sb.st_size + 1;
+    }
+
+  if ((URING_READ + 1) * URING_BATCH <= uring_sq_next - *uring_sq_tail)
+    uring_reap (false);
+}
+
+#else
+
+static bool
+uring_copy_ok (struct cp_options const *x _GL_UNUSED,
+               mode_t omitted_permissions _GL_UNUSED,
+               bool new_dst _GL_UNUSED, struct stat const *src_sb _GL_UNUSED)
+{
+  return false;
+}
+
+#endif
+
+/* Queue a job to copy SRC_NAME to DST_NAME in the current group, as
+   copy_reg (SRC_NAME, DST_NAME, X, DST_MODE, OMITTED_PERMISSIONS,
+   &NEW_DST, SRC_SB) would.  FORGET is as for struct copy_job.  With
+   --parallel, run the job in a thread, first running the job at the
+   head of the queue if it is full.  Otherwise, uring_copy_ok must
+   have said the file can be copied with io_uring.  */
+static void
+queue_copy_reg (char const *src_name, char const *dst_name,
+                const struct cp_options *x,
+                mode_t dst_mode, mode_t omitted_permissions, bool new_dst,
+                struct stat const *src_sb, bool forget)
+{
+  size_t nthreads = MIN (x->nthreads, COPY_THREADS_MAX);
+  struct copy_job *job = xmalloc (sizeof *job);
+  struct copy_job *own_job;
+
+  job->next = NULL;
+  job->src_name = xstrdup (src_name);
+  job->dst_name = xstrdup (dst_name);
+  job->x = x;
+  job->dst_mode = dst_mode;
+  job->omitted_permissions = omitted_permissions;
+  job->new_dst = new_dst;
+  job->src_sb = *src_sb;
+  job->forget = forget;
+  job->group = current_group;
+
+  if (nthreads <= 1)
+    {
+      pthread_mutex_lock (&job_lock);
+      jobs_unfinished++;
+      job->group->pending++;
+      pthread_mutex_unlock (&job_lock);
+#if USE_IO_URING
+      uring_queue (job);
+#else
+      abort ();
+#endif
+      return;
+    }
+
+  if (! workers_started)
+    start_workers (nthreads);
+
+  pthread_mutex_lock (&job_lock);
+  own_job = (COPY_QUEUE_PER_THREAD * nthreads <= jobs_queued
+             ? dequeue_job () : NULL);
+  *job_tail = job;
+  job_tail = &job->next;
+  jobs_queued++;
+  jobs_unfinished++;
+  job->group->pending++;
+  pthread_cond_signal (&job_queued);
+  pthread_mutex_unlock (&job_lock);
+
+  if (own_job)
+    run_job (own_job);
+}
+
+/* Run queued jobs, and complete the copies in progress with io_uring,
+   until *PENDING, which is either the number of unfinished jobs in a
+   group or in all, becomes zero.  */
+static void
+wait_for_jobs (size_t const *pending)
+{
+  pthread_mutex_lock (&job_lock);
+  while (*pending)
+    {
+      struct copy_job *job = dequeue_job ();
+      if (job)
+        {
+          pthread_mutex_unlock (&job_lock);
+          run_job (job);
+          pthread_mutex_lock (&job_lock);
+        }
+#if USE_IO_URING
+      else if (uring_in_flight)
+        {
+          pthread_mutex_unlock (&job_lock);
+          uring_reap (true);
+          pthread_mutex_lock (&job_lock);
+        }
+#endif
+      else
+        pthread_cond_wait (&job_finished, &job_lock);
+    }
+  pthread_mutex_unlock (&job_lock);
+}
+
 /* Return true if it's ok that the source and destination
    files are the 'same' by some measure.  The goal is to avoid
    making the 'copy' operation remove both copies of the file
@@ -2167,6 +2882,14 @@ copy_internal (char const *src_name, char const *dst_name,
         earlier_file = src_to_dest_lookup (src_sb.st_ino, src_sb.st_dev);
     }
 
+  /* With --parallel, the file first copied to EARLIER_FILE may still be
+     being copied, or may fail to be and then be forgotten.  */
+  if (earlier_file && ! S_ISDIR (src_mode) && current_group)
+    {
+      wait_for_jobs (&jobs_unfinished);
+      earlier_file = remember_copied (dst_name, src_sb.st_ino, src_sb.st_dev);
+    }
+
   /* Did we copy this inode somewhere else (in this command line argument)
      and therefore this is a second hard link to the inode?  */
 
@@ -2519,9 +3242,22 @@ copy_internal (char const *src_name, char const *dst_name,
          This call uses DST_MODE_BITS, not SRC_MODE.  These are
          normally the same, and the exception (where x->set_mode) is
          used only by 'install', which POSIX does not specify and
-         where DST_MODE_BITS is what's wanted.  */
-      if (! copy_reg (src_name, dst_name, x, dst_mode_bits & S_IRWXUGO,
-                      omitted_permissions, &new_dst, &src_sb))
+         where DST_MODE_BITS is what's wanted.
+
+         With --parallel, copy the file in a thread, unless a backup
+         may need to be restored, or a security context set, which is
+         specific to this thread.  Otherwise, copy a small file with
+         io_uring if possible, in a batch with the other files in its
+         directory.  */
+      if (current_group && ! dst_backup
+          && (1 < x->nthreads
+              ? ! x->set_security_context && ! x->preserve_security_context
+              : uring_copy_ok (x, omitted_permissions, new_dst, &src_sb)))
+        queue_copy_reg (src_name, dst_name, x, dst_mode_bits & S_IRWXUGO,
+                        omitted_permissions, new_dst, &src_sb,
+                        earlier_file == NULL);
+      else if (! copy_reg (src_name, dst_name, x, dst_mode_bits & S_IRWXUGO,
+                           omitted_permissions, &new_dst, &src_sb))
         goto un_backup;
     }
   else if (S_ISFIFO (src_mode))
@@ -249,6 +249,16 @@ struct cp_options
   /* Control creation of COW files.  */
   enum Reflink_type reflink_mode;
 
+  /* The number of threads with which to copy the regular files found
+     in directories when copying recursively, or 0 or 1 to copy them
+     one at a time.  */
+  size_t nthreads;
+
+  /* If true, and the kernel supports io_uring, copy the small regular
+     files found in directories in batches, when nothing but their data
+     is to be copied and they are copied one at a time.  */
+  bool io_uring;
+
   /* This is a set of destination name/inode/dev triples.  Each such triple
      represents a file we have created corresponding to a source file name
      that was specified on the command line.  Use it to avoid clobbering
@@ -0,0 +1,120 @@
+/* Count the newlines in a buffer, with kernels selected at run time.
+   Copyright (C) 2014 Free Software Foundation, Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/* Include this file _after_ system.h.  */
+
+/* Whether to use the SSE2 and, if the processor supports it, the AVX2
+   kernels.  SSE2 is always available on x86-64; AVX2 code is compiled
+   with a target attribute and selected at run time.  */
+#if (defined __x86_64__ \
+     && (4 < __GNUC__ + (9 <= __GNUC_MINOR__) || defined __clang__))
+# define COUNT_NEWLINES_X86_SIMD 1
+# include <immintrin.h>
+#else
+# define COUNT_NEWLINES_X86_SIMD 0
+#endif
+
+/* Return the number of newlines in the N bytes at P.  */
+
+static size_t
+count_newlines_generic (char const *p, size_t n)
+{
+  char const *lim = p + n;
+  size_t lines = 0;
+
+  while ((p = memchr (p, '\n', lim - p)))
+    {
+      ++p;
+      ++lines;
+    }
+  return lines;
+}
+
+#if COUNT_NEWLINES_X86_SIMD
+static size_t
+count_newlines_sse2 (char const *p, size_t n)
+{
+  __m128i const newline = _mm_set1_epi8 ('\n');
+  __m128i const zero = _mm_setzero_si128 ();
+  size_t lines = 0;
+  size_t i = 0;
+
+  while (16 <= n - i)
+    {
+      /* Each byte of ACC counts the newlines in one column of up to
+         255 blocks, and is then summed by _mm_sad_epu8.  */
+      size_t nblocks = MIN ((n - i) / 16, 255);
+      __m128i acc = zero;
+      __m128i sums;
+
+      for (; nblocks; nblocks--, i += 16)
+        {
+          __m128i v = _mm_loadu_si128 ((__m128i const *) (p + i));
+          acc = _mm_sub_epi8 (acc, _mm_cmpeq_epi8 (v, newline));
+        }
+      sums = _mm_sad_epu8 (acc, zero);
+      lines += _mm_extract_epi16 (sums, 0) + _mm_extract_epi16 (sums, 4);
+    }
+
+  return lines + count_newlines_generic (p + i, n - i);
+}
+
+static size_t __attribute__ ((__target__ ("avx2")))
+count_newlines_avx2 (char const *p, size_t n)
+{
+  __m256i const newline = _mm256_set1_epi8 ('\n');
+  __m256i const zero = _mm256_setzero_si256 ();
+  size_t lines = 0;
+  size_t i = 0;
+
+  while (32 <= n - i)
+    {
+      size_t nblocks = MIN ((n - i) / 32, 255);
+      __m256i acc = zero;
+      __m256i sums;
+
+      for (; nblocks; nblocks--, i += 32)
+        {
+          __m256i v = _mm256_loadu_si256 ((__m256i const *) (p + i));
+          acc = _mm256_sub_epi8 (acc, _mm256_cmpeq_epi8 (v, newline));
+        }
+      sums = _mm256_sad_epu8 (acc, zero);
+      lines += (_mm256_extract_epi64 (sums, 0) + _mm256_extract_epi64 (sums, 1)
+                + _mm256_extract_epi64 (sums, 2)
+                + _mm256_extract_epi64 (sums, 3));
+    }
+
+  return lines + count_newlines_generic (p + i, n - i);
+}
+#endif
+
+/* The newline counting kernel for this processor.  */
+static size_t (*count_newlines) (char const *, size_t)
+  = count_newlines_generic;
+
+/* Select the newline counting kernel.  */
+
+static void
+init_count_newlines (void)
+{
+#if COUNT_NEWLINES_X86_SIMD
+  __builtin_cpu_init ();
+  if (__builtin_cpu_supports ("avx2"))
+    count_newlines = count_newlines_avx2;
+  else
+    count_newlines = count_newlines_sse2;
+#endif
+}
@@ -20,6 +20,7 @@
 #include <config.h>
 
 #include <sys/types.h>
+#include <pthread.h>
 #include "system.h"
 
 #include "hash.h"
@@ -41,8 +42,11 @@ struct Src_to_dest
 };
 
 /* This table maps source dev/ino to destination file name.
-   We use it to preserve hard links when copying.  */
+   We use it to preserve hard links when copying.  It is protected by
+   SRC_TO_DEST_LOCK, as the threads of cp --parallel forget the files
+   they fail to copy.  */
 static Hash_table *src_to_dest;
+static pthread_mutex_t src_to_dest_lock = PTHREAD_MUTEX_INITIALIZER;
 
 /* Initial size of the above hash table.  */
 #define INITIAL_TABLE_SIZE 103
@@ -88,13 +92,16 @@ forget_created (ino_t ino, dev_t dev)
   probe.st_dev = dev;
   probe.name = NULL;
 
+  pthread_mutex_lock (&src_to_dest_lock);
   ent = hash_delete (src_to_dest, &probe);
+  pthread_mutex_unlock (&src_to_dest_lock);
   if (ent)
     src_to_dest_free (ent);
 }
 
 /* If INO/DEV correspond to an already-copied source file, return the
-   name of the corresponding destination file.  Otherwise, return NULL.  */
+   name of the corresponding destination file.  Otherwise, return NULL.
+   The name is valid until the entry is forgotten.  */
 
 extern char *
 src_to_dest_lookup (ino_t ino, dev_t dev)
@@ -103,7 +110,9 @@ src_to_dest_lookup (ino_t ino, dev_t dev)
   struct Src_to_dest const *e;
   ent.st_ino = ino;
   ent.st_dev = dev;
+  pthread_mutex_lock (&src_to_dest_lock);
   e = hash_lookup (src_to_dest, &ent);
+  pthread_mutex_unlock (&src_to_dest_lock);
   return e ? e->name : NULL;
 }
 
@@ -122,7 +131,9 @@ remember_copied (const char *name, ino_t ino, dev_t dev)
   ent->st_ino = ino;
   ent->st_dev = dev;
 
+  pthread_mutex_lock (&src_to_dest_lock);
   ent_from_table = hash_insert (src_to_dest, ent);
+  pthread_mutex_unlock (&src_to_dest_lock);
   if (ent_from_table == NULL)
     {
       /* Insertion failed due to lack of memory.  */
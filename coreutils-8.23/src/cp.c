@@ -34,6 +34,7 @@
 #include "stat-time.h"
 #include "utimens.h"
 #include "acl.h"
+#include "xstrtol.h"
 
 #if ! HAVE_LCHOWN
 # define lchown(name, uid, gid) chown (name, uid, gid)
@@ -74,7 +75,9 @@ enum
 {
   ATTRIBUTES_ONLY_OPTION = CHAR_MAX + 1,
   COPY_CONTENTS_OPTION,
+  DISABLE_IO_URING_OPTION,
   NO_PRESERVE_ATTRIBUTES_OPTION,
+  PARALLEL_OPTION,
   PARENTS_OPTION,
   PRESERVE_ATTRIBUTES_OPTION,
   REFLINK_OPTION,
@@ -105,11 +108,11 @@ ARGMATCH_VERIFY (sparse_type_string, sparse_type);
 
 static char const *const reflink_type_string[] =
 {
-  "auto", "always", NULL
+  "auto", "always", "never", NULL
 };
 static enum Reflink_type const reflink_type[] =
 {
-  REFLINK_AUTO, REFLINK_ALWAYS
+  REFLINK_AUTO, REFLINK_ALWAYS, REFLINK_NEVER
 };
 ARGMATCH_VERIFY (reflink_type_string, reflink_type);
 
@@ -119,6 +122,8 @@ static struct option const long_opts[] =
   {"attributes-only", no_argument, NULL, ATTRIBUTES_ONLY_OPTION},
   {"backup", optional_argument, NULL, 'b'},
   {"copy-contents", no_argument, NULL, COPY_CONTENTS_OPTION},
+  {"-disable-io-uring", no_argument, NULL,
+   DISABLE_IO_URING_OPTION}, /* do not document */
   {"dereference", no_argument, NULL, 'L'},
   {"force", no_argument, NULL, 'f'},
   {"interactive", no_argument, NULL, 'i'},
@@ -128,6 +133,7 @@ static struct option const long_opts[] =
   {"no-preserve", required_argument, NULL, NO_PRESERVE_ATTRIBUTES_OPTION},
   {"no-target-directory", no_argument, NULL, 'T'},
   {"one-file-system", no_argument, NULL, 'x'},
+  {"parallel", required_argument, NULL, PARALLEL_OPTION},
   {"parents", no_argument, NULL, PARENTS_OPTION},
   {"path", no_argument, NULL, PARENTS_OPTION},   /* Deprecated.  */
   {"preserve", optional_argument, NULL, PRESERVE_ATTRIBUTES_OPTION},
@@ -203,6 +209,7 @@ Copy SOURCE to DEST, or multiple SOURCE(s) to DIRECTORY.\n\
 "), stdout);
       fputs (_("\
       --no-preserve=ATTR_LIST  don't preserve the specified attributes\n\
+      --parallel=N             with -R, copy up to N files at once\n\
       --parents                use full source file name under DIRECTORY\n\
 "), stdout);
       fputs (_("\
@@ -248,6 +255,8 @@ Use --sparse=never to inhibit creation of sparse files.\n\
 When --reflink[=always] is specified, perform a lightweight copy, where the\n\
 data blocks are copied only when modified.  If this is not possible the copy\n\
 fails, or if --reflink=auto is specified, fall back to a standard copy.\n\
+That is the default unless --sparse=always or --sparse=never is specified.\n\
+Use --reflink=never to ensure a standard copy is performed.\n\
 "), stdout);
       fputs (_("\
 \n\
@@ -782,7 +791,9 @@ cp_option_init (struct cp_options *x)
   x->interactive = I_UNSPECIFIED;
   x->move_mode = false;
   x->one_file_system = false;
-  x->reflink_mode = REFLINK_NEVER;
+  x->reflink_mode = REFLINK_AUTO;
+  x->nthreads = 1;
+  x->io_uring = true;
 
   x->preserve_ownership = false;
   x->preserve_links = false;
@@ -924,6 +935,7 @@ main (int argc, char **argv)
   char *version_control_string = NULL;
   struct cp_options x;
   bool copy_contents = false;
+  bool reflink_given = false;
   char *target_directory = NULL;
   bool no_target_directory = false;
   char const *scontext = NULL;
@@ -955,6 +967,7 @@ main (int argc, char **argv)
           break;
 
         case REFLINK_OPTION:
+          reflink_given = true;
           if (optarg == NULL)
             x.reflink_mode = REFLINK_ALWAYS;
           else
@@ -991,6 +1004,10 @@ main (int argc, char **argv)
           copy_contents = true;
           break;
 
+        case DISABLE_IO_URING_OPTION:
+          x.io_uring = false;
+          break;
+
         case 'd':
           x.preserve_links = true;
           x.dereference = DEREF_NEVER;
@@ -1047,6 +1064,20 @@ main (int argc, char **argv)
           x.require_preserve = true;
           break;
 
+        case PARALLEL_OPTION:
+          {
+            unsigned long int n;
+            enum strtol_error e = xstrtoul (optarg, NULL, 10, &n, "");
+            if (e == LONGINT_OVERFLOW || SIZE_MAX < n)
+              x.nthreads = SIZE_MAX;
+            else if (e != LONGINT_OK || n == 0)
+              error (EXIT_FAILURE, 0, _("invalid number of threads: %s"),
+                     quote (optarg));
+            else
+              x.nthreads = n;
+          }
+          break;
+
         case PARENTS_OPTION:
           parents_option = true;
           break;
@@ -1151,6 +1182,11 @@ main (int argc, char **argv)
       usage (EXIT_FAILURE);
     }
 
+  /* A clone has only the holes of its source, so do not clone by
+     default when --sparse asks for other holes, or for none.  */
+  if (! reflink_given && x.sparse_mode != SPARSE_AUTO)
+    x.reflink_mode = REFLINK_NEVER;
+
   if (backup_suffix_string)
     simple_backup_suffix = xstrdup (backup_suffix_string);
 
@@ -26,13 +26,17 @@
 #include <config.h>
 #include <getopt.h>
 #include <sys/types.h>
+#include <sys/resource.h>
 #include <assert.h>
+#include <pthread.h>
 #include "system.h"
 #include "argmatch.h"
 #include "argv-iter.h"
+#include "dev-ino.h"
 #include "di-set.h"
 #include "error.h"
 #include "exclude.h"
+#include "filenamecat.h"
 #include "fprintftime.h"
 #include "human.h"
 #include "mountlist.h"
@@ -61,6 +65,14 @@ extern bool fts_debug;
 # define FTS_CROSS_CHECK(Fts)
 #endif
 
+/* Whether statx can be used to get only the status fields that du
+   needs, for the files in directories scanned by threads.  */
+#if defined STATX_INO && defined AT_NO_AUTOMOUNT
+# define USE_STATX 1
+#else
+# define USE_STATX 0
+#endif
+
 /* A set of dev/ino pairs to help identify files and directories
    whose sizes have already been counted.  */
 static struct di_set *di_files;
@@ -68,6 +80,10 @@ static struct di_set *di_files;
 /* A set containing a dev/ino pair for each local mount point directory.  */
 static struct di_set *di_mnt;
 
+/* Protect DI_FILES and DI_MNT, which threads also use with --parallel.
+   A lookup in a di_set modifies it too.  */
+static pthread_mutex_t di_lock = PTHREAD_MUTEX_INITIALIZER;
+
 /* Keep track of the preceding "level" (depth in hierarchy)
    from one call of process_file to the next.  */
 static size_t prev_level;
@@ -157,6 +173,13 @@ static size_t max_depth = SIZE_MAX;
    or at most if negative.  See --threshold option.  */
 static intmax_t opt_threshold = 0;
 
+/* The number of threads to scan directories with.  See --parallel.  */
+static size_t nthreads = 1;
+
+/* The level at and below which directories are handed off to threads.
+   No totals are printed for these, nor for anything under them.  */
+static size_t hand_off_level = SIZE_MAX;
+
 /* Human-readable options for output.  */
 static int human_output_opts;
 
@@ -207,7 +230,8 @@ enum
   FTS_DEBUG,
   TIME_OPTION,
   TIME_STYLE_OPTION,
-  INODES_OPTION
+  INODES_OPTION,
+  PARALLEL_OPTION
 };
 
 static struct option const long_options[] =
@@ -230,6 +254,7 @@ static struct option const long_options[] =
   {"null", no_argument, NULL, '0'},
   {"no-dereference", no_argument, NULL, 'P'},
   {"one-file-system", no_argument, NULL, 'x'},
+  {"parallel", required_argument, NULL, PARALLEL_OPTION},
   {"separate-dirs", no_argument, NULL, 'S'},
   {"summarize", no_argument, NULL, 's'},
   {"total", no_argument, NULL, 'c'},
@@ -327,6 +352,8 @@ Summarize disk usage of each FILE, recursively for directories.\n\
 "), stdout);
       fputs (_("\
   -P, --no-dereference  don't follow any symbolic links (this is the default)\n\
+      --parallel=N      scan directories whose totals are not printed in up\n\
+                          to N threads\n\
   -S, --separate-dirs   for directories do not include size of subdirectories\n\
       --si              like -h, but use powers of 1000 not 1024\n\
   -s, --summarize       display only a total for each argument\n\
@@ -362,12 +389,39 @@ Summarize disk usage of each FILE, recursively for directories.\n\
 static bool
 hash_ins (struct di_set *di_set, ino_t ino, dev_t dev)
 {
-  int inserted = di_set_insert (di_set, dev, ino);
+  int inserted;
+  pthread_mutex_lock (&di_lock);
+  inserted = di_set_insert (di_set, dev, ino);
+  pthread_mutex_unlock (&di_lock);
   if (inserted < 0)
     xalloc_die ();
   return inserted;
 }
 
+/* Return true if the INO/DEV pair is that of a local mount point.  */
+static bool
+mount_point (ino_t ino, dev_t dev)
+{
+  int found;
+  pthread_mutex_lock (&di_lock);
+  found = di_set_lookup (di_mnt, dev, ino);
+  pthread_mutex_unlock (&di_lock);
+  return found != 0;
+}
+
+/* Set *DUI to the size and time of the file whose status is *SB.  */
+static void
+stat_duinfo (struct duinfo *dui, struct stat const *sb)
+{
+  duinfo_set (dui,
+              (apparent_size
+               ? MAX (0, sb->st_size)
+               : (uintmax_t) ST_NBLOCKS (*sb) * ST_NBLOCKSIZE),
+              (time_type == time_mtime ? get_stat_mtime (sb)
+               : time_type == time_atime ? get_stat_atime (sb)
+               : get_stat_ctime (sb)));
+}
+
 /* FIXME: this code is nearly identical to code in date.c  */
 /* Display the date and time in WHEN according to the format specified
    in FORMAT.  */
@@ -419,6 +473,642 @@ print_size (const struct duinfo *pdui, const char *string)
   fflush (stdout);
 }
 
+/* A subdirectory listed by a thread, with its device and inode number.  */
+struct du_subdir
+{
+  char *name;
+  dev_t dev;
+  ino_t ino;
+};
+
+/* A directory whose total a thread computes.  With --parallel,
+   process_file hands off the directories at HAND_OFF_LEVEL to threads
+   instead of descending into them, and a thread hands off
+   subdirectories to other threads when some are idle.  A thread adds
+   up the sizes of the files in each directory it reads, and adds that
+   sum to the directory's total once.  The total of each directory is
+   added to its parent's, once the directories under it have been
+   counted too.  */
+struct du_dir
+{
+  /* The next directory in the queue of those not yet started, or in
+     the list of those handed off by process_file and finished.  */
+  struct du_dir *next;
+
+  /* The directory containing this one, or NULL if this one was handed
+     off by process_file.  */
+  struct du_dir *parent;
+
+  /* If PARENT is NULL, a descriptor for the directory containing this
+     one, the fts level of this one, and the devices and inode numbers
+     of the directories above it.  */
+  int parent_fd;
+  size_t level;
+  struct dev_ino *ancestors;
+  size_t n_ancestors;
+
+  /* The name of the directory relative to its parent, and its full
+     name for diagnostics and --exclude.  */
+  char *name;
+  char *path;
+
+  /* The device of the command line argument this directory is under,
+     and this directory's device and inode number.  */
+  dev_t root_dev;
+  dev_t dev;
+  ino_t ino;
+
+  /* The directory's stream and descriptor, or NULL and -1 if it is
+     not open.  Beyond DU_KEEP_FDS directories deep in a thread, a
+     directory is closed while the one below it is being scanned, and
+     then reopened via "..".  */
+  DIR *dirp;
+  int fd;
+  size_t depth;
+
+  /* The subdirectories, and the index of the next to scan.  */
+  struct du_subdir *subdirs;
+  size_t n_subdirs;
+  size_t next_subdir;
+
+  /* The number of subdirectories handed off to other threads and not
+     yet counted, plus one until this directory has been read and its
+     remaining subdirectories counted.  */
+  size_t refs;
+
+  /* The sizes of the files under this directory, not counting the
+     directory itself.  */
+  struct duinfo total;
+};
+
+/* The most threads to scan directories with, the most directories
+   deep that a thread keeps open, and the most directories from
+   process_file to queue per thread, beyond which process_file scans
+   the directory at the head of the queue itself before handing off
+   another.  */
+enum { DU_THREADS_MAX = 256, DU_KEEP_FDS = 16, DU_QUEUE_PER_THREAD = 4 };
+
+/* The directories not yet started, in the order queued, and their
+   number; the number of directories handed off by process_file and
+   not yet counted, and those counted; and whether everything in
+   threads succeeded.  These, and the REFS and TOTAL members of each
+   directory, are protected by DIR_LOCK.  */
+static struct du_dir *dir_head;
+static struct du_dir **dir_tail = &dir_head;
+static size_t dirs_queued;
+static size_t dirs_unfinished;
+static struct du_dir *dirs_finished;
+static bool dirs_ok = true;
+static pthread_mutex_t dir_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t dir_queued = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t dir_finished = PTHREAD_COND_INITIALIZER;
+
+/* The number of threads, including the main thread, or 0 if they
+   have not been started, and whether they skip files on other file
+   systems, as with --one-file-system.  */
+static size_t dir_threads;
+static bool dir_xdev;
+
+#if USE_STATX
+/* The status fields that the threads need, and whether statx works.  */
+static unsigned int statx_mask;
+static bool use_statx;
+#endif
+
+/* Remove the directory at the head of the queue and return it, or
+   return NULL if the queue is empty.  DIR_LOCK must be held.  */
+static struct du_dir *
+dequeue_dir (void)
+{
+  struct du_dir *dir = dir_head;
+  if (dir)
+    {
+      dir_head = dir->next;
+      if (! dir_head)
+        dir_tail = &dir_head;
+      dirs_queued--;
+    }
+  return dir;
+}
+
+/* Add DIR to the queue.  DIR_LOCK must be held.  */
+static void
+enqueue_dir (struct du_dir *dir)
+{
+  dir->next = NULL;
+  *dir_tail = dir;
+  dir_tail = &dir->next;
+  dirs_queued++;
+  pthread_cond_signal (&dir_queued);
+}
+
+/* Record that something failed in a thread.  */
+static void
+dir_failed (void)
+{
+  pthread_mutex_lock (&dir_lock);
+  dirs_ok = false;
+  pthread_mutex_unlock (&dir_lock);
+}
+
+/* Return a new directory in PARENT for SUBDIR, which is not yet open.
+   Take ownership of SUBDIR's name.  */
+static struct du_dir *
+new_dir (struct du_dir *parent, struct du_subdir const *subdir)
+{
+  struct du_dir *dir = xzalloc (sizeof *dir);
+  dir->parent = parent;
+  dir->parent_fd = -1;
+  dir->name = subdir->name;
+  dir->path = file_name_concat (parent->path, subdir->name, NULL);
+  dir->root_dev = parent->root_dev;
+  dir->dev = subdir->dev;
+  dir->ino = subdir->ino;
+  dir->fd = -1;
+  dir->refs = 1;
+  duinfo_init (&dir->total);
+  return dir;
+}
+
+/* Get the status of the file NAME in the directory FD into *ST,
+   without following symlinks.  With statx, get only the fields that
+   du uses, which may be much cheaper on network file systems; the
+   other members of *ST are then unset.  */
+static int
+stat_entry (int fd, char const *name, struct stat *st)
+{
+#if USE_STATX
+  if (use_statx)
+    {
+      struct statx stx;
+      if (statx (fd, name, AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT,
+                 statx_mask, &stx) != 0)
+        return -1;
+      st->st_mode = stx.stx_mode;
+      st->st_nlink = stx.stx_nlink;
+      st->st_ino = stx.stx_ino;
+      st->st_dev = makedev (stx.stx_dev_major, stx.stx_dev_minor);
+      st->st_size = stx.stx_size;
+      st->st_blocks = stx.stx_blocks;
+      st->st_atim.tv_sec = stx.stx_atime.tv_sec;
+      st->st_atim.tv_nsec = stx.stx_atime.tv_nsec;
+      st->st_mtim.tv_sec = stx.stx_mtime.tv_sec;
+      st->st_mtim.tv_nsec = stx.stx_mtime.tv_nsec;
+      st->st_ctim.tv_sec = stx.stx_ctime.tv_sec;
+      st->st_ctim.tv_nsec = stx.stx_ctime.tv_nsec;
+      return 0;
+    }
+#endif
+  return fstatat (fd, name, st, AT_SYMLINK_NOFOLLOW);
+}
+
+/* Return true if *ST is the status of DIR or of a directory above it.  */
+static bool
+dir_cycle (struct du_dir const *dir, struct stat const *st)
+{
+  struct du_dir const *p;
+  size_t i;
+
+  for (p = dir; ; p = p->parent)
+    {
+      if (p->dev == st->st_dev && p->ino == st->st_ino)
+        return true;
+      if (! p->parent)
+        break;
+    }
+  for (i = 0; i < p->n_ancestors; i++)
+    if (p->ancestors[i].st_dev == st->st_dev
+        && p->ancestors[i].st_ino == st->st_ino)
+      return true;
+  return false;
+}
+
+/* Open DIR relative to PARENT_FD, add the sizes of the files in it to
+   its total, and list its subdirectories.  Treat each file as
+   process_file would.  Return true if successful.  */
+static bool
+open_dir (struct du_dir *dir, int parent_fd)
+{
+  struct dirent const *dp;
+  struct stat st;
+  struct duinfo sum;
+  char *file_name = NULL;
+  size_t subdirs_alloc = 0;
+  int fd = openat (parent_fd, dir->name,
+                   (O_RDONLY | O_DIRECTORY | O_NOCTTY | O_NOFOLLOW
+                    | O_NONBLOCK | O_CLOEXEC));
+
+  if (0 <= fd)
+    {
+      dir->dirp = fdopendir (fd);
+      if (! dir->dirp)
+        {
+          int err = errno;
+          close (fd);
+          errno = err;
+          fd = -1;
+        }
+    }
+  if (fd < 0)
+    {
+      /* Like FTS_DNR.  The directory's own size is already counted.  */
+      error (0, errno, _("cannot read directory %s"), quote (dir->path));
+      dir_failed ();
+      return false;
+    }
+  dir->fd = fd;
+
+  duinfo_init (&sum);
+  while (true)
+    {
+      struct duinfo dui;
+
+      errno = 0;
+      dp = readdir_ignoring_dot_and_dotdot (dir->dirp);
+      if (! dp)
+        break;
+
+      free (file_name);
+      file_name = file_name_concat (dir->path, dp->d_name, NULL);
+      if (excluded_file_name (exclude, file_name))
+        continue;
+
+      if (stat_entry (fd, dp->d_name, &st) != 0)
+        {
+          error (0, errno, _("cannot access %s"), quote (file_name));
+          dir_failed ();
+          continue;
+        }
+
+      if ((dir_xdev && st.st_dev != dir->root_dev)
+          || (! opt_count_all
+              && (hash_all || (! S_ISDIR (st.st_mode) && 1 < st.st_nlink))
+              && ! hash_ins (di_files, st.st_ino, st.st_dev)))
+        continue;
+
+      if (S_ISDIR (st.st_mode))
+        {
+          if (dir_cycle (dir, &st))
+            {
+              /* Like FTS_DC, which fts reports only when not following
+                 symlinks, as here.  */
+              if (! mount_point (st.st_ino, st.st_dev))
+                {
+                  emit_cycle_warning (file_name);
+                  dir_failed ();
+                }
+              continue;
+            }
+
+          if (dir->n_subdirs == subdirs_alloc)
+            dir->subdirs = x2nrealloc (dir->subdirs, &subdirs_alloc,
+                                       sizeof *dir->subdirs);
+          dir->subdirs[dir->n_subdirs].name = xstrdup (dp->d_name);
+          dir->subdirs[dir->n_subdirs].dev = st.st_dev;
+          dir->subdirs[dir->n_subdirs].ino = st.st_ino;
+          dir->n_subdirs++;
+        }
+
+      stat_duinfo (&dui, &st);
+      duinfo_add (&sum, &dui);
+    }
+  if (errno)
+    {
+      error (0, errno, _("cannot read directory %s"), quote (dir->path));
+      dir_failed ();
+    }
+  free (file_name);
+
+  pthread_mutex_lock (&dir_lock);
+  duinfo_add (&dir->total, &sum);
+  pthread_mutex_unlock (&dir_lock);
+  return true;
+}
+
+/* Close DIR, if it is open.  */
+static void
+close_dir (struct du_dir *dir)
+{
+  if (dir->dirp)
+    closedir (dir->dirp);
+  else if (0 <= dir->fd)
+    close (dir->fd);
+  dir->dirp = NULL;
+  dir->fd = -1;
+}
+
+/* Release a reference to DIR.  If that was the last, add DIR's total
+   to its parent's and release a reference to its parent, or if DIR
+   was handed off by process_file, add it to the finished ones.  */
+static void
+release_dir (struct du_dir *dir)
+{
+  while (dir)
+    {
+      struct du_dir *parent = dir->parent;
+      bool last;
+      size_t i;
+
+      pthread_mutex_lock (&dir_lock);
+      last = --dir->refs == 0;
+      pthread_mutex_unlock (&dir_lock);
+      if (! last)
+        return;
+
+      close_dir (dir);
+      if (! parent)
+        {
+          close (dir->parent_fd);
+          free (dir->ancestors);
+        }
+      for (i = dir->next_subdir; i < dir->n_subdirs; i++)
+        free (dir->subdirs[i].name);
+      free (dir->subdirs);
+      free (dir->name);
+      free (dir->path);
+
+      pthread_mutex_lock (&dir_lock);
+      if (parent)
+        duinfo_add (&parent->total, &dir->total);
+      else
+        {
+          dir->next = dirs_finished;
+          dirs_finished = dir;
+          dirs_unfinished--;
+          pthread_cond_broadcast (&dir_finished);
+        }
+      pthread_mutex_unlock (&dir_lock);
+
+      if (parent)
+        free (dir);
+      dir = parent;
+    }
+}
+
+/* Reopen the parent of DIR, which was closed while DIR was being
+   scanned, via DIR's "..", and check that it is the same directory.
+   If that fails, give up on the rest of the parent.  */
+static void
+reopen_parent (struct du_dir *dir)
+{
+  struct du_dir *parent = dir->parent;
+  struct stat st;
+  int fd = -1;
+
+  if (0 <= dir->fd)
+    {
+      fd = openat (dir->fd, "..",
+                   O_RDONLY | O_DIRECTORY | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+      if (0 <= fd
+          && ! (fstat (fd, &st) == 0
+                && st.st_dev == parent->dev && st.st_ino == parent->ino))
+        {
+          close (fd);
+          fd = -1;
+          errno = 0;
+        }
+      if (fd < 0)
+        error (0, errno, _("failed to return to %s"), quote (parent->path));
+    }
+
+  if (fd < 0)
+    {
+      dir_failed ();
+      while (parent->next_subdir < parent->n_subdirs)
+        free (parent->subdirs[parent->next_subdir++].name);
+      return;
+    }
+  parent->fd = fd;
+}
+
+/* Return true if a subdirectory may be handed off to another thread,
+   because some may be idle.  */
+static bool
+dir_threads_idle (void)
+{
+  bool idle;
+  pthread_mutex_lock (&dir_lock);
+  idle = dirs_queued < dir_threads - 1;
+  pthread_mutex_unlock (&dir_lock);
+  return idle;
+}
+
+/* Count TOP and everything under it, handing off subdirectories to
+   other threads when some are idle, and release TOP.  */
+static void
+scan_tree (struct du_dir *top)
+{
+  struct du_dir *dir = top;
+
+  if (! open_dir (top, top->parent ? top->parent->fd : top->parent_fd))
+    {
+      release_dir (top);
+      return;
+    }
+
+  while (true)
+    {
+      struct du_dir *parent;
+
+      if (dir->next_subdir < dir->n_subdirs)
+        {
+          struct du_dir *child
+            = new_dir (dir, &dir->subdirs[dir->next_subdir++]);
+
+          pthread_mutex_lock (&dir_lock);
+          dir->refs++;
+          pthread_mutex_unlock (&dir_lock);
+
+          if (dir->depth < DU_KEEP_FDS && dir_threads_idle ())
+            {
+              pthread_mutex_lock (&dir_lock);
+              enqueue_dir (child);
+              pthread_mutex_unlock (&dir_lock);
+            }
+          else
+            {
+              child->depth = dir->depth + 1;
+              if (open_dir (child, dir->fd))
+                {
+                  if (DU_KEEP_FDS <= dir->depth)
+                    close_dir (dir);
+                  dir = child;
+                }
+              else
+                release_dir (child);
+            }
+          continue;
+        }
+
+      parent = dir == top ? NULL : dir->parent;
+      if (parent && parent->fd < 0)
+        reopen_parent (dir);
+      release_dir (dir);
+      if (! parent)
+        break;
+      dir = parent;
+    }
+}
+
+/* Scan queued directories forever.  */
+static void *
+dir_thread (void *arg _GL_UNUSED)
+{
+  while (true)
+    {
+      struct du_dir *dir;
+
+      pthread_mutex_lock (&dir_lock);
+      while (! (dir = dequeue_dir ()))
+        pthread_cond_wait (&dir_queued, &dir_lock);
+      pthread_mutex_unlock (&dir_lock);
+
+      scan_tree (dir);
+    }
+  return NULL;
+}
+
+/* Start the threads that scan directories under FTS, besides the main
+   thread, which scans them while waiting for them.  Use fewer threads
+   than --parallel asks for if there may not be enough file descriptors
+   for them.  */
+static void
+start_dir_threads (FTS const *fts)
+{
+  size_t n = MIN (nthreads, DU_THREADS_MAX);
+  size_t fds_per_thread = DU_KEEP_FDS + 2 * DU_QUEUE_PER_THREAD + 2;
+  struct rlimit rlim;
+  size_t i;
+
+  if (getrlimit (RLIMIT_NOFILE, &rlim) == 0 && rlim.rlim_cur != RLIM_INFINITY)
+    n = MIN (n, MAX (1, (rlim.rlim_cur / 2) / fds_per_thread));
+
+  dir_xdev = (fts->fts_options & FTS_XDEV) != 0;
+#if USE_STATX
+  {
+    struct statx stx;
+    statx_mask = (STATX_TYPE | STATX_NLINK | STATX_INO
+                  | (opt_inodes ? 0
+                     : apparent_size ? STATX_SIZE : STATX_BLOCKS)
+                  | (! opt_time ? 0
+                     : time_type == time_mtime ? STATX_MTIME
+                     : time_type == time_atime ? STATX_ATIME : STATX_CTIME));
+    use_statx = (statx (AT_FDCWD, ".", AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT,
+                        STATX_TYPE, &stx) == 0
+                 || errno != ENOSYS);
+  }
+#endif
+
+  dir_threads = 1;
+  for (i = 1; i < n; i++)
+    {
+      pthread_t thread;
+      if (pthread_create (&thread, NULL, dir_thread, NULL) != 0)
+        break;
+      pthread_detach (thread);
+      dir_threads++;
+    }
+}
+
+/* Return true if process_file may hand off the directory ENT to a
+   thread, instead of descending into it.  */
+static bool
+hand_off_ok (FTS const *fts, FTSENT const *ent)
+{
+  return (1 < nthreads && hand_off_level <= ent->fts_level
+          && ! (fts->fts_options & FTS_LOGICAL));
+}
+
+/* Hand off the directory ENT to a thread, to count everything under
+   it.  When the queue is full, first scan the directory at its head.
+   Return false if ENT cannot be handed off.  */
+static bool
+hand_off (FTS *fts, FTSENT const *ent)
+{
+  struct du_dir *dir;
+  struct du_dir *own_dir;
+  FTSENT const *p;
+  size_t i;
+  int parent_fd = dup (fts->fts_cwd_fd);
+
+  if (parent_fd < 0)
+    return false;
+
+  if (! dir_threads)
+    start_dir_threads (fts);
+
+  dir = xzalloc (sizeof *dir);
+  dir->parent_fd = parent_fd;
+  dir->level = ent->fts_level;
+  dir->n_ancestors = ent->fts_level - FTS_ROOTLEVEL;
+  dir->ancestors = xnmalloc (dir->n_ancestors, sizeof *dir->ancestors);
+  for (p = ent->fts_parent, i = 0; FTS_ROOTLEVEL <= p->fts_level;
+       p = p->fts_parent, i++)
+    {
+      dir->ancestors[i].st_dev = p->fts_statp->st_dev;
+      dir->ancestors[i].st_ino = p->fts_statp->st_ino;
+    }
+  dir->name = xstrdup (ent->fts_accpath);
+  dir->path = xstrdup (ent->fts_path);
+  dir->root_dev = fts->fts_dev;
+  dir->dev = ent->fts_statp->st_dev;
+  dir->ino = ent->fts_statp->st_ino;
+  dir->fd = -1;
+  dir->refs = 1;
+  duinfo_init (&dir->total);
+
+  pthread_mutex_lock (&dir_lock);
+  own_dir = (DU_QUEUE_PER_THREAD * dir_threads <= dirs_queued
+             ? dequeue_dir () : NULL);
+  enqueue_dir (dir);
+  dirs_unfinished++;
+  pthread_mutex_unlock (&dir_lock);
+
+  if (own_dir)
+    scan_tree (own_dir);
+  return true;
+}
+
+/* Scan queued directories until all those handed off have been
+   counted.  Add the total of each to the subdirectory total of its
+   level in DULVL, unless DULVL is null, and to the grand total.
+   Return false if something failed in threads since the last call.  */
+static bool
+wait_for_dirs (struct dulevel *dulvl)
+{
+  bool ok;
+
+  if (! dir_threads)
+    return true;
+
+  pthread_mutex_lock (&dir_lock);
+  while (dirs_unfinished)
+    {
+      struct du_dir *dir = dequeue_dir ();
+      if (dir)
+        {
+          pthread_mutex_unlock (&dir_lock);
+          scan_tree (dir);
+          pthread_mutex_lock (&dir_lock);
+        }
+      else
+        pthread_cond_wait (&dir_finished, &dir_lock);
+    }
+  while (dirs_finished)
+    {
+      struct du_dir *dir = dirs_finished;
+      dirs_finished = dir->next;
+      if (dulvl)
+        duinfo_add (&dulvl[dir->level].subdir, &dir->total);
+      duinfo_add (&tot_dui, &dir->total);
+      free (dir);
+    }
+  ok = dirs_ok;
+  dirs_ok = true;
+  pthread_mutex_unlock (&dir_lock);
+  return ok;
+}
+
 /* This function is called once for every file system object that fts
    encounters.  fts does a depth-first traversal.  This function knows
    that and accumulates per-directory totals based on changes in
@@ -505,6 +1195,11 @@ process_file (FTS *fts, FTSENT *ent)
       switch (info)
         {
         case FTS_D:
+          /* With --parallel, a thread counts everything under a
+             directory below those whose totals are printed.  fts then
+             returns ENT next in postorder, as if it had no entries.  */
+          if (hand_off_ok (fts, ent) && hand_off (fts, ent))
+            fts_set (fts, ent, FTS_SKIP);
           return true;
 
         case FTS_ERR:
@@ -516,7 +1211,7 @@ process_file (FTS *fts, FTSENT *ent)
         case FTS_DC:
           /* If not following symlinks and not a (bind) mount point.  */
           if (cycle_warning_required (fts, ent)
-              && ! di_set_lookup (di_mnt, sb->st_dev, sb->st_ino))
+              && ! mount_point (sb->st_ino, sb->st_dev))
             {
               emit_cycle_warning (file);
               return false;
@@ -525,13 +1220,7 @@ process_file (FTS *fts, FTSENT *ent)
         }
     }
 
-  duinfo_set (&dui,
-              (apparent_size
-               ? MAX (0, sb->st_size)
-               : (uintmax_t) ST_NBLOCKS (*sb) * ST_NBLOCKSIZE),
-              (time_type == time_mtime ? get_stat_mtime (sb)
-               : time_type == time_atime ? get_stat_atime (sb)
-               : get_stat_ctime (sb)));
+  stat_duinfo (&dui, sb);
 
   level = ent->fts_level;
   dui_to_print = dui;
@@ -574,8 +1263,10 @@ process_file (FTS *fts, FTSENT *ent)
              directory have been processed.  When the depth decreases,
              propagate sums from the children (prev_level) to the parent.
              Here, the current level is always one smaller than the
-             previous one.  */
+             previous one.  First add the totals of the directories
+             handed off to threads, which are at PREV_LEVEL or deeper.  */
           assert (level == prev_level - 1);
+          ok &= wait_for_dirs (dulvl);
           duinfo_add (&dui_to_print, &dulvl[prev_level].ent);
           if (!opt_separate_dirs)
             duinfo_add (&dui_to_print, &dulvl[prev_level].subdir);
@@ -649,6 +1340,8 @@ du_files (char **files, int bit_flags)
           ok &= process_file (fts, ent);
         }
 
+      ok &= wait_for_dirs (NULL);
+
       if (fts_close (fts) != 0)
         {
           error (0, errno, _("fts_close failed"));
@@ -881,6 +1574,20 @@ main (int argc, char **argv)
           time_style = optarg;
           break;
 
+        case PARALLEL_OPTION:
+          {
+            unsigned long int n;
+            enum strtol_error e = xstrtoul (optarg, NULL, 10, &n, "");
+            if (e == LONGINT_OVERFLOW || SIZE_MAX < n)
+              nthreads = SIZE_MAX;
+            else if (e != LONGINT_OK || n == 0)
+              error (EXIT_FAILURE, 0, _("invalid number of threads: %s"),
+                     quote (optarg));
+            else
+              nthreads = n;
+          }
+          break;
+
         case_GETOPT_HELP_CHAR;
 
         case_GETOPT_VERSION_CHAR (PROGRAM_NAME, AUTHORS);
@@ -915,6 +1622,14 @@ main (int argc, char **argv)
   if (opt_summarize_only)
     max_depth = 0;
 
+  /* Threads may count the directories below the deepest level printed.
+     With --separate-dirs, the totals printed at that level do not
+     include those of their subdirectories, so that a file hard linked
+     both there and under a subdirectory might be counted in either
+     place; hand off only the directories a level further down.  */
+  if (max_depth < SIZE_MAX - 2)
+    hand_off_level = max_depth + 1 + opt_separate_dirs;
+
   if (opt_inodes)
     {
       if (apparent_size)
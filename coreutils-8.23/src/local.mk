@@ -42,6 +42,7 @@ noinst_PROGRAMS =		\
 noinst_HEADERS =		\
   src/chown-core.h		\
   src/copy.h			\
+  src/count-newlines.h		\
   src/cp-hash.h			\
   src/dircolors.h		\
   src/fiemap.h			\
@@ -319,7 +320,18 @@ src_uname_LDADD += $(GETHOSTNAME_LIB)
 src_kill_LDADD += $(LIBTHREAD)
 
 # for pthread
+copy_ldadd += $(LIB_PTHREAD)
+remove_ldadd += $(LIB_PTHREAD)
+src_du_LDADD += $(LIB_PTHREAD)
+src_md5sum_LDADD += $(LIB_PTHREAD)
 src_sort_LDADD += $(LIB_PTHREAD)
+src_sha1sum_LDADD += $(LIB_PTHREAD)
+src_sha224sum_LDADD += $(LIB_PTHREAD)
+src_sha256sum_LDADD += $(LIB_PTHREAD)
+src_sha384sum_LDADD += $(LIB_PTHREAD)
+src_sha512sum_LDADD += $(LIB_PTHREAD)
+src_tail_LDADD += $(LIB_PTHREAD)
+src_wc_LDADD += $(LIB_PTHREAD)
 
 # Get the release year from lib/version-etc.c.
 RELEASE_YEAR = \
@@ -19,6 +19,7 @@
 #include <config.h>
 
 #include <getopt.h>
+#include <pthread.h>
 #include <sys/types.h>
 
 #include "system.h"
@@ -35,16 +36,25 @@
 #if HASH_ALGO_SHA512 || HASH_ALGO_SHA384
 # include "sha512.h"
 #endif
+#include "argmatch.h"
 #include "error.h"
 #include "fadvise.h"
+#include "nproc.h"
+#include "quote.h"
+#include "safe-read.h"
 #include "stdio--.h"
 #include "xfreopen.h"
+#include "xstrtol.h"
 
 /* The official name of this program (e.g., no 'g' prefix).  */
 #if HASH_ALGO_MD5
 # define PROGRAM_NAME "md5sum"
 # define DIGEST_TYPE_STRING "MD5"
 # define DIGEST_STREAM md5_stream
+# define DIGEST_CTX struct md5_ctx
+# define DIGEST_INIT md5_init_ctx
+# define DIGEST_UPDATE md5_process_bytes
+# define DIGEST_FINISH md5_finish_ctx
 # define DIGEST_BITS 128
 # define DIGEST_REFERENCE "RFC 1321"
 # define DIGEST_ALIGN 4
@@ -52,6 +62,10 @@
 # define PROGRAM_NAME "sha1sum"
 # define DIGEST_TYPE_STRING "SHA1"
 # define DIGEST_STREAM sha1_stream
+# define DIGEST_CTX struct sha1_ctx
+# define DIGEST_INIT sha1_init_ctx
+# define DIGEST_UPDATE sha1_process_bytes
+# define DIGEST_FINISH sha1_finish_ctx
 # define DIGEST_BITS 160
 # define DIGEST_REFERENCE "FIPS-180-1"
 # define DIGEST_ALIGN 4
@@ -59,6 +73,10 @@
 # define PROGRAM_NAME "sha256sum"
 # define DIGEST_TYPE_STRING "SHA256"
 # define DIGEST_STREAM sha256_stream
+# define DIGEST_CTX struct sha256_ctx
+# define DIGEST_INIT sha256_init_ctx
+# define DIGEST_UPDATE sha256_process_bytes
+# define DIGEST_FINISH sha256_finish_ctx
 # define DIGEST_BITS 256
 # define DIGEST_REFERENCE "FIPS-180-2"
 # define DIGEST_ALIGN 4
@@ -66,6 +84,10 @@
 # define PROGRAM_NAME "sha224sum"
 # define DIGEST_TYPE_STRING "SHA224"
 # define DIGEST_STREAM sha224_stream
+# define DIGEST_CTX struct sha256_ctx
+# define DIGEST_INIT sha224_init_ctx
+# define DIGEST_UPDATE sha256_process_bytes
+# define DIGEST_FINISH sha224_finish_ctx
 # define DIGEST_BITS 224
 # define DIGEST_REFERENCE "RFC 3874"
 # define DIGEST_ALIGN 4
@@ -73,6 +95,10 @@
 # define PROGRAM_NAME "sha512sum"
 # define DIGEST_TYPE_STRING "SHA512"
 # define DIGEST_STREAM sha512_stream
+# define DIGEST_CTX struct sha512_ctx
+# define DIGEST_INIT sha512_init_ctx
+# define DIGEST_UPDATE sha512_process_bytes
+# define DIGEST_FINISH sha512_finish_ctx
 # define DIGEST_BITS 512
 # define DIGEST_REFERENCE "FIPS-180-2"
 # define DIGEST_ALIGN 8
@@ -80,6 +106,10 @@
 # define PROGRAM_NAME "sha384sum"
 # define DIGEST_TYPE_STRING "SHA384"
 # define DIGEST_STREAM sha384_stream
+# define DIGEST_CTX struct sha512_ctx
+# define DIGEST_INIT sha384_init_ctx
+# define DIGEST_UPDATE sha512_process_bytes
+# define DIGEST_FINISH sha384_finish_ctx
 # define DIGEST_BITS 384
 # define DIGEST_REFERENCE "FIPS-180-2"
 # define DIGEST_ALIGN 8
@@ -87,9 +117,33 @@
 # error "Can't decide which hash algorithm to compile."
 #endif
 
+/* The function that selects how blocks are processed, for testing,
+   and the names of the ways it knows.  */
+#if (HASH_ALGO_SHA256 || HASH_ALGO_SHA224) && ! HAVE_OPENSSL_SHA256
+# define DIGEST_SET_KERNEL sha256_set_kernel
+# define DIGEST_KERNELS "generic", "bmi2", "sha"
+#elif (HASH_ALGO_SHA512 || HASH_ALGO_SHA384) && ! HAVE_OPENSSL_SHA512
+# define DIGEST_SET_KERNEL sha512_set_kernel
+# define DIGEST_KERNELS "generic", "bmi2"
+#endif
+
+#ifdef DIGEST_SET_KERNEL
+static char const *const kernel_args[] =
+{
+  DIGEST_KERNELS, NULL
+};
+#endif
+
 #define DIGEST_HEX_BYTES (DIGEST_BITS / 4)
 #define DIGEST_BIN_BYTES (DIGEST_BITS / 8)
 
+/* What follows DIGEST_TYPE_STRING in a tree checksum, before the
+   chunk size.  */
+#define TREE_STRING "-TREE-"
+
+/* The size of the buffer used by each thread to read chunks.  */
+enum { TREE_BUFFER_SIZE = 128 * 1024 };
+
 #define AUTHORS \
   proper_name ("Ulrich Drepper"), \
   proper_name ("Scott Miller"), \
@@ -129,6 +183,21 @@ static bool strict = false;
 /* Whether a BSD reversed format checksum is detected.  */
 static int bsd_reversed = -1;
 
+/* With --tag, create a BSD-style checksum.  */
+static bool prefix_tag = false;
+
+/* The number of files to digest at once, with --jobs, and the most
+   that --jobs can ask for, as each file is read by its own thread.  */
+enum { JOBS_MAX = 256 };
+static size_t njobs = 1;
+
+/* With --tree-chunk, the size of the chunks of each file to digest,
+   and otherwise 0.  */
+static uintmax_t tree_chunk;
+
+/* The number of threads to digest the chunks of a file with.  */
+static size_t tree_threads;
+
 /* For long options that have no equivalent short option, use a
    non-character as a pseudo short option, starting with CHAR_MAX + 1.  */
 enum
@@ -136,7 +205,10 @@ enum
   STATUS_OPTION = CHAR_MAX + 1,
   QUIET_OPTION,
   STRICT_OPTION,
-  TAG_OPTION
+  TAG_OPTION,
+  JOBS_OPTION,
+  TREE_CHUNK_OPTION,
+  KERNEL_OPTION
 };
 
 static struct option const long_options[] =
@@ -149,6 +221,14 @@ static struct option const long_options[] =
   { "warn", no_argument, NULL, 'w' },
   { "strict", no_argument, NULL, STRICT_OPTION },
   { "tag", no_argument, NULL, TAG_OPTION },
+  { "jobs", required_argument, NULL, JOBS_OPTION },
+  { "tree-chunk", required_argument, NULL, TREE_CHUNK_OPTION },
+#ifdef DIGEST_SET_KERNEL
+  /* This is solely for testing.  Do not document.  */
+  /* It selects how blocks are processed, so that each way can be
+     compared with the generic one.  */
+  { "-kernel", required_argument, NULL, KERNEL_OPTION },
+#endif
   { GETOPT_HELP_OPTION_DECL },
   { GETOPT_VERSION_OPTION_DECL },
   { NULL, 0, NULL, 0 }
@@ -191,6 +271,13 @@ With no FILE, or when FILE is -, read standard input.\n\
       else
         fputs (_("\
   -t, --text           read in text mode (default)\n\
+"), stdout);
+      fputs (_("\
+      --jobs=N         read up to N files at once\n\
+"), stdout);
+      fputs (_("\
+      --tree-chunk=SIZE  create a checksum of the checksums of the SIZE-byte\n\
+                         chunks of each file, computed in parallel\n\
 "), stdout);
       fputs (_("\
 \n\
@@ -316,16 +403,19 @@ bsd_split_3 (char *s, size_t s_len, unsigned char **hex_digest,
 
 /* Split the string S (of length S_LEN) into three parts:
    a hexadecimal digest, binary flag, and the file name.
+   Set *CHUNK_SIZE to the chunk size of a tree checksum, or to 0.
    S is modified.  Return true if successful.  */
 
 static bool
 split_3 (char *s, size_t s_len,
-         unsigned char **hex_digest, int *binary, char **file_name)
+         unsigned char **hex_digest, int *binary, char **file_name,
+         uintmax_t *chunk_size)
 {
   bool escaped_filename = false;
   size_t algo_name_len;
 
   size_t i = 0;
+  *chunk_size = 0;
   while (ISWHITE (s[i]))
     ++i;
 
@@ -340,6 +430,20 @@ split_3 (char *s, size_t s_len,
   algo_name_len = strlen (DIGEST_TYPE_STRING);
   if (STREQ_LEN (s + i, DIGEST_TYPE_STRING, algo_name_len))
     {
+      /* A tree checksum has "-TREE-" and the chunk size after the
+         algorithm name.  Treat the chunk size as the rest of the name.  */
+      if (STREQ_LEN (s + i + algo_name_len, TREE_STRING,
+                     sizeof TREE_STRING - 1))
+        {
+          char *end;
+          i += algo_name_len + sizeof TREE_STRING - 1;
+          if (! ISDIGIT (s[i])
+              || xstrtoumax (s + i, &end, 10, chunk_size, NULL) != LONGINT_OK
+              || *chunk_size == 0 || OFF_T_MAX < *chunk_size)
+            return false;
+          algo_name_len = end - (s + i);
+        }
+
       if (s[i + algo_name_len] == ' ')
         ++i;
       if (s[i + algo_name_len] == '(')
@@ -349,6 +453,8 @@ split_3 (char *s, size_t s_len,
                               s_len - (i + algo_name_len + 1),
                               hex_digest, file_name, escaped_filename);
         }
+      if (*chunk_size)
+        return false;
     }
 
   /* Ignore this line if it is too short.
@@ -413,6 +519,221 @@ hex_digits (unsigned char const *s)
   return *s == '\0';
 }
 
+/* A file being digested as a tree, by threads that each digest one
+   chunk at a time.  */
+struct tree
+{
+  int fd;
+
+  /* The offset of the first chunk, or -1 if the file is read
+     sequentially by one thread.  */
+  off_t start;
+
+  uintmax_t chunk_size;
+
+  /* The members below are protected by LOCK.  */
+  pthread_mutex_t lock;
+
+  /* The index of the next chunk to digest.  */
+  uintmax_t next;
+
+  /* The number of chunks and bytes in the file, which are UINTMAX_MAX
+     until the end of the file has been read.  */
+  uintmax_t nchunks;
+  uintmax_t size;
+
+  /* The digests of the chunks read so far, in an array of N_ALLOCATED
+     digests.  */
+  unsigned char *digests;
+  size_t n_allocated;
+
+  /* The errno of a read error, or 0.  */
+  int err;
+};
+
+/* Digest chunk I of TREE into DIGEST, reading into BUF of
+   TREE_BUFFER_SIZE bytes, and store the number of bytes read into
+   *NREAD.  Return 0 if successful, and otherwise an errno.  */
+
+static int
+digest_chunk (struct tree const *tree, uintmax_t i, char *buf,
+              unsigned char *digest, uintmax_t *nread)
+{
+  DIGEST_CTX ctx;
+  uintmax_t n = 0;
+  off_t offset = 0;
+
+  *nread = 0;
+
+  /* A chunk that would start beyond the largest offset is empty.  */
+  if (0 <= tree->start)
+    {
+      if ((OFF_T_MAX - tree->start) / tree->chunk_size < i)
+        return 0;
+      offset = tree->start + i * tree->chunk_size;
+    }
+
+  DIGEST_INIT (&ctx);
+  while (n < tree->chunk_size)
+    {
+      size_t size = MIN (TREE_BUFFER_SIZE, tree->chunk_size - n);
+      size_t n_read;
+
+      if (tree->start < 0)
+        {
+          n_read = safe_read (tree->fd, buf, size);
+          if (n_read == SAFE_READ_ERROR)
+            return errno;
+        }
+      else
+        {
+          ssize_t r = pread (tree->fd, buf, size, offset + n);
+          if (r < 0)
+            {
+              if (errno == EINTR)
+                continue;
+              return errno;
+            }
+          n_read = r;
+        }
+      if (n_read == 0)
+        break;
+      DIGEST_UPDATE (buf, n_read, &ctx);
+      n += n_read;
+    }
+  DIGEST_FINISH (&ctx, digest);
+  *nread = n;
+  return 0;
+}
+
+/* Digest the chunks of the tree ARG, a struct tree *, until none are
+   left.  */
+
+static void *
+tree_thread (void *arg)
+{
+  struct tree *tree = arg;
+  char *buf = xmalloc (TREE_BUFFER_SIZE);
+  unsigned char digest_unaligned[DIGEST_BIN_BYTES + DIGEST_ALIGN];
+  unsigned char *digest = ptr_align (digest_unaligned, DIGEST_ALIGN);
+
+  while (true)
+    {
+      uintmax_t i;
+      uintmax_t nread;
+      int err;
+
+      pthread_mutex_lock (&tree->lock);
+      if (tree->err || tree->nchunks <= tree->next)
+        {
+          pthread_mutex_unlock (&tree->lock);
+          break;
+        }
+      i = tree->next++;
+      pthread_mutex_unlock (&tree->lock);
+
+      err = digest_chunk (tree, i, buf, digest, &nread);
+
+      pthread_mutex_lock (&tree->lock);
+      if (err)
+        {
+          if (! tree->err)
+            tree->err = err;
+        }
+      else
+        {
+          /* A short chunk is the last one, and an empty one is not a
+             chunk.  Go by the earliest, should the file grow.  */
+          if (nread < tree->chunk_size && i + (nread != 0) < tree->nchunks)
+            {
+              tree->nchunks = i + (nread != 0);
+              tree->size = i * tree->chunk_size + nread;
+            }
+          if (nread != 0)
+            {
+              while (tree->n_allocated <= i)
+                tree->digests = x2nrealloc (tree->digests, &tree->n_allocated,
+                                            DIGEST_BIN_BYTES);
+              memcpy (tree->digests + i * DIGEST_BIN_BYTES, digest,
+                      DIGEST_BIN_BYTES);
+            }
+        }
+      pthread_mutex_unlock (&tree->lock);
+    }
+
+  free (buf);
+  return NULL;
+}
+
+/* Put into BIN_RESULT the tree checksum of the file open on FD, which
+   is the checksum of the concatenated checksums of its successive
+   chunks of CHUNK_SIZE bytes, the last of which may be shorter.  An
+   empty file has no chunks.  Digest the chunks of a regular file with
+   up to tree_threads threads reading at once.  Return true if
+   successful, and otherwise store the errno into *ERR.  */
+
+static bool
+digest_tree (int fd, uintmax_t chunk_size, unsigned char *bin_result,
+             int *err)
+{
+  struct stat st;
+  struct tree tree;
+  pthread_t *threads;
+  size_t nthreads = 1;
+  size_t i;
+  size_t j;
+  DIGEST_CTX ctx;
+
+  tree.fd = fd;
+  tree.start = -1;
+  tree.chunk_size = chunk_size;
+  pthread_mutex_init (&tree.lock, NULL);
+  tree.next = 0;
+  tree.nchunks = tree.size = UINTMAX_MAX;
+  tree.digests = NULL;
+  tree.n_allocated = 0;
+  tree.err = 0;
+
+  if (fstat (fd, &st) == 0 && S_ISREG (st.st_mode)
+      && 0 <= (tree.start = lseek (fd, 0, SEEK_CUR)))
+    {
+      uintmax_t size = MAX (st.st_size, tree.start) - tree.start;
+      uintmax_t nchunks = size / chunk_size + 1;
+      nthreads = MIN (tree_threads, nchunks);
+      tree.n_allocated = MIN (nchunks, SIZE_MAX / DIGEST_BIN_BYTES);
+      tree.digests = xnmalloc (tree.n_allocated, DIGEST_BIN_BYTES);
+    }
+  else
+    tree.start = -1;
+
+  threads = xnmalloc (nthreads, sizeof *threads);
+  for (i = 1; i < nthreads; i++)
+    if (pthread_create (&threads[i], NULL, tree_thread, &tree) != 0)
+      break;
+  tree_thread (&tree);
+  for (j = 1; j < i; j++)
+    pthread_join (threads[j], NULL);
+  free (threads);
+  pthread_mutex_destroy (&tree.lock);
+
+  if (tree.err)
+    {
+      free (tree.digests);
+      *err = tree.err;
+      return false;
+    }
+
+  /* Leave the file offset where reading the file serially would.  */
+  if (0 <= tree.start)
+    lseek (fd, tree.start + tree.size, SEEK_SET);
+
+  DIGEST_INIT (&ctx);
+  DIGEST_UPDATE (tree.digests, tree.nchunks * DIGEST_BIN_BYTES, &ctx);
+  DIGEST_FINISH (&ctx, bin_result);
+  free (tree.digests);
+  return true;
+}
+
 /* An interface to the function, DIGEST_STREAM.
    Operate on FILENAME (it may be "-").
 
@@ -421,14 +742,20 @@ hex_digits (unsigned char const *s)
    a terminal; in that case, clear *BINARY if the file was treated as
    text because it was a terminal.
 
+   If CHUNK_SIZE is nonzero, compute the tree checksum with that chunk
+   size instead, as digest_tree does.
+
    Put the checksum in *BIN_RESULT, which must be properly aligned.
-   Return true if successful.  */
+   Return true if successful.  Otherwise store the errno of the failure
+   into *ERR, and leave it to the caller to diagnose; this allows
+   files other than standard input to be digested in any thread.  */
 
 static bool
-digest_file (const char *filename, int *binary, unsigned char *bin_result)
+digest_file (const char *filename, int *binary, uintmax_t chunk_size,
+             unsigned char *bin_result, int *err)
 {
   FILE *fp;
-  int err;
+  bool ok;
   bool is_stdin = STREQ (filename, "-");
 
   if (is_stdin)
@@ -448,17 +775,23 @@ digest_file (const char *filename, int *binary, unsigned char *bin_result)
       fp = fopen (filename, (O_BINARY && *binary ? "rb" : "r"));
       if (fp == NULL)
         {
-          error (0, errno, "%s", filename);
+          *err = errno;
           return false;
         }
     }
 
   fadvise (fp, FADVISE_SEQUENTIAL);
 
-  err = DIGEST_STREAM (fp, bin_result);
-  if (err)
+  if (chunk_size)
+    ok = digest_tree (fileno (fp), chunk_size, bin_result, err);
+  else
+    {
+      ok = DIGEST_STREAM (fp, bin_result) == 0;
+      if (!ok)
+        *err = errno;
+    }
+  if (!ok)
     {
-      error (0, errno, "%s", filename);
       if (fp != stdin)
         fclose (fp);
       return false;
@@ -466,13 +799,283 @@ digest_file (const char *filename, int *binary, unsigned char *bin_result)
 
   if (!is_stdin && fclose (fp) != 0)
     {
-      error (0, errno, "%s", filename);
+      *err = errno;
       return false;
     }
 
   return true;
 }
 
+/* A file to digest, with --jobs.  */
+struct digest_job
+{
+  /* The file name.  */
+  char *file;
+
+  /* With --check, the hexadecimal digest that the file should have.  */
+  unsigned char hex_digest[DIGEST_HEX_BYTES + 1];
+
+  /* As for digest_file.  */
+  int binary;
+  uintmax_t chunk_size;
+
+  /* Whether any thread may digest the file.  Standard input is left
+     to the main thread.  */
+  bool shared;
+
+  /* Whether the file has been digested, whether successfully, and if
+     not the errno of the failure.  */
+  bool done;
+  bool ok;
+  int err;
+
+  unsigned char bin_buffer_unaligned[DIGEST_BIN_BYTES + DIGEST_ALIGN];
+};
+
+/* The files to digest, with --jobs, in a circular buffer of
+   QUEUE_SIZE jobs.  Jobs are numbered in the order they are queued.
+   Jobs QUEUE_HEAD up to QUEUE_TAIL are in the queue, and are reported
+   in that order by the main thread, which alone queues and removes
+   jobs.  Those from QUEUE_NEXT on have not been started by any thread.
+   QUEUE_TAIL, QUEUE_NEXT, QUEUE_CLOSED and the DONE members are
+   protected by QUEUE_LOCK.  */
+static struct digest_job *queue;
+static size_t queue_size;
+static size_t queue_head;
+static size_t queue_tail;
+static size_t queue_next;
+static bool queue_closed;
+static pthread_mutex_t queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t job_queued = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t job_done = PTHREAD_COND_INITIALIZER;
+
+/* The threads other than the main one that digest files.  */
+static pthread_t *workers;
+static size_t nworkers;
+
+/* Digest the file of JOB.  */
+
+static void
+run_job (struct digest_job *job)
+{
+  job->ok = digest_file (job->file, &job->binary, job->chunk_size,
+                         ptr_align (job->bin_buffer_unaligned, DIGEST_ALIGN),
+                         &job->err);
+}
+
+/* Digest the next queued file that no thread has started on, that any
+   thread may digest.  If there is none, and WAIT, wait for one to be
+   queued until the queue is closed.  Return false if no file was
+   digested.  */
+
+static bool
+start_job (bool wait)
+{
+  struct digest_job *job = NULL;
+
+  pthread_mutex_lock (&queue_lock);
+  while (true)
+    {
+      while (queue_next < queue_tail && ! queue[queue_next % queue_size].shared)
+        queue_next++;
+      if (queue_next < queue_tail)
+        {
+          job = &queue[queue_next++ % queue_size];
+          break;
+        }
+      if (! wait || queue_closed)
+        break;
+      pthread_cond_wait (&job_queued, &queue_lock);
+    }
+  pthread_mutex_unlock (&queue_lock);
+  if (! job)
+    return false;
+
+  run_job (job);
+
+  pthread_mutex_lock (&queue_lock);
+  job->done = true;
+  pthread_cond_broadcast (&job_done);
+  pthread_mutex_unlock (&queue_lock);
+  return true;
+}
+
+/* Digest queued files until the queue is closed.  */
+
+static void *
+job_thread (void *arg _GL_UNUSED)
+{
+  while (start_job (true))
+    continue;
+  return NULL;
+}
+
+/* Start up to NJOBS - 1 threads, and make room to queue enough files
+   to keep them busy.  */
+
+static void
+start_workers (void)
+{
+  queue_size = 4 * njobs;
+  queue = xnmalloc (njobs, 4 * sizeof *queue);
+  workers = xnmalloc (njobs - 1, sizeof *workers);
+  for (nworkers = 0; nworkers < njobs - 1; nworkers++)
+    if (pthread_create (&workers[nworkers], NULL, job_thread, NULL) != 0)
+      break;
+}
+
+/* Close the queue, which must be empty, and wait for the threads.  */
+
+static void
+stop_workers (void)
+{
+  size_t i;
+
+  pthread_mutex_lock (&queue_lock);
+  queue_closed = true;
+  pthread_cond_broadcast (&job_queued);
+  pthread_mutex_unlock (&queue_lock);
+  for (i = 0; i < nworkers; i++)
+    pthread_join (workers[i], NULL);
+  free (workers);
+  free (queue);
+}
+
+/* Queue FILENAME to be digested as by digest_file with BINARY and
+   CHUNK_SIZE, and with --check, compared with HEX_DIGEST.  The queue
+   must not be full.  */
+
+static void
+queue_job (char const *filename, int binary, uintmax_t chunk_size,
+           unsigned char const *hex_digest)
+{
+  struct digest_job *job = &queue[queue_tail % queue_size];
+
+  job->file = xstrdup (filename);
+  if (hex_digest)
+    strcpy ((char *) job->hex_digest, (char const *) hex_digest);
+  job->binary = binary;
+  job->chunk_size = chunk_size;
+
+  /* Leave a tree checksum to the main thread, as it uses threads of
+     its own.  */
+  job->shared = ! STREQ (filename, "-") && ! chunk_size;
+  job->done = false;
+
+  pthread_mutex_lock (&queue_lock);
+  queue_tail++;
+  pthread_cond_signal (&job_queued);
+  pthread_mutex_unlock (&queue_lock);
+}
+
+/* Return the oldest queued job, which must exist, once its file has
+   been digested, digesting other queued files while waiting.  */
+
+static struct digest_job *
+finish_job (void)
+{
+  struct digest_job *job = &queue[queue_head % queue_size];
+  bool done;
+
+  if (! job->shared)
+    {
+      run_job (job);
+      return job;
+    }
+
+  do
+    {
+      pthread_mutex_lock (&queue_lock);
+      done = job->done;
+      pthread_mutex_unlock (&queue_lock);
+    }
+  while (! done && start_job (false));
+
+  pthread_mutex_lock (&queue_lock);
+  while (! job->done)
+    pthread_cond_wait (&job_done, &queue_lock);
+  pthread_mutex_unlock (&queue_lock);
+  return job;
+}
+
+/* Remove the oldest queued job.  */
+
+static void
+remove_job (void)
+{
+  free (queue[queue_head % queue_size].file);
+  queue_head++;
+}
+
+/* Report the result of checking FILENAME against HEX_DIGEST, which is
+   BIN_BUFFER if OK, and otherwise could not be computed because of
+   the errno ERR.  Count the failures into *N_OPEN_OR_READ_FAILURES
+   and *N_MISMATCHED_CHECKSUMS.  */
+
+static void
+report_check (char const *filename, unsigned char const *hex_digest,
+              bool ok, int err, unsigned char const *bin_buffer,
+              uintmax_t *n_open_or_read_failures,
+              uintmax_t *n_mismatched_checksums)
+{
+  static const char bin2hex[] = { '0', '1', '2', '3',
+                                  '4', '5', '6', '7',
+                                  '8', '9', 'a', 'b',
+                                  'c', 'd', 'e', 'f' };
+
+  if (!ok)
+    {
+      error (0, err, "%s", filename);
+      ++*n_open_or_read_failures;
+      if (!status_only)
+        {
+          printf (_("%s: FAILED open or read\n"), filename);
+        }
+    }
+  else
+    {
+      size_t digest_bin_bytes = digest_hex_bytes / 2;
+      size_t cnt;
+      /* Compare generated binary number with text representation
+         in check file.  Ignore case of hex digits.  */
+      for (cnt = 0; cnt < digest_bin_bytes; ++cnt)
+        {
+          if (tolower (hex_digest[2 * cnt])
+              != bin2hex[bin_buffer[cnt] >> 4]
+              || (tolower (hex_digest[2 * cnt + 1])
+                  != (bin2hex[bin_buffer[cnt] & 0xf])))
+            break;
+        }
+      if (cnt != digest_bin_bytes)
+        ++*n_mismatched_checksums;
+
+      if (!status_only)
+        {
+          if (cnt != digest_bin_bytes)
+            printf ("%s: %s\n", filename, _("FAILED"));
+          else if (!quiet)
+            printf ("%s: %s\n", filename, _("OK"));
+        }
+    }
+}
+
+/* Report the results of checking queued files, oldest first, until at
+   most N are left, counting the failures as for report_check.  */
+
+static void
+flush_checks (size_t n, uintmax_t *n_open_or_read_failures,
+              uintmax_t *n_mismatched_checksums)
+{
+  while (n < queue_tail - queue_head)
+    {
+      struct digest_job *job = finish_job ();
+      report_check (job->file, job->hex_digest, job->ok, job->err,
+                    ptr_align (job->bin_buffer_unaligned, DIGEST_ALIGN),
+                    n_open_or_read_failures, n_mismatched_checksums);
+      remove_job ();
+    }
+}
+
 static bool
 digest_check (const char *checkfile_name)
 {
@@ -485,6 +1088,7 @@ digest_check (const char *checkfile_name)
   unsigned char bin_buffer_unaligned[DIGEST_BIN_BYTES + DIGEST_ALIGN];
   /* Make sure bin_buffer is properly aligned. */
   unsigned char *bin_buffer = ptr_align (bin_buffer_unaligned, DIGEST_ALIGN);
+  int err;
   uintmax_t line_number;
   char *line;
   size_t line_chars_allocated;
@@ -512,7 +1116,8 @@ digest_check (const char *checkfile_name)
   do
     {
       char *filename IF_LINT ( = NULL);
-      int binary;
+      int binary = 0;
+      uintmax_t chunk_size;
       unsigned char *hex_digest IF_LINT ( = NULL);
       ssize_t line_length;
 
@@ -533,7 +1138,8 @@ digest_check (const char *checkfile_name)
       if (line[line_length - 1] == '\n')
         line[--line_length] = '\0';
 
-      if (! (split_3 (line, line_length, &hex_digest, &binary, &filename)
+      if (! (split_3 (line, line_length, &hex_digest, &binary, &filename,
+                      &chunk_size)
              && ! (is_stdin && STREQ (filename, "-"))
              && hex_digits (hex_digest)))
         {
@@ -541,6 +1147,10 @@ digest_check (const char *checkfile_name)
 
           if (warn)
             {
+              /* Keep the warnings in order with the results.  */
+              if (queue)
+                flush_checks (0, &n_open_or_read_failures,
+                              &n_mismatched_checksums);
               error (0, 0,
                      _("%s: %" PRIuMAX
                        ": improperly formatted %s checksum line"),
@@ -552,53 +1162,29 @@ digest_check (const char *checkfile_name)
         }
       else
         {
-          static const char bin2hex[] = { '0', '1', '2', '3',
-                                          '4', '5', '6', '7',
-                                          '8', '9', 'a', 'b',
-                                          'c', 'd', 'e', 'f' };
-          bool ok;
-
           ++n_properly_formatted_lines;
 
-          ok = digest_file (filename, &binary, bin_buffer);
-
-          if (!ok)
+          if (queue)
             {
-              ++n_open_or_read_failures;
-              if (!status_only)
-                {
-                  printf (_("%s: FAILED open or read\n"), filename);
-                }
+              flush_checks (queue_size - 1, &n_open_or_read_failures,
+                            &n_mismatched_checksums);
+              queue_job (filename, binary, chunk_size, hex_digest);
             }
           else
             {
-              size_t digest_bin_bytes = digest_hex_bytes / 2;
-              size_t cnt;
-              /* Compare generated binary number with text representation
-                 in check file.  Ignore case of hex digits.  */
-              for (cnt = 0; cnt < digest_bin_bytes; ++cnt)
-                {
-                  if (tolower (hex_digest[2 * cnt])
-                      != bin2hex[bin_buffer[cnt] >> 4]
-                      || (tolower (hex_digest[2 * cnt + 1])
-                          != (bin2hex[bin_buffer[cnt] & 0xf])))
-                    break;
-                }
-              if (cnt != digest_bin_bytes)
-                ++n_mismatched_checksums;
-
-              if (!status_only)
-                {
-                  if (cnt != digest_bin_bytes)
-                    printf ("%s: %s\n", filename, _("FAILED"));
-                  else if (!quiet)
-                    printf ("%s: %s\n", filename, _("OK"));
-                }
+              bool ok = digest_file (filename, &binary, chunk_size,
+                                     bin_buffer, &err);
+              report_check (filename, hex_digest, ok, err, bin_buffer,
+                            &n_open_or_read_failures,
+                            &n_mismatched_checksums);
             }
         }
     }
   while (!feof (checkfile_stream) && !ferror (checkfile_stream));
 
+  if (queue)
+    flush_checks (0, &n_open_or_read_failures, &n_mismatched_checksums);
+
   free (line);
 
   if (ferror (checkfile_stream))
@@ -686,6 +1272,84 @@ print_filename (char const *file, bool escape)
     }
 }
 
+/* Report the result of digesting FILE as by digest_file with
+   BINARY: print its checksum BIN_BUFFER if OK, and otherwise diagnose
+   the errno ERR.  Return OK.  */
+
+static bool
+report_digest (char const *file, int binary, bool ok, int err,
+               unsigned char const *bin_buffer)
+{
+  if (!ok)
+    {
+      error (0, err, "%s", file);
+      return false;
+    }
+
+  /* We don't really need to escape, and hence detect, the '\\'
+     char, and not doing so should be both forwards and backwards
+     compatible, since only escaped lines would have a '\\' char at
+     the start.  However just in case users are directly comparing
+     against old (hashed) outputs, in the presence of files
+     containing '\\' characters, we decided to not simplify the
+     output in this case.  */
+  bool needs_escape = strchr (file, '\\') || strchr (file, '\n');
+
+  if (prefix_tag)
+    {
+      if (needs_escape)
+        putchar ('\\');
+
+      fputs (DIGEST_TYPE_STRING, stdout);
+      if (tree_chunk)
+        printf ("%s%" PRIuMAX, TREE_STRING, tree_chunk);
+      fputs (" (", stdout);
+      print_filename (file, needs_escape);
+      fputs (") = ", stdout);
+    }
+
+  size_t i;
+
+  /* Output a leading backslash if the file name contains
+     a newline or backslash.  */
+  if (!prefix_tag && needs_escape)
+    putchar ('\\');
+
+  for (i = 0; i < (digest_hex_bytes / 2); ++i)
+    printf ("%02x", bin_buffer[i]);
+
+  if (!prefix_tag)
+    {
+      putchar (' ');
+
+      putchar (binary ? '*' : ' ');
+
+      print_filename (file, needs_escape);
+    }
+
+  putchar ('\n');
+  return true;
+}
+
+/* Report the results of digesting queued files, oldest first, until
+   at most N are left.  Return true if all were successful.  */
+
+static bool
+flush_digests (size_t n)
+{
+  bool ok = true;
+
+  while (n < queue_tail - queue_head)
+    {
+      struct digest_job *job = finish_job ();
+      ok &= report_digest (job->file, job->binary, job->ok, job->err,
+                           ptr_align (job->bin_buffer_unaligned,
+                                      DIGEST_ALIGN));
+      remove_job ();
+    }
+  return ok;
+}
+
 int
 main (int argc, char **argv)
 {
@@ -696,7 +1360,8 @@ main (int argc, char **argv)
   int opt;
   bool ok = true;
   int binary = -1;
-  bool prefix_tag = false;
+  int err;
+  bool njobs_specified = false;
 
   /* Setting values of global variables.  */
   initialize_main (&argc, &argv);
@@ -745,6 +1410,35 @@ main (int argc, char **argv)
         prefix_tag = true;
         binary = 1;
         break;
+      case JOBS_OPTION:
+        {
+          unsigned long int n;
+          enum strtol_error e = xstrtoul (optarg, NULL, 10, &n, "");
+          if (e == LONGINT_OVERFLOW || JOBS_MAX < n)
+            njobs = JOBS_MAX;
+          else if (e != LONGINT_OK || n == 0)
+            error (EXIT_FAILURE, 0, _("invalid number of jobs: %s"),
+                   quote (optarg));
+          else
+            njobs = n;
+          njobs_specified = true;
+        }
+        break;
+      case TREE_CHUNK_OPTION:
+        if (xstrtoumax (optarg, NULL, 10, &tree_chunk, "bEGKkMmPTYZ0")
+            != LONGINT_OK
+            || tree_chunk == 0 || OFF_T_MAX < tree_chunk)
+          error (EXIT_FAILURE, 0, _("invalid chunk size: %s"),
+                 quote (optarg));
+        break;
+#ifdef DIGEST_SET_KERNEL
+      case KERNEL_OPTION:
+        if (! DIGEST_SET_KERNEL (XARGMATCH ("---kernel", optarg,
+                                            kernel_args, kernel_args)))
+          error (EXIT_FAILURE, 0, _("unsupported kernel: %s"),
+                 quote (optarg));
+        break;
+#endif
       case_GETOPT_HELP_CHAR;
       case_GETOPT_VERSION_CHAR (PROGRAM_NAME, AUTHORS);
       default:
@@ -754,6 +1448,27 @@ main (int argc, char **argv)
   min_digest_line_length = MIN_DIGEST_LINE_LENGTH;
   digest_hex_bytes = DIGEST_HEX_BYTES;
 
+  if (tree_chunk && !binary)
+    {
+      error (0, 0, _("--tree-chunk does not support --text mode"));
+      usage (EXIT_FAILURE);
+    }
+
+  if (tree_chunk && do_check)
+    {
+      error (0, 0, _("the --tree-chunk option is meaningless when "
+                     "verifying checksums"));
+      usage (EXIT_FAILURE);
+    }
+
+  /* A tree checksum is always of the bytes of the file, and is output
+     in the BSD style, so that the chunk size can be recorded.  */
+  if (tree_chunk)
+    {
+      prefix_tag = true;
+      binary = 1;
+    }
+
   if (prefix_tag && !binary)
    {
      /* This could be supported in a backwards compatible way
@@ -813,6 +1528,19 @@ main (int argc, char **argv)
   if (optind == argc)
     argv[argc++] = bad_cast ("-");
 
+  /* Tree checksums are computed with --jobs threads if specified, and
+     otherwise with a thread per processor.  */
+  tree_threads = (njobs_specified ? njobs
+                  : num_processors (NPROC_CURRENT_OVERRIDABLE));
+
+  /* There is no point in more threads than files to digest, unless
+     the files are listed in checksum files.  The chunks of a tree
+     checksum are digested in parallel instead.  */
+  if (!do_check)
+    njobs = tree_chunk ? 1 : MIN (njobs, argc - optind);
+  if (1 < njobs)
+    start_workers ();
+
   for (; optind < argc; ++optind)
     {
       char *file = argv[optind];
@@ -823,54 +1551,27 @@ main (int argc, char **argv)
         {
           int file_is_binary = binary;
 
-          if (! digest_file (file, &file_is_binary, bin_buffer))
-            ok = false;
+          if (queue)
+            {
+              ok &= flush_digests (queue_size - 1);
+              queue_job (file, file_is_binary, tree_chunk, NULL);
+            }
           else
             {
-              /* We don't really need to escape, and hence detect, the '\\'
-                 char, and not doing so should be both forwards and backwards
-                 compatible, since only escaped lines would have a '\\' char at
-                 the start.  However just in case users are directly comparing
-                 against old (hashed) outputs, in the presence of files
-                 containing '\\' characters, we decided to not simplify the
-                 output in this case.  */
-              bool needs_escape = strchr (file, '\\') || strchr (file, '\n');
-
-              if (prefix_tag)
-                {
-                  if (needs_escape)
-                    putchar ('\\');
-
-                  fputs (DIGEST_TYPE_STRING, stdout);
-                  fputs (" (", stdout);
-                  print_filename (file, needs_escape);
-                  fputs (") = ", stdout);
-                }
-
-              size_t i;
-
-              /* Output a leading backslash if the file name contains
-                 a newline or backslash.  */
-              if (!prefix_tag && needs_escape)
-                putchar ('\\');
-
-              for (i = 0; i < (digest_hex_bytes / 2); ++i)
-                printf ("%02x", bin_buffer[i]);
-
-              if (!prefix_tag)
-                {
-                  putchar (' ');
-
-                  putchar (file_is_binary ? '*' : ' ');
-
-                  print_filename (file, needs_escape);
-                }
-
-              putchar ('\n');
+              bool file_ok = digest_file (file, &file_is_binary, tree_chunk,
+                                          bin_buffer, &err);
+              ok &= report_digest (file, file_is_binary, file_ok, err,
+                                   bin_buffer);
             }
         }
     }
 
+  if (queue)
+    {
+      ok &= flush_digests (0);
+      stop_workers ();
+    }
+
   if (have_read_stdin && fclose (stdin) == EOF)
     error (EXIT_FAILURE, errno, _("standard input"));
 
@@ -82,6 +82,7 @@ rm_option_init (struct rm_options *x)
      part is enough.  It implies removal.  */
   x->interactive = RMI_NEVER;
   x->stdin_tty = false;
+  x->nthreads = 1;
 
   x->verbose = false;
 
@@ -107,7 +108,9 @@ cp_option_init (struct cp_options *x)
 
   cp_options_default (x);
   x->copy_as_regular = false;  /* FIXME: maybe make this an option */
-  x->reflink_mode = REFLINK_NEVER;
+  x->reflink_mode = REFLINK_AUTO;
+  x->nthreads = 1;
+  x->io_uring = false;
   x->dereference = DEREF_NEVER;
   x->unlink_dest_before_opening = false;
   x->unlink_dest_after_failed_open = false;
@@ -19,11 +19,14 @@
 #include <config.h>
 #include <stdio.h>
 #include <sys/types.h>
+#include <sys/resource.h>
 #include <assert.h>
+#include <pthread.h>
 
 #include "system.h"
 #include "error.h"
 #include "file-type.h"
+#include "filenamecat.h"
 #include "ignore-value.h"
 #include "quote.h"
 #include "remove.h"
@@ -60,6 +63,9 @@ enum Prompt_action
 # define DT_UNKNOWN 0
 # define DT_DIR 1
 # define DT_LNK 2
+# define D_TYPE(d) DT_UNKNOWN
+#else
+# define D_TYPE(d) ((d)->d_type)
 #endif
 
 /* Like fstatat, but cache the result.  If ST->st_size is -1, the
@@ -360,20 +366,23 @@ mark_ancestor_dirs (FTSENT *ent)
     }
 }
 
-/* Remove the file system object specified by ENT.  IS_DIR specifies
-   whether it is expected to be a directory or non-directory.
+/* Remove FILE, relative to FD_CWD, whose full name is FULL_NAME.
+   IS_DIR specifies whether it is expected to be a directory or
+   non-directory.  If it is a directory that could not be read,
+   DNR_ERRNO is the errno value from that failure, and otherwise 0.
    Return RM_OK upon success, else RM_ERROR.  */
 static enum RM_status
-excise (FTS *fts, FTSENT *ent, struct rm_options const *x, bool is_dir)
+excise_at (int fd_cwd, char const *file, char const *full_name,
+           int dnr_errno, struct rm_options const *x, bool is_dir)
 {
   int flag = is_dir ? AT_REMOVEDIR : 0;
-  if (unlinkat (fts->fts_cwd_fd, ent->fts_accpath, flag) == 0)
+  if (unlinkat (fd_cwd, file, flag) == 0)
     {
       if (x->verbose)
         {
           printf ((is_dir
                    ? _("removed directory: %s\n")
-                   : _("removed %s\n")), quote (ent->fts_path));
+                   : _("removed %s\n")), quote (full_name));
         }
       return RM_OK;
     }
@@ -385,7 +394,7 @@ excise (FTS *fts, FTSENT *ent, struct rm_options const *x, bool is_dir)
   if (errno == EROFS)
     {
       struct stat st;
-      if ( ! (lstatat (fts->fts_cwd_fd, ent->fts_accpath, &st)
+      if ( ! (lstatat (fd_cwd, file, &st)
                        && errno == ENOENT))
         errno = EROFS;
     }
@@ -398,16 +407,634 @@ excise (FTS *fts, FTSENT *ent, struct rm_options const *x, bool is_dir)
      meaningless in a diagnostic.  When that happens and the errno value
      from the failed open is EPERM or EACCES, use the earlier, more
      descriptive errno value.  */
-  if (ent->fts_info == FTS_DNR
+  if (dnr_errno
       && (errno == ENOTEMPTY || errno == EISDIR || errno == ENOTDIR
           || errno == EEXIST)
-      && (ent->fts_errno == EPERM || ent->fts_errno == EACCES))
-    errno = ent->fts_errno;
-  error (0, errno, _("cannot remove %s"), quote (ent->fts_path));
-  mark_ancestor_dirs (ent);
+      && (dnr_errno == EPERM || dnr_errno == EACCES))
+    errno = dnr_errno;
+  error (0, errno, _("cannot remove %s"), quote (full_name));
   return RM_ERROR;
 }
 
+/* Remove the file system object specified by ENT.  IS_DIR specifies
+   whether it is expected to be a directory or non-directory.
+   Return RM_OK upon success, else RM_ERROR.  */
+static enum RM_status
+excise (FTS *fts, FTSENT *ent, struct rm_options const *x, bool is_dir)
+{
+  enum RM_status s = excise_at (fts->fts_cwd_fd, ent->fts_accpath,
+                                ent->fts_path,
+                                ent->fts_info == FTS_DNR ? ent->fts_errno : 0,
+                                x, is_dir);
+  if (s == RM_ERROR)
+    mark_ancestor_dirs (ent);
+  return s;
+}
+
+/* With --parallel, a directory that is removed, along with everything
+   under it, in a thread.  rm_fts hands the directories that it would
+   descend into to threads, which may in turn hand off subdirectories
+   to other threads, when some are idle.  Each directory is removed
+   with unlinkat relative to its parent's descriptor, once the files in
+   it and the directories under it have been.  */
+struct rm_dir
+{
+  /* The next directory in the queue of those not yet started.  */
+  struct rm_dir *next;
+
+  /* The directory containing this one, or NULL if this one was handed
+     off by rm_fts.  */
+  struct rm_dir *parent;
+
+  /* If PARENT is NULL, a descriptor for the directory containing this
+     one, the entry in rm_fts's hierarchy for that directory, and the
+     devices and inode numbers of the directories above this one.  */
+  int parent_fd;
+  FTSENT *parent_ent;
+  struct dev_ino *ancestors;
+  size_t n_ancestors;
+
+  /* The name of the directory relative to its parent, and its full
+     name for diagnostics.  */
+  char *name;
+  char *path;
+
+  /* The device of the command line argument this directory is under,
+     and this directory's device and inode number once it is open.  */
+  dev_t root_dev;
+  dev_t dev;
+  ino_t ino;
+
+  /* The directory's stream and descriptor, or NULL and -1 if it is
+     not open.  Beyond RM_KEEP_FDS directories deep in a thread, a
+     directory is closed while the one below it is being removed, and
+     then reopened via "..".  */
+  DIR *dirp;
+  int fd;
+  size_t depth;
+
+  /* The names of the subdirectories, and the index of the next to
+     remove.  */
+  char **subdirs;
+  size_t n_subdirs;
+  size_t next_subdir;
+
+  /* The number of subdirectories handed off to other threads and not
+     yet removed, plus one until this directory has been read and its
+     remaining subdirectories removed.  The directory itself is
+     removed by whichever thread brings this to zero.  */
+  size_t refs;
+
+  /* Whether some file under this directory could not be removed, so
+     that it is not to be removed either, and whether it has already
+     been dealt with otherwise.  */
+  bool failed;
+  bool done;
+};
+
+/* The most threads to remove files with, the most directories deep
+   that a thread keeps open, and the most directories from rm_fts to
+   queue per thread, beyond which rm_fts removes the directory at the
+   head of the queue itself before handing off another.  */
+enum { RM_THREADS_MAX = 256, RM_KEEP_FDS = 16, RM_QUEUE_PER_THREAD = 4 };
+
+/* The directories not yet started, in the order queued, and their
+   number; the number of directories handed off by rm_fts and not yet
+   removed; the entries of rm_fts for the parents of those that could
+   not be removed, and their number; and the status of everything
+   removed in threads.  These, and the REFS and FAILED members of each
+   directory, are protected by DIR_LOCK.  */
+static struct rm_dir *dir_head;
+static struct rm_dir **dir_tail = &dir_head;
+static size_t dirs_queued;
+static size_t dirs_unfinished;
+static FTSENT **failed_ents;
+static size_t n_failed_ents;
+static size_t failed_ents_alloc;
+static enum RM_status dirs_status = RM_OK;
+static pthread_mutex_t dir_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t dir_queued = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t dir_finished = PTHREAD_COND_INITIALIZER;
+
+/* The options of the threads, and the number of threads, including
+   the main thread, or 0 if they have not been started.  */
+static struct rm_options const *dir_options;
+static size_t dir_threads;
+
+/* Remove the directory at the head of the queue and return it, or
+   return NULL if the queue is empty.  DIR_LOCK must be held.  */
+static struct rm_dir *
+dequeue_dir (void)
+{
+  struct rm_dir *dir = dir_head;
+  if (dir)
+    {
+      dir_head = dir->next;
+      if (! dir_head)
+        dir_tail = &dir_head;
+      dirs_queued--;
+    }
+  return dir;
+}
+
+/* Add DIR to the queue.  DIR_LOCK must be held.  */
+static void
+enqueue_dir (struct rm_dir *dir)
+{
+  dir->next = NULL;
+  *dir_tail = dir;
+  dir_tail = &dir->next;
+  dirs_queued++;
+  pthread_cond_signal (&dir_queued);
+}
+
+/* Record that a file under DIR could not be removed, or if DIR is
+   NULL, only that something failed.  */
+static void
+dir_failed (struct rm_dir *dir)
+{
+  pthread_mutex_lock (&dir_lock);
+  if (dir)
+    dir->failed = true;
+  dirs_status = RM_ERROR;
+  pthread_mutex_unlock (&dir_lock);
+}
+
+/* Return a new directory NAME in PARENT, which is not yet open.  Take
+   ownership of NAME.  */
+static struct rm_dir *
+new_dir (struct rm_dir *parent, char *name)
+{
+  struct rm_dir *dir = xzalloc (sizeof *dir);
+  dir->parent = parent;
+  dir->parent_fd = -1;
+  dir->name = name;
+  dir->path = file_name_concat (parent->path, name, NULL);
+  dir->root_dev = parent->root_dev;
+  dir->fd = -1;
+  dir->refs = 1;
+  return dir;
+}
+
+/* Return true if DIR's device and inode number are those of a
+   directory above it.  */
+static bool
+dir_cycle (struct rm_dir const *dir)
+{
+  struct rm_dir const *p;
+  size_t i;
+
+  for (p = dir; p->parent; p = p->parent)
+    if (p->parent->dev == dir->dev && p->parent->ino == dir->ino)
+      return true;
+  for (i = 0; i < p->n_ancestors; i++)
+    if (p->ancestors[i].st_dev == dir->dev
+        && p->ancestors[i].st_ino == dir->ino)
+      return true;
+  return false;
+}
+
+/* Open DIR relative to PARENT_FD, remove the files in it other than
+   directories, and list its subdirectories.  Return true if
+   successful.  Otherwise, deal with DIR as rm_fts would with a
+   directory that it cannot descend into, and mark DIR as done.  */
+static bool
+open_dir (struct rm_dir *dir, int parent_fd, struct rm_options const *x)
+{
+  struct dirent const *dp;
+  struct stat st;
+  char *file_name = NULL;
+  size_t subdirs_alloc = 0;
+  int fd = openat (parent_fd, dir->name,
+                   (O_RDONLY | O_DIRECTORY | O_NOCTTY | O_NOFOLLOW
+                    | O_NONBLOCK | O_CLOEXEC));
+
+  if (fd < 0)
+    {
+      /* Like FTS_DNR.  */
+      dir->done = true;
+      if (excise_at (parent_fd, dir->name, dir->path, errno, x, true)
+          != RM_OK)
+        dir_failed (dir);
+      return false;
+    }
+
+  if (fstat (fd, &st) != 0)
+    {
+      error (0, errno, _("cannot remove %s"), quote (dir->path));
+      close (fd);
+      dir->done = true;
+      dir_failed (dir);
+      return false;
+    }
+  dir->dev = st.st_dev;
+  dir->ino = st.st_ino;
+
+  if (dir_cycle (dir))
+    {
+      /* Like FTS_DC: the directory containing this one then fails to
+         be removed, as it is not empty.  */
+      emit_cycle_warning (dir->path);
+      close (fd);
+      dir->done = true;
+      dir_failed (NULL);
+      return false;
+    }
+
+  if (x->one_file_system && dir->dev != dir->root_dev)
+    {
+      /* As with fts's FTS_XDEV, do not descend into a directory on
+         another file system.  rm_fts removes it only if empty.  */
+      close (fd);
+      dir->done = true;
+      if (is_empty_dir (parent_fd, dir->name))
+        {
+          if (excise_at (parent_fd, dir->name, dir->path, 0, x, true)
+              != RM_OK)
+            dir_failed (dir);
+        }
+      else
+        {
+          error (0, 0, _("skipping %s, since it's on a different device"),
+                 quote (dir->path));
+          dir_failed (dir);
+        }
+      return false;
+    }
+
+  dir->dirp = fdopendir (fd);
+  if (! dir->dirp)
+    {
+      int err = errno;
+      close (fd);
+      dir->done = true;
+      if (excise_at (parent_fd, dir->name, dir->path, err, x, true)
+          != RM_OK)
+        dir_failed (dir);
+      return false;
+    }
+  dir->fd = fd;
+
+  while (true)
+    {
+      bool is_dir;
+
+      errno = 0;
+      dp = readdir_ignoring_dot_and_dotdot (dir->dirp);
+      if (! dp)
+        break;
+
+      is_dir = (D_TYPE (dp) == DT_DIR
+                || (D_TYPE (dp) == DT_UNKNOWN
+                    && fstatat (fd, dp->d_name, &st,
+                                AT_SYMLINK_NOFOLLOW) == 0
+                    && S_ISDIR (st.st_mode)));
+      if (is_dir)
+        {
+          if (dir->n_subdirs == subdirs_alloc)
+            dir->subdirs = x2nrealloc (dir->subdirs, &subdirs_alloc,
+                                       sizeof *dir->subdirs);
+          dir->subdirs[dir->n_subdirs++] = xstrdup (dp->d_name);
+        }
+      else
+        {
+          free (file_name);
+          file_name = file_name_concat (dir->path, dp->d_name, NULL);
+          if (excise_at (fd, dp->d_name, file_name, 0, x, false) != RM_OK)
+            dir_failed (dir);
+        }
+    }
+  if (errno)
+    {
+      /* Like FTS_ERR.  */
+      error (0, errno, _("traversal failed: %s"), quote (dir->path));
+      dir_failed (dir);
+    }
+
+  free (file_name);
+  return true;
+}
+
+/* Close DIR, if it is open.  */
+static void
+close_dir (struct rm_dir *dir)
+{
+  if (dir->dirp)
+    closedir (dir->dirp);
+  else if (0 <= dir->fd)
+    close (dir->fd);
+  dir->dirp = NULL;
+  dir->fd = -1;
+}
+
+/* Release a reference to DIR.  If that was the last, remove DIR
+   unless something under it could not be removed, and release a
+   reference to its parent.  */
+static void
+release_dir (struct rm_dir *dir)
+{
+  struct rm_options const *x = dir_options;
+
+  while (dir)
+    {
+      struct rm_dir *parent = dir->parent;
+      bool last;
+      size_t i;
+
+      pthread_mutex_lock (&dir_lock);
+      last = --dir->refs == 0;
+      pthread_mutex_unlock (&dir_lock);
+      if (! last)
+        return;
+
+      close_dir (dir);
+      if (! dir->done && ! dir->failed
+          && excise_at (parent ? parent->fd : dir->parent_fd, dir->name,
+                        dir->path, 0, x, true) != RM_OK)
+        dir_failed (dir);
+
+      pthread_mutex_lock (&dir_lock);
+      if (dir->failed && parent)
+        parent->failed = true;
+      if (! parent)
+        {
+          if (dir->failed)
+            {
+              if (n_failed_ents == failed_ents_alloc)
+                failed_ents = x2nrealloc (failed_ents, &failed_ents_alloc,
+                                          sizeof *failed_ents);
+              failed_ents[n_failed_ents++] = dir->parent_ent;
+            }
+          dirs_unfinished--;
+          pthread_cond_broadcast (&dir_finished);
+        }
+      pthread_mutex_unlock (&dir_lock);
+
+      if (! parent)
+        {
+          close (dir->parent_fd);
+          free (dir->ancestors);
+        }
+      for (i = dir->next_subdir; i < dir->n_subdirs; i++)
+        free (dir->subdirs[i]);
+      free (dir->subdirs);
+      free (dir->name);
+      free (dir->path);
+      free (dir);
+      dir = parent;
+    }
+}
+
+/* Reopen the parent of DIR, which was closed while DIR was being
+   removed, via DIR's "..", and check that it is the same directory.
+   If that fails, give up on the directories above DIR that are
+   closed, along with DIR itself.  */
+static void
+reopen_parent (struct rm_dir *dir)
+{
+  struct rm_dir *parent = dir->parent;
+  struct stat st;
+  int fd = -1;
+
+  if (0 <= dir->fd)
+    {
+      fd = openat (dir->fd, "..",
+                   O_RDONLY | O_DIRECTORY | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+      if (0 <= fd
+          && ! (fstat (fd, &st) == 0
+                && st.st_dev == parent->dev && st.st_ino == parent->ino))
+        {
+          close (fd);
+          fd = -1;
+          errno = 0;
+        }
+      if (fd < 0)
+        error (0, errno, _("failed to return to %s"), quote (parent->path));
+    }
+
+  if (fd < 0)
+    {
+      dir->done = true;
+      dir_failed (dir);
+      while (parent->next_subdir < parent->n_subdirs)
+        free (parent->subdirs[parent->next_subdir++]);
+      return;
+    }
+  parent->fd = fd;
+}
+
+/* Return true if a subdirectory may be handed off to another thread,
+   because some may be idle.  */
+static bool
+dir_threads_idle (void)
+{
+  bool idle;
+  pthread_mutex_lock (&dir_lock);
+  idle = dirs_queued < dir_threads - 1;
+  pthread_mutex_unlock (&dir_lock);
+  return idle;
+}
+
+/* Remove TOP and everything under it, handing off subdirectories to
+   other threads when some are idle, and release TOP.  */
+static void
+remove_tree (struct rm_dir *top)
+{
+  struct rm_options const *x = dir_options;
+  struct rm_dir *dir = top;
+
+  if (! open_dir (top, top->parent ? top->parent->fd : top->parent_fd, x))
+    {
+      release_dir (top);
+      return;
+    }
+
+  while (true)
+    {
+      struct rm_dir *parent;
+
+      if (dir->next_subdir < dir->n_subdirs)
+        {
+          struct rm_dir *child = new_dir (dir,
+                                          dir->subdirs[dir->next_subdir++]);
+
+          pthread_mutex_lock (&dir_lock);
+          dir->refs++;
+          pthread_mutex_unlock (&dir_lock);
+
+          if (dir->depth < RM_KEEP_FDS && dir_threads_idle ())
+            {
+              pthread_mutex_lock (&dir_lock);
+              enqueue_dir (child);
+              pthread_mutex_unlock (&dir_lock);
+            }
+          else
+            {
+              child->depth = dir->depth + 1;
+              if (open_dir (child, dir->fd, x))
+                {
+                  if (RM_KEEP_FDS <= dir->depth)
+                    close_dir (dir);
+                  dir = child;
+                }
+              else
+                release_dir (child);
+            }
+          continue;
+        }
+
+      parent = dir == top ? NULL : dir->parent;
+      if (parent && parent->fd < 0)
+        reopen_parent (dir);
+      release_dir (dir);
+      if (! parent)
+        break;
+      dir = parent;
+    }
+}
+
+/* Remove queued directories forever.  */
+static void *
+dir_thread (void *arg _GL_UNUSED)
+{
+  while (true)
+    {
+      struct rm_dir *dir;
+
+      pthread_mutex_lock (&dir_lock);
+      while (! (dir = dequeue_dir ()))
+        pthread_cond_wait (&dir_queued, &dir_lock);
+      pthread_mutex_unlock (&dir_lock);
+
+      remove_tree (dir);
+    }
+  return NULL;
+}
+
+/* Start the threads that remove directories with options X, besides
+   the main thread, which removes them while waiting for them.  Use
+   fewer threads than X asks for if there may not be enough file
+   descriptors for them.  */
+static void
+start_dir_threads (struct rm_options const *x)
+{
+  size_t nthreads = MIN (x->nthreads, RM_THREADS_MAX);
+  size_t fds_per_thread = RM_KEEP_FDS + 2 * RM_QUEUE_PER_THREAD + 2;
+  struct rlimit rlim;
+  size_t i;
+
+  if (getrlimit (RLIMIT_NOFILE, &rlim) == 0 && rlim.rlim_cur != RLIM_INFINITY)
+    nthreads = MIN (nthreads,
+                    MAX (1, (rlim.rlim_cur / 2) / fds_per_thread));
+
+  dir_options = x;
+  dir_threads = 1;
+  for (i = 1; i < nthreads; i++)
+    {
+      pthread_t thread;
+      if (pthread_create (&thread, NULL, dir_thread, NULL) != 0)
+        break;
+      pthread_detach (thread);
+      dir_threads++;
+    }
+}
+
+/* Return true if rm_fts may hand off the directory ENT to a thread,
+   instead of descending into it, as X asks for threads and rm cannot
+   prompt.  */
+static bool
+hand_off_ok (FTS const *fts, FTSENT const *ent, struct rm_options const *x)
+{
+  return (1 < x->nthreads && x->recursive
+          && FTS_ROOTLEVEL < ent->fts_level
+          && (x->interactive == RMI_NEVER
+              || (x->interactive == RMI_SOMETIMES && ! x->stdin_tty))
+          && ! (x->one_file_system
+                && ent->fts_statp->st_dev != fts->fts_dev));
+}
+
+/* Hand off the directory ENT to a thread, to be removed along with
+   everything under it.  When the queue is full, first remove the
+   directory at its head.  Return false if ENT cannot be handed off.  */
+static bool
+hand_off (FTS *fts, FTSENT *ent, struct rm_options const *x)
+{
+  struct rm_dir *dir;
+  struct rm_dir *own_dir;
+  FTSENT const *p;
+  size_t i;
+  int parent_fd = dup (fts->fts_cwd_fd);
+
+  if (parent_fd < 0)
+    return false;
+
+  if (! dir_threads)
+    start_dir_threads (x);
+
+  dir = xzalloc (sizeof *dir);
+  dir->parent_fd = parent_fd;
+  dir->parent_ent = ent->fts_parent;
+  dir->n_ancestors = ent->fts_level - FTS_ROOTLEVEL;
+  dir->ancestors = xnmalloc (dir->n_ancestors, sizeof *dir->ancestors);
+  for (p = ent->fts_parent, i = 0; FTS_ROOTLEVEL <= p->fts_level;
+       p = p->fts_parent, i++)
+    {
+      dir->ancestors[i].st_dev = p->fts_statp->st_dev;
+      dir->ancestors[i].st_ino = p->fts_statp->st_ino;
+    }
+  dir->name = xstrdup (ent->fts_accpath);
+  dir->path = xstrdup (ent->fts_path);
+  dir->root_dev = fts->fts_dev;
+  dir->fd = -1;
+  dir->refs = 1;
+
+  pthread_mutex_lock (&dir_lock);
+  own_dir = (RM_QUEUE_PER_THREAD * dir_threads <= dirs_queued
+             ? dequeue_dir () : NULL);
+  enqueue_dir (dir);
+  dirs_unfinished++;
+  pthread_mutex_unlock (&dir_lock);
+
+  if (own_dir)
+    remove_tree (own_dir);
+  return true;
+}
+
+/* Remove queued directories until all those handed off have been
+   removed.  Mark the entries of rm_fts containing those that could
+   not be, so that they are not removed either.  Return the status of
+   the directories removed in threads since the last call.  */
+static enum RM_status
+wait_for_dirs (void)
+{
+  enum RM_status s;
+  size_t i;
+
+  pthread_mutex_lock (&dir_lock);
+  while (dirs_unfinished)
+    {
+      struct rm_dir *dir = dequeue_dir ();
+      if (dir)
+        {
+          pthread_mutex_unlock (&dir_lock);
+          remove_tree (dir);
+          pthread_mutex_lock (&dir_lock);
+        }
+      else
+        pthread_cond_wait (&dir_finished, &dir_lock);
+    }
+  for (i = 0; i < n_failed_ents; i++)
+    {
+      failed_ents[i]->fts_number = 1;
+      mark_ancestor_dirs (failed_ents[i]);
+    }
+  n_failed_ents = 0;
+  s = dirs_status;
+  dirs_status = RM_OK;
+  pthread_mutex_unlock (&dir_lock);
+  return s;
+}
+
 /* This function is called once for every file system object that fts
    encounters.  fts performs a depth-first traversal.
    A directory is usually processed twice, first with fts_info == FTS_D,
@@ -474,6 +1101,12 @@ rm_fts (FTS *fts, FTSENT *ent, struct rm_options const *x)
             s = excise (fts, ent, x, true);
             fts_skip_tree (fts, ent);
           }
+        else if (s == RM_OK && hand_off_ok (fts, ent, x)
+                 && hand_off (fts, ent, x))
+          {
+            /* A thread removes the directory and its contents.  */
+            fts_skip_tree (fts, ent);
+          }
 
         if (s != RM_OK)
           {
@@ -570,12 +1203,26 @@ rm (char *const *file, struct rm_options const *x)
               break;
             }
 
+          /* Finish removing the directories handed off to threads
+             before removing any directory containing them.  */
+          if (ent->fts_info == FTS_DP && dir_threads)
+            {
+              enum RM_status dirs_s = wait_for_dirs ();
+              UPDATE_STATUS (rm_status, dirs_s);
+            }
+
           enum RM_status s = rm_fts (fts, ent, x);
 
           assert (VALID_STATUS (s));
           UPDATE_STATUS (rm_status, s);
         }
 
+      if (dir_threads)
+        {
+          enum RM_status dirs_s = wait_for_dirs ();
+          UPDATE_STATUS (rm_status, dirs_s);
+        }
+
       if (fts_close (fts) != 0)
         {
           error (0, errno, _("fts_close failed"));
@@ -62,6 +62,11 @@ struct rm_options
   /* If true, display the name of each file removed.  */
   bool verbose;
 
+  /* The number of threads with which to remove the directories found
+     when removing recursively, or 0 or 1 to remove them one at a time.
+     Threads are used only when rm cannot prompt.  */
+  size_t nthreads;
+
   /* If true, treat the failure by the rm function to restore the
      current working directory as a fatal error.  I.e., if this field
      is true and the rm function cannot restore cwd, it must exit with
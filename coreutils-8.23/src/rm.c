@@ -31,6 +31,7 @@
 #include "quotearg.h"
 #include "remove.h"
 #include "root-dev-ino.h"
+#include "xstrtol.h"
 #include "yesno.h"
 #include "priv-set.h"
 
@@ -50,6 +51,7 @@ enum
   INTERACTIVE_OPTION = CHAR_MAX + 1,
   ONE_FILE_SYSTEM,
   NO_PRESERVE_ROOT,
+  PARALLEL_OPTION,
   PRESERVE_ROOT,
   PRESUME_INPUT_TTY_OPTION
 };
@@ -68,6 +70,7 @@ static struct option const long_opts[] =
 
   {"one-file-system", no_argument, NULL, ONE_FILE_SYSTEM},
   {"no-preserve-root", no_argument, NULL, NO_PRESERVE_ROOT},
+  {"parallel", required_argument, NULL, PARALLEL_OPTION},
   {"preserve-root", no_argument, NULL, PRESERVE_ROOT},
 
   /* This is solely for testing.  Do not document.  */
@@ -154,6 +157,8 @@ Remove (unlink) the FILE(s).\n\
       fputs (_("\
       --no-preserve-root  do not treat '/' specially\n\
       --preserve-root   do not remove '/' (default)\n\
+      --parallel=N      with -r, remove files in up to N threads, unless\n\
+                          rm may prompt\n\
   -r, -R, --recursive   remove directories and their contents recursively\n\
   -d, --dir             remove empty directories\n\
   -v, --verbose         explain what is being done\n\
@@ -195,6 +200,7 @@ rm_option_init (struct rm_options *x)
   x->recursive = false;
   x->root_dev_ino = NULL;
   x->stdin_tty = isatty (STDIN_FILENO);
+  x->nthreads = 1;
   x->verbose = false;
 
   /* Since this program exits immediately after calling 'rm', rm need not
@@ -296,6 +302,20 @@ main (int argc, char **argv)
           preserve_root = true;
           break;
 
+        case PARALLEL_OPTION:
+          {
+            unsigned long int n;
+            enum strtol_error e = xstrtoul (optarg, NULL, 10, &n, "");
+            if (e == LONGINT_OVERFLOW || SIZE_MAX < n)
+              x.nthreads = SIZE_MAX;
+            else if (e != LONGINT_OK || n == 0)
+              error (EXIT_FAILURE, 0, _("invalid number of threads: %s"),
+                     quote (optarg));
+            else
+              x.nthreads = n;
+          }
+          break;
+
         case PRESUME_INPUT_TTY_OPTION:
           x.stdin_tty = true;
           break;
@@ -139,7 +139,7 @@ src_libsinglebin_dirname_a_CFLAGS = "-Dmain=_single_binary_main_dirname(int, cha
 # Command du
 noinst_LIBRARIES += src/libsinglebin_du.a
 src_libsinglebin_du_a_SOURCES = src/du.c
-src_libsinglebin_du_a_ldadd =   $(LIBICONV)
+src_libsinglebin_du_a_ldadd =   $(LIBICONV)  $(LIB_PTHREAD)
 src_libsinglebin_du_a_CFLAGS = "-Dmain=_single_binary_main_du(int, char**)  ATTRIBUTE_NORETURN; int _single_binary_main_du"  -Dusage=_usage_du $(src_coreutils_CFLAGS)
 # Command echo
 noinst_LIBRARIES += src/libsinglebin_echo.a
@@ -223,7 +223,7 @@ src_libsinglebin_ls_a_CFLAGS = "-Dmain=_single_binary_main_ls(int, char**)  ATTR
 # Command md5sum
 noinst_LIBRARIES += src/libsinglebin_md5sum.a
 src_libsinglebin_md5sum_a_SOURCES = src/md5sum.c
-src_libsinglebin_md5sum_a_ldadd =   $(LIB_CRYPTO)
+src_libsinglebin_md5sum_a_ldadd =   $(LIB_CRYPTO)  $(LIB_PTHREAD)
 src_libsinglebin_md5sum_a_CFLAGS = "-Dmain=_single_binary_main_md5sum(int, char**)  ATTRIBUTE_NORETURN; int _single_binary_main_md5sum"  -Dusage=_usage_md5sum $(src_coreutils_CFLAGS)
 src_libsinglebin_md5sum_a_CPPFLAGS =   -DHASH_ALGO_MD5=1 $(AM_CPPFLAGS)
 # Command mkdir
@@ -331,31 +331,31 @@ src_libsinglebin_seq_a_CFLAGS = "-Dmain=_single_binary_main_seq(int, char**)  AT
 # Command sha1sum
 noinst_LIBRARIES += src/libsinglebin_sha1sum.a
 src_libsinglebin_sha1sum_a_SOURCES =   src/md5sum.c
-src_libsinglebin_sha1sum_a_ldadd =   $(LIB_CRYPTO)
+src_libsinglebin_sha1sum_a_ldadd =   $(LIB_CRYPTO)  $(LIB_PTHREAD)
 src_libsinglebin_sha1sum_a_CFLAGS = "-Dmain=_single_binary_main_sha1sum(int, char**)  ATTRIBUTE_NORETURN; int _single_binary_main_sha1sum"  -Dusage=_usage_sha1sum $(src_coreutils_CFLAGS)
 src_libsinglebin_sha1sum_a_CPPFLAGS =   -DHASH_ALGO_SHA1=1 $(AM_CPPFLAGS)
 # Command sha224sum
 noinst_LIBRARIES += src/libsinglebin_sha224sum.a
 src_libsinglebin_sha224sum_a_SOURCES =   src/md5sum.c
-src_libsinglebin_sha224sum_a_ldadd =   $(LIB_CRYPTO)
+src_libsinglebin_sha224sum_a_ldadd =   $(LIB_CRYPTO)  $(LIB_PTHREAD)
 src_libsinglebin_sha224sum_a_CFLAGS = "-Dmain=_single_binary_main_sha224sum(int, char**)  ATTRIBUTE_NORETURN; int _single_binary_main_sha224sum"  -Dusage=_usage_sha224sum $(src_coreutils_CFLAGS)
 src_libsinglebin_sha224sum_a_CPPFLAGS =   -DHASH_ALGO_SHA224=1 $(AM_CPPFLAGS)
 # Command sha256sum
 noinst_LIBRARIES += src/libsinglebin_sha256sum.a
 src_libsinglebin_sha256sum_a_SOURCES =   src/md5sum.c
-src_libsinglebin_sha256sum_a_ldadd =   $(LIB_CRYPTO)
+src_libsinglebin_sha256sum_a_ldadd =   $(LIB_CRYPTO)  $(LIB_PTHREAD)
 src_libsinglebin_sha256sum_a_CFLAGS = "-Dmain=_single_binary_main_sha256sum(int, char**)  ATTRIBUTE_NORETURN; int _single_binary_main_sha256sum"  -Dusage=_usage_sha256sum $(src_coreutils_CFLAGS)
 src_libsinglebin_sha256sum_a_CPPFLAGS =   -DHASH_ALGO_SHA256=1 $(AM_CPPFLAGS)
 # Command sha384sum
 noinst_LIBRARIES += src/libsinglebin_sha384sum.a
 src_libsinglebin_sha384sum_a_SOURCES =   src/md5sum.c
-src_libsinglebin_sha384sum_a_ldadd =   $(LIB_CRYPTO)
+src_libsinglebin_sha384sum_a_ldadd =   $(LIB_CRYPTO)  $(LIB_PTHREAD)
 src_libsinglebin_sha384sum_a_CFLAGS = "-Dmain=_single_binary_main_sha384sum(int, char**)  ATTRIBUTE_NORETURN; int _single_binary_main_sha384sum"  -Dusage=_usage_sha384sum $(src_coreutils_CFLAGS)
 src_libsinglebin_sha384sum_a_CPPFLAGS =   -DHASH_ALGO_SHA384=1 $(AM_CPPFLAGS)
 # Command sha512sum
 noinst_LIBRARIES += src/libsinglebin_sha512sum.a
 src_libsinglebin_sha512sum_a_SOURCES =   src/md5sum.c
-src_libsinglebin_sha512sum_a_ldadd =   $(LIB_CRYPTO)
+src_libsinglebin_sha512sum_a_ldadd =   $(LIB_CRYPTO)  $(LIB_PTHREAD)
 src_libsinglebin_sha512sum_a_CFLAGS = "-Dmain=_single_binary_main_sha512sum(int, char**)  ATTRIBUTE_NORETURN; int _single_binary_main_sha512sum"  -Dusage=_usage_sha512sum $(src_coreutils_CFLAGS)
 src_libsinglebin_sha512sum_a_CPPFLAGS =   -DHASH_ALGO_SHA512=1 $(AM_CPPFLAGS)
 # Command shred
@@ -402,7 +402,7 @@ src_libsinglebin_tac_a_CFLAGS = "-Dmain=_single_binary_main_tac(int, char**)  AT
 # Command tail
 noinst_LIBRARIES += src/libsinglebin_tail.a
 src_libsinglebin_tail_a_SOURCES = src/tail.c
-src_libsinglebin_tail_a_ldadd =   $(LIB_NANOSLEEP)
+src_libsinglebin_tail_a_ldadd =   $(LIB_NANOSLEEP)  $(LIB_PTHREAD)
 src_libsinglebin_tail_a_CFLAGS = "-Dmain=_single_binary_main_tail(int, char**)  ATTRIBUTE_NORETURN; int _single_binary_main_tail"  -Dusage=_usage_tail $(src_coreutils_CFLAGS)
 # Command tee
 noinst_LIBRARIES += src/libsinglebin_tee.a
@@ -469,6 +469,7 @@ src_libsinglebin_vdir_a_CFLAGS = "-Dmain=_single_binary_main_vdir(int, char**)
 # Command wc
 noinst_LIBRARIES += src/libsinglebin_wc.a
 src_libsinglebin_wc_a_SOURCES = src/wc.c
+src_libsinglebin_wc_a_ldadd =   $(LIB_PTHREAD)
 src_libsinglebin_wc_a_CFLAGS = "-Dmain=_single_binary_main_wc(int, char**)  ATTRIBUTE_NORETURN; int _single_binary_main_wc"  -Dusage=_usage_wc $(src_coreutils_CFLAGS)
 # Command whoami
 noinst_LIBRARIES += src/libsinglebin_whoami.a
@@ -29,11 +29,17 @@
 #include <sys/wait.h>
 #include <signal.h>
 #include <assert.h>
+#if HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
+#include <math.h>
 #include "system.h"
 #include "argmatch.h"
 #include "error.h"
 #include "fadvise.h"
 #include "filevercmp.h"
+#include "full-read.h"
+#include "full-write.h"
 #include "hard-locale.h"
 #include "hash.h"
 #include "heap.h"
@@ -53,6 +59,7 @@
 #include "xmemcoll.h"
 #include "xnanosleep.h"
 #include "xstrtol.h"
+#include "xvasprintf.h"
 
 #ifndef RLIMIT_DATA
 struct rlimit { size_t rlim_cur; };
@@ -119,9 +126,11 @@ struct rlimit { size_t rlim_cur; };
 enum { SUBTHREAD_LINES_HEURISTIC = 128 * 1024 };
 verify (4 <= SUBTHREAD_LINES_HEURISTIC);
 
-/* The number of threads after which there are
-   diminishing performance gains.  */
-enum { DEFAULT_MAX_THREADS = 8 };
+/* The default upper limit on the number of threads.  Leaf sorts are
+   only split across threads when they have at least
+   SUBTHREAD_LINES_HEURISTIC lines, so small inputs do not pay for a
+   large limit; large inputs can use all processors of a big machine.  */
+enum { DEFAULT_MAX_THREADS = 64 };
 
 /* Exit statuses.  */
 enum
@@ -178,6 +187,18 @@ enum blanktype { bl_start, bl_end, bl_both };
 /* The character marking end of line. Default to \n. */
 static char eolchar = '\n';
 
+/* A normalized form of a line's first key, which orders lines
+   without reparsing the key when the first key is a -n, -h, -M or -g
+   key.  See keycache_compare.  */
+union keycache
+{
+  intmax_t num;			/* -n, -h or -M key, or KEYCACHE_INVALID. */
+  double gnum;			/* -g key, or NaN if not a number. */
+};
+
+/* The value of keycache.num when the key cannot be normalized.  */
+#define KEYCACHE_INVALID INTMAX_MIN
+
 /* Lines are held in core as counted strings. */
 struct line
 {
@@ -185,6 +206,7 @@ struct line
   size_t length;		/* Length including final newline. */
   char *keybeg;			/* Start of first key. */
   char *keylim;			/* Limit of first key. */
+  union keycache keycache;	/* Normalized first key, if first_key_cached. */
 };
 
 /* Input buffers. */
@@ -317,10 +339,17 @@ static struct month monthtab[] =
    a longer line is seen, this value is increased.  */
 static size_t merge_buffer_size = MAX (MIN_MERGE_BUFFER_SIZE, 256 * 1024);
 
+/* Lock for merge_buffer_size, which concurrent merges may update.  */
+static pthread_mutex_t merge_buffer_size_lock = PTHREAD_MUTEX_INITIALIZER;
+
 /* The approximate maximum number of bytes of main memory to use, as
    specified by the user.  Zero if the user has not specified a size.  */
 static size_t sort_size;
 
+/* The number of merges that are running concurrently and that share
+   the SORT_SIZE memory budget between them.  */
+static size_t merge_jobs = 1;
+
 /* The initial allocation factor for non-regular files.
    This is used, e.g., when reading from a pipe.
    Don't make it too big, since it is multiplied by ~130 to
@@ -357,15 +386,35 @@ static int tab = TAB_DEFAULT;
    Only the last of a sequence of equal lines will be output. */
 static bool unique;
 
+/* With -u, output the distinct lines in any order.  */
+static bool unordered;
+
+/* If TOP_SELECTED, output only the first TOP_LINES lines of the sorted
+   output, or the last TOP_LINES if TOP_FROM_BOTTOM.  */
+static bool top_selected;
+static bool top_from_bottom;
+static size_t top_lines;
+
 /* Nonzero if any of the input files are the standard input. */
 static bool have_read_stdin;
 
 /* List of key field comparisons to be tried.  */
 static struct keyfield *keylist;
 
+/* Nonzero if fillbuf fills in the keycache member of each line.  */
+static bool first_key_cached;
+
+/* Nonzero if lines are compared as plain byte strings, so that they
+   can be sorted with radix_sort.  */
+static bool bytewise_order;
+
 /* Program used to (de)compress temp files.  Must accept -d.  */
 static char const *compress_program;
 
+/* Compress temp files with the built-in codec, in threads rather
+   than in child processes.  */
+static bool compress_builtin;
+
 /* Annotate the output with extra info to aid the user.  */
 static bool debug;
 
@@ -476,6 +525,7 @@ Other options:\n\
 \n\
       --compress-program=PROG  compress temporaries with PROG;\n\
                               decompress them with PROG -d\n\
+      --compress-temp=fast  compress temporaries with a built-in fast method\n\
 "), stdout);
       fputs (_("\
       --debug               annotate the part of the line used to sort,\n\
@@ -493,6 +543,11 @@ Other options:\n\
   -s, --stable              stabilize sort by disabling last-resort comparison\
 \n\
   -S, --buffer-size=SIZE    use SIZE for main memory buffer\n\
+"), stdout);
+      fputs (_("\
+      --top=K               output only the first K lines of the result,\n\
+                              using memory proportional to K\n\
+      --bottom=K            output only the last K lines of the result\n\
 "), stdout);
       printf (_("\
   -t, --field-separator=SEP  use SEP instead of non-blank to blank transition\n\
@@ -502,6 +557,8 @@ Other options:\n\
   -u, --unique              with -c, check for strict ordering;\n\
                               without -c, output only the first of an equal run\
 \n\
+      --unordered           with -u, output the distinct lines in any order;\n\
+                              this avoids sorting them\n\
 "), DEFAULT_TMPDIR);
       fputs (_("\
   -z, --zero-terminated     line delimiter is NUL, not newline\n\
@@ -543,12 +600,17 @@ enum
 {
   CHECK_OPTION = CHAR_MAX + 1,
   COMPRESS_PROGRAM_OPTION,
+  COMPRESS_TEMP_OPTION,
   DEBUG_PROGRAM_OPTION,
   FILES0_FROM_OPTION,
   NMERGE_OPTION,
   RANDOM_SOURCE_OPTION,
   SORT_OPTION,
-  PARALLEL_OPTION
+  PARALLEL_OPTION,
+  UNORDERED_OPTION,
+  TOP_OPTION,
+  BOTTOM_OPTION,
+  CGROUP_ROOT_OPTION
 };
 
 static char const short_options[] = "-bcCdfghik:mMno:rRsS:t:T:uVy:z";
@@ -556,8 +618,10 @@ static char const short_options[] = "-bcCdfghik:mMno:rRsS:t:T:uVy:z";
 static struct option const long_options[] =
 {
   {"ignore-leading-blanks", no_argument, NULL, 'b'},
+  {"bottom", required_argument, NULL, BOTTOM_OPTION},
   {"check", optional_argument, NULL, CHECK_OPTION},
   {"compress-program", required_argument, NULL, COMPRESS_PROGRAM_OPTION},
+  {"compress-temp", required_argument, NULL, COMPRESS_TEMP_OPTION},
   {"debug", no_argument, NULL, DEBUG_PROGRAM_OPTION},
   {"dictionary-order", no_argument, NULL, 'd'},
   {"ignore-case", no_argument, NULL, 'f'},
@@ -580,9 +644,17 @@ static struct option const long_options[] =
   {"buffer-size", required_argument, NULL, 'S'},
   {"field-separator", required_argument, NULL, 't'},
   {"temporary-directory", required_argument, NULL, 'T'},
+  {"top", required_argument, NULL, TOP_OPTION},
   {"unique", no_argument, NULL, 'u'},
+  {"unordered", no_argument, NULL, UNORDERED_OPTION},
   {"zero-terminated", no_argument, NULL, 'z'},
   {"parallel", required_argument, NULL, PARALLEL_OPTION},
+
+  /* This is solely for testing.  Do not document.  */
+  /* It names a directory that stands for both /proc/self/cgroup, as
+     the file DIR/cgroup, and the cgroup file systems, so that the
+     default buffer size can be checked against fixture limits.  */
+  {"-cgroup-root", required_argument, NULL, CGROUP_ROOT_OPTION},
   {GETOPT_HELP_OPTION_DECL},
   {GETOPT_VERSION_OPTION_DECL},
   {NULL, 0, NULL, 0},
@@ -627,6 +699,15 @@ static char const sort_types[] =
 #undef  _st_
 };
 
+static char const *const compress_temp_args[] =
+{
+  "fast", NULL
+};
+static char const compress_temp_types[] =
+{
+  'f'
+};
+
 /* The set of signals that are caught.  */
 static sigset_t caught_signals;
 
@@ -667,6 +748,7 @@ struct tempnode
 {
   struct tempnode *volatile next;
   pid_t pid;     /* The subprocess PID; undefined if state == UNCOMPRESSED.  */
+  pthread_t thread; /* Likewise, the thread if compress_builtin.  */
   char state;
   char name[1];  /* Actual size is 1 + file name length.  */
 };
@@ -706,6 +788,9 @@ proctab_comparator (void const *e1, void const *e2)
 /* The number of unreaped child processes.  */
 static pid_t nprocs;
 
+/* The number of built-in compressor threads not yet joined.  */
+static size_t ncompressors;
+
 static bool delete_proc (pid_t);
 
 /* If PID is positive, wait for the child process with that PID to
@@ -802,13 +887,26 @@ reap_some (void)
   reap_exited ();
 }
 
-/* Reap all children, waiting if necessary.  */
+/* Reap all children, waiting if necessary.  Also wait for the
+   built-in compressor of any temporary file that was never reopened,
+   so that no compressor thread is left unjoined.  */
 
 static void
 reap_all (void)
 {
+  struct tempnode *node;
+
   while (0 < nprocs)
     reap (-1);
+
+  if (compress_builtin)
+    for (node = temphead; node; node = node->next)
+      if (node->state == UNREAPED)
+        {
+          pthread_join (node->thread, NULL);
+          node->state = REAPED;
+          ncompressors--;
+        }
 }
 
 /* Clean up any remaining temporary files.  */
@@ -1092,6 +1190,342 @@ pipe_fork (int pipefds[2], size_t tries)
 #endif
 }
 
+/* The built-in codec for temp files is a byte-oriented LZ77 variant
+   in the style of LZ4, which trades compression ratio for speed.
+   A compressed temp file is a sequence of frames, each holding one
+   block of at most CODEC_BLOCK_SIZE bytes of the uncompressed data:
+
+     4 bytes   length of the uncompressed block, little endian
+     4 bytes   length of the stored block, little endian
+     N bytes   the stored block
+
+   If the two lengths are equal, the block is stored uncompressed.
+   Otherwise it is a series of sequences, each made of a token byte,
+   whose high and low nibbles give the number of literal bytes and
+   the match length minus CODEC_MIN_MATCH, each extended by following
+   bytes while they are 255 if the nibble is 15; then the literal
+   bytes; then, except in the last sequence, a 2-byte little endian
+   offset back to the match.  Frames make it cheap for a reader to
+   find the next block without decoding the current one.  */
+
+enum { CODEC_BLOCK_SIZE = 64 * 1024 };
+enum { CODEC_HEADER_SIZE = 8 };
+enum { CODEC_MIN_MATCH = 4 };
+enum { CODEC_HASH_BITS = 12 };
+
+/* An upper bound on the size of a compressed block, before falling
+   back to storing it uncompressed.  */
+#define CODEC_BOUND(n) ((n) + (n) / 255 + 16)
+
+static inline uint32_t
+codec_get32 (unsigned char const *p)
+{
+  return p[0] | (p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static inline void
+codec_put32 (unsigned char *p, uint32_t v)
+{
+  p[0] = v;
+  p[1] = v >> 8;
+  p[2] = v >> 16;
+  p[3] = v >> 24;
+}
+
+/* Append the length LEN, less the 15 already in the token, to OUT.  */
+
+static inline unsigned char *
+codec_put_length (unsigned char *out, size_t len)
+{
+  for (len -= 15; 255 <= len; len -= 255)
+    *out++ = 255;
+  *out++ = len;
+  return out;
+}
+
+/* Append a sequence to OUT with the NLIT literal bytes LIT, followed
+   by a match of MATCHLEN bytes at OFFSET back, if MATCHLEN is not 0.
+   Return the new end of OUT.  */
+
+static unsigned char *
+codec_put_sequence (unsigned char *out, unsigned char const *lit,
+                    size_t nlit, size_t offset, size_t matchlen)
+{
+  size_t mlen = matchlen ? matchlen - CODEC_MIN_MATCH : 0;
+  *out++ = (MIN (nlit, 15) << 4) | MIN (mlen, 15);
+  if (15 <= nlit)
+    out = codec_put_length (out, nlit);
+  memcpy (out, lit, nlit);
+  out += nlit;
+  if (matchlen)
+    {
+      *out++ = offset;
+      *out++ = offset >> 8;
+      if (15 <= mlen)
+        out = codec_put_length (out, mlen);
+    }
+  return out;
+}
+
+/* Compress the N bytes of IN, where N <= CODEC_BLOCK_SIZE, into OUT,
+   which has room for CODEC_BOUND (N) bytes.  Return the compressed
+   size.  */
+
+static size_t
+codec_compress (unsigned char const *in, size_t n, unsigned char *out)
+{
+  uint32_t table[1 << CODEC_HASH_BITS];
+  unsigned char *o = out;
+  size_t anchor = 0;
+  size_t i = 0;
+
+  memset (table, 0, sizeof table);
+
+  while (i + CODEC_MIN_MATCH <= n)
+    {
+      uint32_t seq = codec_get32 (in + i);
+      uint32_t h = (seq * 2654435761u) >> (32 - CODEC_HASH_BITS);
+      size_t cand = table[h];
+      table[h] = i;
+
+      if (cand < i && codec_get32 (in + cand) == seq)
+        {
+          size_t len = CODEC_MIN_MATCH;
+          while (i + len < n && in[cand + len] == in[i + len])
+            len++;
+          o = codec_put_sequence (o, in + anchor, i - anchor, i - cand, len);
+          i += len;
+          anchor = i;
+        }
+      else
+        i++;
+    }
+
+  if (anchor < n)
+    o = codec_put_sequence (o, in + anchor, n - anchor, 0, 0);
+  return o - out;
+}
+
+/* Read a length extension from IN, which ends at LIM, into *LEN.
+   Return the new start of IN, or NULL if the data is corrupt.  */
+
+static unsigned char const *
+codec_get_length (unsigned char const *in, unsigned char const *lim,
+                  size_t *len)
+{
+  unsigned char b;
+  do
+    {
+      if (in == lim)
+        return NULL;
+      b = *in++;
+      *len += b;
+    }
+  while (b == 255);
+  return in;
+}
+
+/* Decompress the N bytes of IN into OUT, which has room for OUTSIZE
+   bytes.  Return true if that produced exactly OUTSIZE bytes.  */
+
+static bool
+codec_decompress (unsigned char const *in, size_t n,
+                  unsigned char *out, size_t outsize)
+{
+  unsigned char const *lim = in + n;
+  unsigned char *o = out;
+  unsigned char *olim = out + outsize;
+
+  while (in < lim)
+    {
+      unsigned char token = *in++;
+      size_t nlit = token >> 4;
+      size_t mlen = token & 15;
+      size_t offset;
+
+      if (nlit == 15 && ! (in = codec_get_length (in, lim, &nlit)))
+        return false;
+      if (lim - in < nlit || olim - o < nlit)
+        return false;
+      memcpy (o, in, nlit);
+      o += nlit;
+      in += nlit;
+
+      if (in == lim)
+        break;
+
+      if (lim - in < 2)
+        return false;
+      offset = in[0] | (in[1] << 8);
+      in += 2;
+      if (mlen == 15 && ! (in = codec_get_length (in, lim, &mlen)))
+        return false;
+      mlen += CODEC_MIN_MATCH;
+      if (offset == 0 || o - out < offset || olim - o < mlen)
+        return false;
+
+      /* The match may overlap the output, so copy bytewise.  */
+      for (; mlen; mlen--, o++)
+        *o = o[-offset];
+    }
+
+  return o == olim;
+}
+
+/* Arguments of a codec thread.  */
+struct codec_args
+{
+  int in;			/* Read from this file descriptor.  */
+  int out;			/* Write to this file descriptor.  */
+  char *name;			/* The temp file's name, for diagnostics.  */
+};
+
+/* Compress from ARGS->in to the temp file ARGS->out, a frame per
+   block, and close both.  */
+
+static void *
+compress_thread (void *data)
+{
+  struct codec_args *args = data;
+  unsigned char *in = xmalloc (CODEC_BLOCK_SIZE);
+  unsigned char *frame = xmalloc (CODEC_HEADER_SIZE
+                                  + CODEC_BOUND (CODEC_BLOCK_SIZE));
+  size_t n;
+
+  do
+    {
+      size_t stored;
+
+      n = full_read (args->in, in, CODEC_BLOCK_SIZE);
+      if (n < CODEC_BLOCK_SIZE && errno != 0)
+        die (_("read failed"), args->name);
+      if (n == 0)
+        break;
+
+      stored = codec_compress (in, n, frame + CODEC_HEADER_SIZE);
+      if (n <= stored)
+        {
+          memcpy (frame + CODEC_HEADER_SIZE, in, n);
+          stored = n;
+        }
+      codec_put32 (frame, n);
+      codec_put32 (frame + 4, stored);
+      if (full_write (args->out, frame, CODEC_HEADER_SIZE + stored)
+          != CODEC_HEADER_SIZE + stored)
+        die (_("write failed"), args->name);
+    }
+  while (n == CODEC_BLOCK_SIZE);
+
+  if (close (args->out) != 0)
+    die (_("close failed"), args->name);
+  close (args->in);
+  free (frame);
+  free (in);
+  free (args->name);
+  free (args);
+  return NULL;
+}
+
+/* Decompress the temp file ARGS->in to ARGS->out, and close both.
+   Stop quietly if the reader closes its end early.  */
+
+static void *
+decompress_thread (void *data)
+{
+  struct codec_args *args = data;
+  unsigned char *out = xmalloc (CODEC_BLOCK_SIZE);
+  unsigned char *frame = xmalloc (CODEC_BOUND (CODEC_BLOCK_SIZE));
+  unsigned char header[CODEC_HEADER_SIZE];
+  size_t n;
+
+  while ((n = full_read (args->in, header, sizeof header)) != 0)
+    {
+      size_t rawsize = codec_get32 (header);
+      size_t stored = codec_get32 (header + 4);
+      bool ok;
+
+      if (n != sizeof header
+          || ! (0 < rawsize && rawsize <= CODEC_BLOCK_SIZE)
+          || CODEC_BOUND (rawsize) < stored)
+        break;
+      if (full_read (args->in, frame, stored) != stored)
+        break;
+      if (stored == rawsize)
+        {
+          memcpy (out, frame, rawsize);
+          ok = true;
+        }
+      else
+        ok = codec_decompress (frame, stored, out, rawsize);
+      if (! ok)
+        break;
+      if (full_write (args->out, out, rawsize) != rawsize)
+        {
+          if (errno == EPIPE)
+            n = 0;
+          break;
+        }
+    }
+
+  if (n != 0)
+    die (_("corrupt or unreadable temporary file"), args->name);
+
+  close (args->out);
+  close (args->in);
+  free (frame);
+  free (out);
+  free (args->name);
+  free (args);
+  return NULL;
+}
+
+/* Start a thread running ROUTINE, a codec thread from file descriptor
+   IN to OUT for the temp file NAME, and store its ID into *THREAD.
+   Return true if successful.  The thread blocks the caught signals,
+   and so gets EPIPE rather than SIGPIPE if its reader goes away.  */
+
+static bool
+start_codec_thread (pthread_t *thread, void *(*routine) (void *),
+                    int in, int out, char const *name)
+{
+  struct codec_args *args = xmalloc (sizeof *args);
+  sigset_t oldset;
+  int err;
+
+  args->in = in;
+  args->out = out;
+  args->name = xstrdup (name);
+
+  /* The new thread inherits this thread's signal mask.  */
+  pthread_sigmask (SIG_BLOCK, &caught_signals, &oldset);
+  err = pthread_create (thread, NULL, routine, args);
+  pthread_sigmask (SIG_SETMASK, &oldset, NULL);
+
+  if (err != 0)
+    {
+      free (args->name);
+      free (args);
+      errno = err;
+      return false;
+    }
+  return true;
+}
+
+/* Wait for the compressor of TEMP to finish.  */
+
+static void
+wait_compressor (struct tempnode *temp)
+{
+  if (compress_builtin)
+    {
+      pthread_join (temp->thread, NULL);
+      temp->state = REAPED;
+      ncompressors--;
+    }
+  else
+    wait_proc (temp->pid);
+}
+
 /* Create a temporary file and, if asked for, start a compressor
    to that file.  Set *PFP to the file handle and return
    the address of the new temp node.  If the creation
@@ -1108,7 +1542,39 @@ maybe_create_temp (FILE **pfp, bool survive_fd_exhaustion)
 
   node->state = UNCOMPRESSED;
 
-  if (compress_program)
+  if (compress_builtin)
+    {
+      int pipefds[2];
+
+      /* As pipe_fork does with subprocesses, allow at most NMERGE + 2
+         compressors.  Join the oldest, whose file is complete, before
+         starting another.  */
+      if (nmerge + 1 < ncompressors)
+        {
+          struct tempnode *oldest;
+          for (oldest = temphead; oldest->state != UNREAPED;
+               oldest = oldest->next)
+            continue;
+          wait_compressor (oldest);
+        }
+
+      if (pipe (pipefds) == 0)
+        {
+          if (start_codec_thread (&node->thread, compress_thread,
+                                  pipefds[0], tempfd, node->name))
+            {
+              node->state = UNREAPED;
+              ncompressors++;
+              tempfd = pipefds[1];
+            }
+          else
+            {
+              close (pipefds[0]);
+              close (pipefds[1]);
+            }
+        }
+    }
+  else if (compress_program)
     {
       int pipefds[2];
 
@@ -1164,12 +1630,44 @@ open_temp (struct tempnode *temp)
   FILE *fp = NULL;
 
   if (temp->state == UNREAPED)
-    wait_proc (temp->pid);
+    wait_compressor (temp);
 
   tempfd = open (temp->name, O_RDONLY);
   if (tempfd < 0)
     return NULL;
 
+  if (compress_builtin)
+    {
+      pthread_t thread;
+
+      if (pipe (pipefds) < 0)
+        {
+          close (tempfd);
+          return NULL;
+        }
+      if (! start_codec_thread (&thread, decompress_thread,
+                                tempfd, pipefds[1], temp->name))
+        {
+          /* Like a failed fork, let the caller merge fewer files.  */
+          close (tempfd);
+          close (pipefds[0]);
+          close (pipefds[1]);
+          errno = EMFILE;
+        }
+      else
+        {
+          pthread_detach (thread);
+          fp = fdopen (pipefds[0], "r");
+          if (! fp)
+            {
+              int saved_errno = errno;
+              close (pipefds[0]);
+              errno = saved_errno;
+            }
+        }
+      return fp;
+    }
+
   pid_t child = pipe_fork (pipefds, MAX_FORK_TRIES_DECOMPRESS);
 
   switch (child)
@@ -1238,7 +1736,7 @@ zaptemp (char const *name)
     continue;
 
   if (node->state == UNREAPED)
-    wait_proc (node->pid);
+    wait_compressor (node);
 
   /* Unlink the temporary file in a critical section to avoid races.  */
   next = node->next;
@@ -1425,6 +1923,19 @@ specify_sort_size (int oi, char c, char const *s)
   xstrtol_fatal (e, oi, c, long_options, s);
 }
 
+/* Specify the number of lines to output with --top or --bottom.  */
+static size_t
+specify_top_lines (int oi, char c, char const *s)
+{
+  uintmax_t n;
+  enum strtol_error e = xstrtoumax (s, NULL, 10, &n, "");
+  if (e == LONGINT_OVERFLOW || (e == LONGINT_OK && SIZE_MAX < n))
+    return SIZE_MAX;
+  if (e != LONGINT_OK)
+    xstrtol_fatal (e, oi, c, long_options, s);
+  return n;
+}
+
 /* Specify the number of threads to spawn during internal sort.  */
 static size_t
 specify_nthreads (int oi, char c, char const *s)
@@ -1442,6 +1953,132 @@ specify_nthreads (int oi, char c, char const *s)
   return nthreads;
 }
 
+/* If nonnull, the directory to read cgroup information from, instead
+   of /proc/self/cgroup and /sys/fs/cgroup.  */
+static char const *cgroup_root;
+
+/* Read the number of bytes in the cgroup control file DIR/FILE into
+   *VALUE.  Return false if that fails or if there is no limit.  */
+
+static bool
+read_cgroup_value (char const *dir, char const *file, uintmax_t *value)
+{
+  char *name = xasprintf ("%s/%s", dir, file);
+  FILE *fp = fopen (name, "r");
+  char buf[INT_BUFSIZE_BOUND (uintmax_t) + 1];
+  bool ok = false;
+
+  free (name);
+  if (fp)
+    {
+      /* The number is followed by a newline, which xstrtoumax would
+         reject as a suffix.  "max" means there is no limit.  */
+      char *end;
+      if (fgets (buf, sizeof buf, fp))
+        ok = (xstrtoumax (buf, &end, 10, value, NULL) == LONGINT_OK
+              && (*end == '\n' || *end == '\0'));
+      fclose (fp);
+    }
+  return ok;
+}
+
+/* Return true if the comma-separated list of cgroup v1 CONTROLLERS
+   includes the memory controller.  */
+
+static bool _GL_ATTRIBUTE_PURE
+has_memory_controller (char const *controllers)
+{
+  while (*controllers)
+    {
+      size_t len = strcspn (controllers, ",");
+      if (len == 6 && strncmp (controllers, "memory", 6) == 0)
+        return true;
+      controllers += len + (controllers[len] == ',');
+    }
+  return false;
+}
+
+/* If this process's memory cgroup has a limit lower than *LIMIT,
+   store it into *LIMIT and the cgroup's memory usage into *USAGE.
+   Inside a container, the physical memory reported by physmem_total
+   and physmem_available is that of the host, and exceeding the
+   cgroup's limit gets sort killed.
+
+   Both cgroup v2 (memory.max) and v1 (memory.limit_in_bytes) are
+   handled.  Limits apply to the whole subtree of a cgroup, so use the
+   lowest limit of the cgroup and its ancestors that are visible.  */
+
+static void
+cgroup_memory (double *limit, double *usage)
+{
+  char *cgroup_file = (cgroup_root
+                       ? xasprintf ("%s/cgroup", cgroup_root)
+                       : xstrdup ("/proc/self/cgroup"));
+  FILE *fp = fopen (cgroup_file, "r");
+  char *line = NULL;
+  size_t linesize = 0;
+
+  free (cgroup_file);
+  if (! fp)
+    return;
+
+  while (getline (&line, &linesize, fp) > 0)
+    {
+      /* Each line is ID:CONTROLLERS:PATH.  */
+      char *controllers = strchr (line, ':');
+      char *path = controllers ? strchr (controllers + 1, ':') : NULL;
+      char *root;
+      char const *limit_file;
+      char const *usage_file;
+
+      if (! path)
+        continue;
+      *path++ = '\0';
+      *controllers++ = '\0';
+      path[strcspn (path, "\n")] = '\0';
+
+      if (STREQ (line, "0") && ! *controllers)
+        {
+          root = xstrdup (cgroup_root ? cgroup_root : "/sys/fs/cgroup");
+          limit_file = "memory.max";
+          usage_file = "memory.current";
+        }
+      else if (has_memory_controller (controllers))
+        {
+          root = xasprintf ("%s/memory",
+                            cgroup_root ? cgroup_root : "/sys/fs/cgroup");
+          limit_file = "memory.limit_in_bytes";
+          usage_file = "memory.usage_in_bytes";
+        }
+      else
+        continue;
+
+      /* Visit PATH and each of its ancestors.  */
+      while (true)
+        {
+          char *dir = xasprintf ("%s%s", root, path);
+          uintmax_t lim;
+          uintmax_t use;
+
+          if (read_cgroup_value (dir, limit_file, &lim) && lim < *limit)
+            {
+              *limit = lim;
+              *usage = read_cgroup_value (dir, usage_file, &use) ? use : 0;
+            }
+          free (dir);
+
+          char *slash = strrchr (path, '/');
+          if (! slash || ! path[1])
+            break;
+          slash[slash == path] = '\0';
+        }
+      free (root);
+    }
+
+  free (line);
+  fclose (fp);
+}
+
 /* Return the default sort size.  */
 static size_t
 default_sort_size (void)
@@ -1474,6 +2111,14 @@ default_sort_size (void)
      is greater.  */
   double avail = physmem_available ();
   double total = physmem_total ();
+  double cg_limit = total;
+  double cg_usage = 0;
+  cgroup_memory (&cg_limit, &cg_usage);
+  if (cg_limit < total)
+    {
+      total = cg_limit;
+      avail = MIN (avail, cg_limit - MIN (cg_usage, cg_limit));
+    }
   double mem = MAX (avail, total / 8);
 
   /* Leave a 1/4 margin for physical memory.  */
@@ -1737,6 +2382,35 @@ limfield (struct line const *line, struct keyfield const *key)
   return ptr;
 }
 
+static union keycache keycache_init (char *, char *,
+                                     struct keyfield const *);
+
+/* Precompute the position of the first key KEY of LINE, whose
+   delimiter has been replaced by NUL, for efficiency.  */
+
+static void
+find_first_key (struct line *line, struct keyfield const *key)
+{
+  char *line_start = line->text;
+
+  line->keylim = (key->eword == SIZE_MAX
+                  ? line->text + line->length - 1
+                  : limfield (line, key));
+
+  if (key->sword != SIZE_MAX)
+    line->keybeg = begfield (line, key);
+  else
+    {
+      if (key->skipsblanks)
+        while (blanks[to_uchar (*line_start)])
+          line_start++;
+      line->keybeg = line_start;
+    }
+
+  if (first_key_cached)
+    line->keycache = keycache_init (line->keybeg, line->keylim, key);
+}
+
 /* Fill BUF reading from FP, moving buf->left bytes from the end
    of buf->buf to the beginning first.  If EOF is reached and the
    file wasn't terminated by a newline, supply one.  Set up BUF's line
@@ -1749,11 +2423,15 @@ fillbuf (struct buffer *buf, FILE *fp, char const *file)
   struct keyfield const *key = keylist;
   char eol = eolchar;
   size_t line_bytes = buf->line_bytes;
-  size_t mergesize = merge_buffer_size - MIN_MERGE_BUFFER_SIZE;
+  size_t mergesize;
 
   if (buf->eof)
     return false;
 
+  pthread_mutex_lock (&merge_buffer_size_lock);
+  mergesize = merge_buffer_size - MIN_MERGE_BUFFER_SIZE;
+  pthread_mutex_unlock (&merge_buffer_size_lock);
+
   if (buf->used != buf->left)
     {
       memmove (buf->buf, buf->buf + buf->used - buf->left, buf->left);
@@ -1811,23 +2489,7 @@ fillbuf (struct buffer *buf, FILE *fp, char const *file)
               avail -= line_bytes;
 
               if (key)
-                {
-                  /* Precompute the position of the first key for
-                     efficiency.  */
-                  line->keylim = (key->eword == SIZE_MAX
-                                  ? p
-                                  : limfield (line, key));
-
-                  if (key->sword != SIZE_MAX)
-                    line->keybeg = begfield (line, key);
-                  else
-                    {
-                      if (key->skipsblanks)
-                        while (blanks[to_uchar (*line_start)])
-                          line_start++;
-                      line->keybeg = line_start;
-                    }
-                }
+                find_first_key (line, key);
 
               line_start = ptr;
             }
@@ -1842,7 +2504,10 @@ fillbuf (struct buffer *buf, FILE *fp, char const *file)
       if (buf->nlines != 0)
         {
           buf->left = ptr - line_start;
-          merge_buffer_size = mergesize + MIN_MERGE_BUFFER_SIZE;
+          pthread_mutex_lock (&merge_buffer_size_lock);
+          merge_buffer_size = MAX (merge_buffer_size,
+                                   mergesize + MIN_MERGE_BUFFER_SIZE);
+          pthread_mutex_unlock (&merge_buffer_size_lock);
           return true;
         }
 
@@ -2044,29 +2709,131 @@ getmonth (char const *month, char **ea)
   return 0;
 }
 
-/* A randomly chosen MD5 state, used for random comparison.  */
-static struct md5_ctx random_md5_state;
-
-/* Initialize the randomly chosen MD5 state.  */
+/* Return the integer part of the number NUMBER as strnumcmp sees it,
+   i.e., ignoring leading zeros and thousands separators, and negated
+   if the number is negative.  Return KEYCACHE_INVALID if the integer
+   part has more than DIGITS digits.  */
 
-static void
-random_md5_state_init (char const *random_source)
+static intmax_t _GL_ATTRIBUTE_PURE
+integer_part (char const *number, int digits)
 {
-  unsigned char buf[MD5_DIGEST_SIZE];
-  struct randread_source *r = randread_new (random_source, sizeof buf);
-  if (! r)
-    die (_("open failed"), random_source);
-  randread (r, buf, sizeof buf);
-  if (randread_free (r) != 0)
-    die (_("close failed"), random_source);
-  md5_init_ctx (&random_md5_state);
-  md5_process_bytes (buf, sizeof buf, &random_md5_state);
-}
+  bool minus_sign = (*number == '-');
+  char const *p = number + minus_sign;
+  intmax_t val = 0;
 
-/* This is like strxfrm, except it reports any error and exits.  */
+  while (*p == '0' || to_uchar (*p) == thousands_sep)
+    p++;
 
-static size_t
-xstrxfrm (char *restrict dest, char const *restrict src, size_t destsize)
+  while (ISDIGIT (*p))
+    {
+      if (digits-- == 0)
+        return KEYCACHE_INVALID;
+      val = 10 * val + (*p - '0');
+      do
+        p++;
+      while (to_uchar (*p) == thousands_sep);
+    }
+
+  return minus_sign ? -val : val;
+}
+
+/* Return the normalized form of the key of KEY type from TEXT to LIM.
+   The key is temporarily null-terminated, as keycompare does.  */
+
+static union keycache
+keycache_init (char *text, char *lim, struct keyfield const *key)
+{
+  union keycache kc;
+  char end;
+
+  lim = MAX (text, lim);
+  end = *lim;
+  *lim = '\0';
+
+  if (key->general_numeric)
+    {
+      char *ea;
+      long_double a = strtold (text, &ea);
+      kc.gnum = (text == ea || a != a ? NAN : a);
+    }
+  else if (key->month)
+    kc.num = getmonth (text, NULL);
+  else
+    {
+      while (blanks[to_uchar (*text)])
+        text++;
+
+      if (key->numeric)
+        kc.num = integer_part (text, 18);
+      else
+        {
+          /* Put the unit order in the high bits, so that it takes
+             precedence over the integer part, as in human_numcompare.
+             The integer part is less than 2**57 in magnitude.  */
+          kc.num = integer_part (text, 17);
+          if (kc.num != KEYCACHE_INVALID)
+            kc.num += find_unit_order (text) * ((intmax_t) 1 << 58);
+        }
+    }
+
+  *lim = end;
+  return kc;
+}
+
+/* Compare the normalized keys A and B of KEY type.  If that decides
+   the order of the keys, store the result into *DIFF and return true.
+   Otherwise the keys must be compared in full; return false.
+
+   A number whose integer part is less than another's is the smaller
+   number, whatever the fractions, so only equal integer parts need a
+   full comparison.  Likewise for -g numbers, which are rounded
+   monotonically to double.  */
+
+static bool
+keycache_compare (union keycache const *a, union keycache const *b,
+                  struct keyfield const *key, int *diff)
+{
+  if (key->general_numeric)
+    {
+      if (! (a->gnum < b->gnum || b->gnum < a->gnum))
+        return false;
+      *diff = a->gnum < b->gnum ? -1 : 1;
+    }
+  else if (key->month)
+    *diff = (b->num < a->num) - (a->num < b->num);
+  else
+    {
+      if (a->num == b->num
+          || a->num == KEYCACHE_INVALID || b->num == KEYCACHE_INVALID)
+        return false;
+      *diff = a->num < b->num ? -1 : 1;
+    }
+  return true;
+}
+
+/* A randomly chosen MD5 state, used for random comparison.  */
+static struct md5_ctx random_md5_state;
+
+/* Initialize the randomly chosen MD5 state.  */
+
+static void
+random_md5_state_init (char const *random_source)
+{
+  unsigned char buf[MD5_DIGEST_SIZE];
+  struct randread_source *r = randread_new (random_source, sizeof buf);
+  if (! r)
+    die (_("open failed"), random_source);
+  randread (r, buf, sizeof buf);
+  if (randread_free (r) != 0)
+    die (_("close failed"), random_source);
+  md5_init_ctx (&random_md5_state);
+  md5_process_bytes (buf, sizeof buf, &random_md5_state);
+}
+
+/* This is like strxfrm, except it reports any error and exits.  */
+
+static size_t
+xstrxfrm (char *restrict dest, char const *restrict src, size_t destsize)
 {
   errno = 0;
   size_t translated_size = strxfrm (dest, src, destsize);
@@ -2520,8 +3287,13 @@ keycompare (struct line const *a, struct line const *b)
       size_t lena = lima - texta;
       size_t lenb = limb - textb;
 
-      if (hard_LC_COLLATE || key_numeric (key)
-          || key->month || key->random || key->version)
+      if (key == keylist && first_key_cached
+          && keycache_compare (&a->keycache, &b->keycache, key, &diff))
+        {
+          /* The normalized keys decided the comparison.  */
+        }
+      else if (hard_LC_COLLATE || key_numeric (key)
+               || key->month || key->random || key->version)
         {
           char *ta;
           char *tb;
@@ -2766,6 +3538,13 @@ write_line (struct line const *line, FILE *fp, char const *output_file)
 
       debug_line (line);
     }
+  else if (ebuf[-1] == eolchar)
+    {
+      /* The line is still delimited, e.g., because it is in a
+         read-only mapping of the input.  */
+      if (fwrite (buf, 1, n_bytes, fp) != n_bytes)
+        die (_("write failed"), output_file);
+    }
   else
     {
       ebuf[-1] = eolchar;
@@ -2775,23 +3554,292 @@ write_line (struct line const *line, FILE *fp, char const *output_file)
     }
 }
 
+/* Copy LINE into *TEMP, whose text has *ALLOC bytes allocated,
+   reallocating it as needed.  */
+
+static void
+save_line (struct line *temp, size_t *alloc, struct line const *line)
+{
+  if (*alloc < line->length)
+    {
+      do
+        {
+          *alloc *= 2;
+          if (! *alloc)
+            {
+              *alloc = line->length;
+              break;
+            }
+        }
+      while (*alloc < line->length);
+
+      free (temp->text);
+      temp->text = xmalloc (*alloc);
+    }
+  memcpy (temp->text, line->text, line->length);
+  temp->length = line->length;
+  if (keylist)
+    {
+      temp->keybeg = temp->text + (line->keybeg - line->text);
+      temp->keylim = temp->text + (line->keylim - line->text);
+      temp->keycache = line->keycache;
+    }
+}
+
+/* Report to stderr that LINE, numbered LINE_NUMBER, of FILE_NAME is
+   out of order.  */
+
+static void
+report_disorder (char const *file_name, uintmax_t line_number,
+                 struct line const *line)
+{
+  char hr_buf[INT_BUFSIZE_BOUND (line_number)];
+  fprintf (stderr, _("%s: %s:%s: disorder: "),
+           program_name, file_name, umaxtostr (line_number, hr_buf));
+  write_line (line, stderr, _("standard error"));
+}
+
+/* The minimum number of bytes of a regular file that check_parallel
+   gives to each thread.  */
+enum { CHECK_CHUNK_SIZE_MIN = 1024 * 1024 };
+
+/* One part of a file checked by check_thread.  */
+
+struct check_chunk
+{
+  int fd;			/* The file, shared with other chunks.  */
+  char const *file_name;
+  size_t index;			/* Index of this chunk in the file.  */
+  off_t start;			/* Check the lines that start at or */
+  off_t end;			/* after START and before END, and the */
+  size_t bufsize;		/* line after them, reading with a */
+				/* buffer of BUFSIZE bytes.  */
+
+  /* Results.  The number of lines starting in the chunk that were
+     checked, and if a line is out of order, its number relative to
+     the chunk and a copy of it.  */
+  uintmax_t nlines;
+  uintmax_t disorder_number;
+  struct line disorder;
+};
+
+/* The index of the first chunk found to be out of order, or SIZE_MAX.
+   Threads checking later chunks stop when it is set.  */
+static size_t check_disorder_chunk;
+static pthread_mutex_t check_disorder_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Check the lines of the chunk DATA, reading them with pread so that
+   chunks can be read concurrently from the same file descriptor.
+   The chunk's first line is the one just after the first delimiter
+   at or after its start - 1, or the file's first line.  */
+
+static void *
+check_thread (void *data)
+{
+  struct check_chunk *chunk = data;
+  struct keyfield const *key = keylist;
+  char eol = eolchar;
+  bool nonunique = ! unique;
+  size_t bufsize = chunk->bufsize;
+  char *buf = xmalloc (bufsize);
+  size_t left = 0;
+  off_t pos = chunk->start - (chunk->index != 0);
+  bool skipping = chunk->index != 0;
+  struct line prev;
+  struct line temp;
+  size_t alloc = 0;
+  bool have_prev = false;
+
+  temp.text = NULL;
+  chunk->disorder.text = NULL;
+
+  while (true)
+    {
+      off_t bufpos;
+      ssize_t nread;
+      char *lim;
+      char *line_start;
+      char *p;
+
+      if (bufsize / 2 < left)
+        buf = x2realloc (buf, &bufsize);
+      nread = pread (chunk->fd, buf + left, bufsize - left - 1, pos);
+      if (nread < 0)
+        die (_("read failed"), chunk->file_name);
+      bufpos = pos - left;
+      pos += nread;
+      lim = buf + left + nread;
+      line_start = buf;
+      if (nread == 0)
+        {
+          if (left == 0 || skipping)
+            break;
+          *lim++ = eol;
+        }
+
+      if (skipping)
+        {
+          p = memchr (buf, eol, lim - buf);
+          if (! p)
+            {
+              left = 0;
+              continue;
+            }
+          line_start = p + 1;
+          skipping = false;
+        }
+
+      while ((p = memchr (line_start, eol, lim - line_start)))
+        {
+          struct line line;
+          bool past_end = chunk->end <= bufpos + (line_start - buf);
+
+          *p = '\0';
+          line.text = line_start;
+          line.length = p + 1 - line_start;
+          if (key)
+            find_first_key (&line, key);
+          if (! past_end)
+            chunk->nlines++;
+
+          if (have_prev && nonunique <= compare (&prev, &line))
+            {
+              chunk->disorder_number = chunk->nlines + past_end;
+              chunk->disorder.text = xmemdup (line.text, line.length);
+              chunk->disorder.length = line.length;
+              pthread_mutex_lock (&check_disorder_lock);
+              check_disorder_chunk = MIN (check_disorder_chunk, chunk->index);
+              pthread_mutex_unlock (&check_disorder_lock);
+              goto finish;
+            }
+          if (past_end)
+            goto finish;
+
+          prev = line;
+          have_prev = true;
+          line_start = p + 1;
+        }
+
+      if (nread == 0)
+        break;
+
+      /* The buffer is about to be overwritten, so save the last line.  */
+      if (have_prev && prev.text != temp.text)
+        {
+          save_line (&temp, &alloc, &prev);
+          prev = temp;
+        }
+      left = lim - line_start;
+      memmove (buf, line_start, left);
+
+      pthread_mutex_lock (&check_disorder_lock);
+      bool stop = check_disorder_chunk < chunk->index;
+      pthread_mutex_unlock (&check_disorder_lock);
+      if (stop)
+        break;
+    }
+
+ finish:
+  free (temp.text);
+  free (buf);
+  return NULL;
+}
+
+/* Check the order of FP, whose name is FILE_NAME, as check does, but
+   by splitting it into chunks at line boundaries and checking them in
+   up to NTHREADS threads.  Each chunk also checks its last line
+   against the first line of the next one.  Store whether the file is
+   in order into *ORDERED.  Return false without reading anything if
+   FP is not a regular file large enough to be worth splitting.  */
+
+static bool
+check_parallel (FILE *fp, char const *file_name, char checkonly,
+                size_t nthreads, bool *ordered)
+{
+  int fd = fileno (fp);
+  struct stat st;
+  off_t start;
+  size_t nchunks;
+  size_t bufsize;
+  struct check_chunk *chunks;
+  pthread_t *threads;
+  uintmax_t line_number = 0;
+  size_t i;
+  size_t j;
+
+  if (nthreads < 2 || fstat (fd, &st) != 0 || ! S_ISREG (st.st_mode)
+      || (start = lseek (fd, 0, SEEK_CUR)) < 0
+      || st.st_size - start < 2 * CHECK_CHUNK_SIZE_MIN)
+    return false;
+
+  nchunks = MIN (nthreads, (st.st_size - start) / CHECK_CHUNK_SIZE_MIN);
+  bufsize = MAX (merge_buffer_size, sort_size / nchunks);
+  chunks = xnmalloc (nchunks, sizeof *chunks);
+  threads = xnmalloc (nchunks, sizeof *threads);
+  check_disorder_chunk = SIZE_MAX;
+
+  for (i = 0; i < nchunks; i++)
+    {
+      struct check_chunk *chunk = &chunks[i];
+      chunk->fd = fd;
+      chunk->file_name = file_name;
+      chunk->index = i;
+      chunk->start = start + (st.st_size - start) / nchunks * i;
+      chunk->end = (i + 1 < nchunks
+                    ? start + (st.st_size - start) / nchunks * (i + 1)
+                    : st.st_size);
+      chunk->bufsize = bufsize;
+      chunk->nlines = 0;
+    }
+
+  for (i = 1; i < nchunks; i++)
+    if (pthread_create (&threads[i], NULL, check_thread, &chunks[i]) != 0)
+      break;
+  check_thread (&chunks[0]);
+  for (j = 1; j < i; j++)
+    pthread_join (threads[j], NULL);
+  for (; j < nchunks; j++)
+    check_thread (&chunks[j]);
+
+  *ordered = check_disorder_chunk == SIZE_MAX;
+  if (! *ordered && checkonly == 'c')
+    {
+      for (i = 0; i < check_disorder_chunk; i++)
+        line_number += chunks[i].nlines;
+      i = check_disorder_chunk;
+      report_disorder (file_name, line_number + chunks[i].disorder_number,
+                       &chunks[i].disorder);
+    }
+
+  for (i = 0; i < nchunks; i++)
+    free (chunks[i].disorder.text);
+  free (threads);
+  free (chunks);
+  return true;
+}
+
 /* Check that the lines read from FILE_NAME come in order.  Return
    true if they are in order.  If CHECKONLY == 'c', also print a
    diagnostic (FILE_NAME, line number, contents of line) to stderr if
-   they are not in order.  */
+   they are not in order.  Use up to NTHREADS threads.  */
 
 static bool
-check (char const *file_name, char checkonly)
+check (char const *file_name, char checkonly, size_t nthreads)
 {
   FILE *fp = xfopen (file_name, "r");
   struct buffer buf;		/* Input buffer. */
   struct line temp;		/* Copy of previous line. */
   size_t alloc = 0;
   uintmax_t line_number = 0;
-  struct keyfield const *key = keylist;
   bool nonunique = ! unique;
   bool ordered = true;
 
+  if (check_parallel (fp, file_name, checkonly, nthreads, &ordered))
+    {
+      xfclose (fp, file_name);
+      return ordered;
+    }
+
   initbuf (&buf, sizeof (struct line),
            MAX (merge_buffer_size, sort_size));
   temp.text = NULL;
@@ -2810,13 +3858,10 @@ check (char const *file_name, char checkonly)
             if (checkonly == 'c')
               {
                 struct line const *disorder_line = line - 1;
-                uintmax_t disorder_line_number =
-                  buffer_linelim (&buf) - disorder_line + line_number;
-                char hr_buf[INT_BUFSIZE_BOUND (disorder_line_number)];
-                fprintf (stderr, _("%s: %s:%s: disorder: "),
-                         program_name, file_name,
-                         umaxtostr (disorder_line_number, hr_buf));
-                write_line (disorder_line, stderr, _("standard error"));
+                report_disorder (file_name,
+                                 (buffer_linelim (&buf) - disorder_line
+                                  + line_number),
+                                 disorder_line);
               }
 
             ordered = false;
@@ -2832,29 +3877,7 @@ check (char const *file_name, char checkonly)
       line_number += buf.nlines;
 
       /* Save the last line of the buffer.  */
-      if (alloc < line->length)
-        {
-          do
-            {
-              alloc *= 2;
-              if (! alloc)
-                {
-                  alloc = line->length;
-                  break;
-                }
-            }
-          while (alloc < line->length);
-
-          free (temp.text);
-          temp.text = xmalloc (alloc);
-        }
-      memcpy (temp.text, line->text, line->length);
-      temp.length = line->length;
-      if (key)
-        {
-          temp.keybeg = temp.text + (line->keybeg - line->text);
-          temp.keylim = temp.text + (line->keylim - line->text);
-        }
+      save_line (&temp, &alloc, line);
     }
 
   xfclose (fp, file_name);
@@ -2922,8 +3945,11 @@ mergefps (struct sortfile *files, size_t ntemps, size_t nfiles,
   /* Read initial lines from each input file. */
   for (i = 0; i < nfiles; )
     {
-      initbuf (&buffer[i], sizeof (struct line),
-               MAX (merge_buffer_size, sort_size / nfiles));
+      size_t bufsize;
+      pthread_mutex_lock (&merge_buffer_size_lock);
+      bufsize = MAX (merge_buffer_size, sort_size / merge_jobs / nfiles);
+      pthread_mutex_unlock (&merge_buffer_size_lock);
+      initbuf (&buffer[i], sizeof (struct line), bufsize);
       if (fillbuf (&buffer[i], fps[i], files[i].name))
         {
           struct line const *linelim = buffer_linelim (&buffer[i]);
@@ -2997,6 +4023,7 @@ mergefps (struct sortfile *files, size_t ntemps, size_t nfiles,
                     saved.text + (smallest->keybeg - smallest->text);
                   saved.keylim =
                     saved.text + (smallest->keylim - smallest->text);
+                  saved.keycache = smallest->keycache;
                 }
             }
         }
@@ -3210,6 +4237,139 @@ sequential_sort (struct line *restrict lines, size_t nlines,
     }
 }
 
+/* Subarrays with at most this many lines are sorted by radix_sort
+   with an insertion sort.  */
+enum { RADIX_SORT_THRESHOLD = 32 };
+
+/* Return the bucket of LINE for the byte at offset DEPTH.  Lines that
+   end before DEPTH go into bucket 0, and other lines into the byte's
+   value plus 1; or the other way around if DESCENDING.  */
+
+static inline size_t
+radix_bucket (struct line const *line, size_t depth, bool descending)
+{
+  size_t b = (depth < line->length - 1
+              ? to_uchar (line->text[depth]) + 1 : 0);
+  return descending ? UCHAR_LIM - b : b;
+}
+
+/* Compare lines A and B bytewise, given that their first DEPTH bytes
+   are equal.  */
+
+static inline int
+radix_compare (struct line const *a, struct line const *b, size_t depth)
+{
+  size_t alen = a->length - 1;
+  size_t blen = b->length - 1;
+  int diff = memcmp (a->text + depth, b->text + depth,
+                     MIN (alen, blen) - depth);
+  return diff ? diff : alen < blen ? -1 : alen != blen;
+}
+
+/* Sort the array LINES with NLINES members in place, in ascending or
+   DESCENDING bytewise order, given that their first DEPTH bytes are
+   equal.  Unlike the other sort functions, LINES points to the start
+   of the array.
+
+   This is an MSD radix sort that distributes the lines into buckets by
+   the byte at DEPTH, permuting them in place in the style of McIlroy,
+   Bostic and McIlroy's American flag sort, and then sorts each bucket
+   by the next byte.  It needs no temporary array, and looks at each
+   byte of the distinguishing prefixes only a few times, rather than
+   the log N times of a comparison sort.  The largest bucket is sorted
+   iteratively, and the others recursively, so the recursion depth is
+   at most log N.  */
+
+static void
+radix_sort (struct line *lines, size_t nlines, size_t depth,
+            bool descending)
+{
+  size_t end_bucket = descending ? UCHAR_LIM : 0;
+  size_t i;
+
+  while (RADIX_SORT_THRESHOLD < nlines)
+    {
+      size_t count[UCHAR_LIM + 1] = { 0, };
+      size_t next[UCHAR_LIM + 1];
+      size_t end[UCHAR_LIM + 1];
+      size_t largest = end_bucket;
+      size_t pos = 0;
+      size_t b;
+
+      for (i = 0; i < nlines; i++)
+        count[radix_bucket (&lines[i], depth, descending)]++;
+
+      for (b = 0; b <= UCHAR_LIM; b++)
+        {
+          next[b] = pos;
+          pos += count[b];
+          end[b] = pos;
+        }
+
+      /* Move each line to its bucket, following cycles of the
+         permutation so that each line is moved once.  */
+      for (b = 0; b <= UCHAR_LIM; b++)
+        while (next[b] < end[b])
+          {
+            struct line line = lines[next[b]];
+            size_t c = radix_bucket (&line, depth, descending);
+            while (c != b)
+              {
+                struct line displaced = lines[next[c]];
+                lines[next[c]++] = line;
+                line = displaced;
+                c = radix_bucket (&line, depth, descending);
+              }
+            lines[next[b]++] = line;
+          }
+
+      /* Lines in END_BUCKET have ended, and so are equal.  */
+      for (b = 0; b <= UCHAR_LIM; b++)
+        if (b != end_bucket && count[largest] < count[b])
+          largest = b;
+      for (b = 0; b <= UCHAR_LIM; b++)
+        if (b != end_bucket && b != largest && 1 < count[b])
+          radix_sort (lines + end[b] - count[b], count[b], depth + 1,
+                      descending);
+
+      if (largest == end_bucket)
+        return;
+      lines += end[largest] - count[largest];
+      nlines = count[largest];
+      depth++;
+    }
+
+  for (i = 1; i < nlines; i++)
+    {
+      struct line line = lines[i];
+      size_t j = i;
+      for (; 0 < j; j--)
+        {
+          int diff = radix_compare (&lines[j - 1], &line, depth);
+          if (descending ? 0 <= diff : diff <= 0)
+            break;
+          lines[j] = lines[j - 1];
+        }
+      lines[j] = line;
+    }
+}
+
+/* Sort the array LINES with NLINES members, as sequential_sort does
+   when TO_TEMP is false.  When lines are compared bytewise, a radix
+   sort is used instead.  */
+
+static void
+sort_leaf (struct line *restrict lines, size_t nlines,
+           struct line *restrict temp)
+{
+  /* The array is in reverse order, so sort it in descending order
+     unless the output is to be reversed.  */
+  if (bytewise_order)
+    radix_sort (lines - nlines, nlines, 0, !reverse);
+  else
+    sequential_sort (lines, nlines, temp, false);
+}
+
 static struct merge_node *init_node (struct merge_node *restrict,
                                      struct merge_node *restrict,
                                      struct line *, size_t, size_t, bool);
@@ -3636,9 +4796,9 @@ sortlines (struct line *restrict lines, size_t nthreads,
       size_t nhi = node->nhi;
       struct line *temp = lines - total_lines;
       if (1 < nhi)
-        sequential_sort (lines - nlo, nhi, temp - nlo / 2, false);
+        sort_leaf (lines - nlo, nhi, temp - nlo / 2);
       if (1 < nlo)
-        sequential_sort (lines, nlo, temp, false);
+        sort_leaf (lines, nlo, temp);
 
       /* Update merge NODE. No need to lock yet. */
       node->lo = lines;
@@ -3755,14 +4915,124 @@ check_output (char const *outfile)
     }
 }
 
+/* One NMERGE-sized merge of temporary files, run by merge_thread.  */
+
+struct merge_job
+{
+  /* A private copy of the input files, and their open streams.  */
+  struct sortfile *files;
+  FILE **fps;
+
+  /* The temporary output file, and its stream.  */
+  struct tempnode *temp;
+  FILE *tfp;
+};
+
+/* Like mergefps, except with a signature acceptable to pthread_create.
+   The inputs are not removed here; the caller does that, so that only
+   one thread at a time modifies the list of temporary files.  */
+
+static void *
+merge_thread (void *data)
+{
+  struct merge_job *job = data;
+  mergefps (job->files, 0, nmerge, job->tfp, job->temp->name, job->fps);
+  return NULL;
+}
+
+/* Do as many of the NMERGE-sized merges of FILES[*PIN .. NFILES-1]
+   as possible concurrently, using up to NTHREADS threads, storing
+   each output into FILES[*POUT], and advancing *PIN and *POUT past
+   the merged inputs and the outputs.  *PNTEMPS is the number of
+   temporary files at the start of FILES[*PIN .. NFILES-1].
+
+   The merges of one pass are independent of each other, so for large
+   inputs this keeps more than one processor busy during the merge
+   phase.  Stop early, leaving the rest to the caller, if file
+   descriptors or temporary files run out.  */
+
+static void
+merge_groups (struct sortfile *files, size_t *pntemps, size_t nfiles,
+              size_t *pin, size_t *pout, size_t nthreads)
+{
+  struct merge_job *jobs = xnmalloc (nthreads, sizeof *jobs);
+  pthread_t *threads = xnmalloc (nthreads, sizeof *threads);
+
+  while (2 * nmerge <= nfiles - *pin)
+    {
+      size_t njobs;
+      size_t i;
+      size_t j;
+
+      /* Open the inputs and outputs of each merge in this thread, as
+         the bookkeeping for temporary files is not thread-safe.  */
+      for (njobs = 0; (njobs < nthreads
+                       && nmerge <= nfiles - (*pin + njobs * nmerge));
+           njobs++)
+        {
+          struct merge_job *job = &jobs[njobs];
+          size_t nopened;
+
+          job->files = xmemdup (&files[*pin + njobs * nmerge],
+                                nmerge * sizeof *job->files);
+          nopened = open_input_files (job->files, nmerge, &job->fps);
+          job->temp = (nopened == nmerge
+                       ? maybe_create_temp (&job->tfp, true) : NULL);
+          if (! job->temp)
+            {
+              while (nopened)
+                {
+                  nopened--;
+                  xfclose (job->fps[nopened], job->files[nopened].name);
+                }
+              free (job->fps);
+              free (job->files);
+              break;
+            }
+        }
+
+      if (njobs == 0)
+        break;
+
+      merge_jobs = njobs;
+      for (i = 1; i < njobs; i++)
+        if (pthread_create (&threads[i], NULL, merge_thread, &jobs[i]) != 0)
+          break;
+      merge_thread (&jobs[0]);
+      for (j = 1; j < i; j++)
+        pthread_join (threads[j], NULL);
+      for (; j < njobs; j++)
+        merge_thread (&jobs[j]);
+      merge_jobs = 1;
+
+      /* Remove the merged temporaries before their slots in FILES
+         are reused for the outputs.  */
+      for (i = 0; i < njobs * nmerge && *pntemps; i++, --*pntemps)
+        zaptemp (files[*pin + i].name);
+
+      for (i = 0; i < njobs; i++)
+        {
+          files[*pout].name = jobs[i].temp->name;
+          files[*pout].temp = jobs[i].temp;
+          ++*pout;
+          free (jobs[i].files);
+        }
+      *pin += njobs * nmerge;
+    }
+
+  free (threads);
+  free (jobs);
+}
+
 /* Merge the input FILES.  NTEMPS is the number of files at the
    start of FILES that are temporary; it is zero at the top level.
    NFILES is the total number of files.  Put the output in
-   OUTPUT_FILE; a null OUTPUT_FILE stands for standard output.  */
+   OUTPUT_FILE; a null OUTPUT_FILE stands for standard output.
+   Use at most NTHREADS threads.  */
 
 static void
 merge (struct sortfile *files, size_t ntemps, size_t nfiles,
-       char const *output_file)
+       char const *output_file, size_t nthreads)
 {
   while (nmerge < nfiles)
     {
@@ -3779,10 +5049,17 @@ merge (struct sortfile *files, size_t ntemps, size_t nfiles,
       /* Number of easily-available slots at the next loop iteration.  */
       size_t cheap_slots;
 
+      out = in = 0;
+
+      /* Compressed temporaries need their subprocesses managed from
+         a single thread, so merge them serially.  */
+      if (1 < nthreads && ! compress_program)
+        merge_groups (files, &ntemps, nfiles, &in, &out, nthreads);
+
       /* Do as many NMERGE-size merges as possible. In the case that
          nmerge is bogus, increment by the maximum number of file
          descriptors allowed.  */
-      for (out = in = 0; nmerge <= nfiles - in; out++)
+      for (; nmerge <= nfiles - in; out++)
         {
           FILE *tfp;
           struct tempnode *temp = create_temp (&tfp);
@@ -3874,17 +5151,192 @@ merge (struct sortfile *files, size_t ntemps, size_t nfiles,
     }
 }
 
-/* Sort NFILES FILES onto OUTPUT_FILE.  Use at most NTHREADS threads.  */
+/* Sort the lines of NLINES, in the line array ending at LINE, onto TFP.
+   TEMP_OUTPUT is the name of TFP, or is null if TFP is standard output.
+   Use at most NTHREADS threads.  */
 
 static void
-sort (char *const *files, size_t nfiles, char const *output_file,
-      size_t nthreads)
+sort_buffer_lines (struct line *line, size_t nlines, size_t nthreads,
+                   FILE *tfp, char const *temp_output)
 {
-  struct buffer buf;
-  IF_LINT (buf.buf = NULL);
+  saved_line.text = NULL;
+  if (1 < nlines)
+    {
+      struct merge_node_queue queue;
+      queue_init (&queue, nthreads);
+      struct merge_node *merge_tree =
+        merge_tree_init (nthreads, nlines, line);
+
+      sortlines (line, nthreads, nlines, merge_tree + 1,
+                 &queue, tfp, temp_output);
+
+#ifdef lint
+      merge_tree_destroy (nthreads, merge_tree);
+      queue_destroy (&queue);
+#endif
+    }
+  else
+    write_unique (line - 1, tfp, temp_output);
+}
+
+/* The diagnostic for sort_mapped's input if it shrinks while mapped,
+   so that reading the mapping raises SIGBUS.  */
+static char *mapped_input_error;
+
+/* Handle SIGBUS while sort_mapped's input is mapped.  */
+
+static void
+mapped_input_fault (int sig _GL_UNUSED)
+{
+  cleanup ();
+  async_safe_die (0, mapped_input_error);
+}
+
+/* Sort FP, the only input file, whose name is FILE, onto OUTPUT_FILE,
+   by mapping it into memory rather than reading it, if that is possible.
+   Reserve BYTES_PER_LINE bytes for each line, and use at most NTHREADS
+   threads.  Return false, leaving FP as is, if the file cannot be
+   mapped.  Otherwise close FP and return true, after either creating
+   OUTPUT_FILE and setting *OUTPUT_FILE_CREATED, or storing the sorted
+   lines into temporary files and adding their number to *NTEMPS.
+
+   Only the line array then needs to fit in the sort buffer, and the
+   input is not copied.  This works only when lines are compared as
+   byte strings, since the other comparisons need each line to be
+   null-terminated, and so need a writable copy of the input.  */
+
+static bool
+sort_mapped (FILE *fp, char const *file, char const *output_file,
+             size_t bytes_per_line, size_t nthreads,
+             size_t *ntemps, bool *output_file_created)
+{
+#if HAVE_SYS_MMAN_H
+  int fd = fileno (fp);
+  struct stat st;
+  struct stat outst;
+  char *text;
+  char const *lim;
+  char const *p;
+  size_t size;
+  size_t nlines = 0;
+  size_t chunk_lines;
+  size_t nalloc;
+  struct line *lines;
+  struct line *linelim;
+  size_t budget;
+  void (*old_sigbus) (int);
+
+  if (! bytewise_order || debug
+      || fstat (fd, &st) != 0 || ! S_ISREG (st.st_mode)
+      || st.st_size <= 0 || SIZE_MAX < st.st_size
+      || lseek (fd, 0, SEEK_CUR) != 0)
+    return false;
+
+  /* Writing the output could truncate a mapped input.  */
+  if (fstat (STDOUT_FILENO, &outst) == 0 && SAME_INODE (st, outst))
+    return false;
+
+  size = st.st_size;
+  text = mmap (NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (text == MAP_FAILED)
+    return false;
+  lim = text + size;
+
+  /* An unterminated last line would need a delimiter appended.  */
+  if (lim[-1] != eolchar)
+    {
+      munmap (text, size);
+      return false;
+    }
+
+  /* If the file shrinks, reading past its new end raises SIGBUS,
+     which would otherwise kill sort without a diagnostic.  */
+  mapped_input_error = xasprintf ("%s: %s: %s", program_name,
+                                  _("input file truncated"), file);
+  old_sigbus = signal (SIGBUS, mapped_input_fault);
+
+  /* The lines are compared in any order, so ask for the whole file
+     to be read ahead, rather than for sequential access.  */
+# ifdef MADV_WILLNEED
+  madvise (text, size, MADV_WILLNEED);
+# endif
+
+  for (p = text; (p = memchr (p, eolchar, lim - p)); p++)
+    nlines++;
+
+  budget = sort_size ? sort_size : default_sort_size ();
+  chunk_lines = MIN (nlines, MAX (2, budget / bytes_per_line));
+  nalloc = (chunk_lines * bytes_per_line + sizeof (struct line) - 1)
+           / sizeof (struct line);
+  lines = xnmalloc (nalloc, sizeof *lines);
+  linelim = lines + nalloc;
+
+  for (p = text; p < lim; )
+    {
+      char const *chunk = p;
+      struct line *line = linelim;
+      FILE *tfp;
+      char const *temp_output;
+
+      while (linelim - line < chunk_lines && p < lim)
+        {
+          char const *eol = memchr (p, eolchar, lim - p);
+          line--;
+          line->text = (char *) p;
+          line->length = eol + 1 - p;
+          p = eol + 1;
+        }
+
+      if (chunk == text && p == lim)
+        {
+          tfp = xfopen (output_file, "w");
+          temp_output = output_file;
+          *output_file_created = true;
+        }
+      else
+        {
+          ++*ntemps;
+          temp_output = create_temp (&tfp)->name;
+        }
+
+      sort_buffer_lines (linelim, linelim - line, nthreads, tfp, temp_output);
+      xfclose (tfp, temp_output);
+
+# ifdef MADV_DONTNEED
+      /* This part of the input is no longer needed in memory.  */
+      {
+        size_t pagesize = getpagesize ();
+        char *beg = text + ((chunk - text + pagesize - 1) / pagesize
+                            * pagesize);
+        char *end = text + (p - text) / pagesize * pagesize;
+        if (beg < end)
+          madvise (beg, end - beg, MADV_DONTNEED);
+      }
+# endif
+    }
+
+  free (lines);
+  munmap (text, size);
+  signal (SIGBUS, old_sigbus);
+  free (mapped_input_error);
+  xfclose (fp, file);
+  return true;
+#else
+  return false;
+#endif
+}
+
+/* Sort NFILES FILES onto OUTPUT_FILE.  Use at most NTHREADS threads.  */
+
+static void
+sort (char *const *files, size_t nfiles, char const *output_file,
+      size_t nthreads)
+{
+  struct buffer buf;
   size_t ntemps = 0;
   bool output_file_created = false;
 
+  buf.buf = NULL;
   buf.alloc = 0;
 
   while (nfiles)
@@ -3910,6 +5362,17 @@ sort (char *const *files, size_t nfiles, char const *output_file,
       else
         bytes_per_line = sizeof (struct line) * 3 / 2;
 
+      if (nfiles == 1 && ! buf.alloc
+          && sort_mapped (fp, file, output_file, bytes_per_line, nthreads,
+                          &ntemps, &output_file_created))
+        {
+          if (output_file_created)
+            goto finish;
+          files++;
+          nfiles--;
+          continue;
+        }
+
       if (! buf.alloc)
         initbuf (&buf, bytes_per_line,
                  sort_buffer_size (&fp, 1, files, nfiles, bytes_per_line));
@@ -3932,7 +5395,6 @@ sort (char *const *files, size_t nfiles, char const *output_file,
               break;
             }
 
-          saved_line.text = NULL;
           line = buffer_linelim (&buf);
           if (buf.eof && !nfiles && !ntemps && !buf.left)
             {
@@ -3946,23 +5408,7 @@ sort (char *const *files, size_t nfiles, char const *output_file,
               ++ntemps;
               temp_output = create_temp (&tfp)->name;
             }
-          if (1 < buf.nlines)
-            {
-              struct merge_node_queue queue;
-              queue_init (&queue, nthreads);
-              struct merge_node *merge_tree =
-                merge_tree_init (nthreads, buf.nlines, line);
-
-              sortlines (line, nthreads, buf.nlines, merge_tree + 1,
-                         &queue, tfp, temp_output);
-
-#ifdef lint
-              merge_tree_destroy (nthreads, merge_tree);
-              queue_destroy (&queue);
-#endif
-            }
-          else
-            write_unique (line - 1, tfp, temp_output);
+          sort_buffer_lines (line, buf.nlines, nthreads, tfp, temp_output);
 
           xfclose (tfp, temp_output);
 
@@ -3986,13 +5432,549 @@ sort (char *const *files, size_t nfiles, char const *output_file,
           tempfiles[i].temp = node;
           node = node->next;
         }
-      merge (tempfiles, ntemps, ntemps, output_file);
+      merge (tempfiles, ntemps, ntemps, output_file, nthreads);
       free (tempfiles);
     }
 
   reap_all ();
 }
 
+/* With --unique --unordered, and no keys, distinct lines are found
+   with a hash table rather than by sorting.  A line in such a table.  */
+
+struct dedup_line
+{
+  size_t hash;			/* Hash of the text, seeded by level.  */
+  size_t length;		/* Length of TEXT, excluding the null.  */
+  char *text;			/* Null-terminated text, just after this.  */
+};
+
+/* The number of temporary files among which the lines that do not
+   fit into the memory of a dedup set are partitioned.  */
+enum { DEDUP_PARTITIONS = 16 };
+
+/* A set of distinct lines.  Once it has used up its memory, lines
+   not already in the table are written to partition temp files by
+   hash, so that equal lines end up in the same partition, and each
+   partition is made distinct later with a set of its own.  */
+
+struct dedup_set
+{
+  Hash_table *table;		/* The distinct lines.  */
+  struct dedup_line **lines;	/* The same, in the order first seen.  */
+  size_t nlines;		/* Number of entries in LINES.  */
+  size_t nalloc;		/* Number of entries allocated for LINES.  */
+  size_t used;			/* Bytes of memory used.  */
+  size_t limit;			/* Bytes of memory that may be used.  */
+  unsigned int level;		/* Nesting level, which seeds the hash.  */
+  struct tempnode *part[DEDUP_PARTITIONS]; /* Spilled lines, or NULL.  */
+  FILE *part_fp[DEDUP_PARTITIONS];	 /* Streams writing to PART.  */
+};
+
+/* Mix the N bytes at P into the FNV-1a hash H.  */
+
+static uint64_t _GL_ATTRIBUTE_PURE
+dedup_hash_bytes (uint64_t h, char const *p, size_t n)
+{
+  while (n--)
+    h = (h ^ to_uchar (*p++)) * UINT64_C (0x100000001b3);
+  return h;
+}
+
+/* Return a hash of the LEN bytes of TEXT, where TEXT[LEN] is zero,
+   with a seed that depends on LEVEL.  Lines that compare equal get
+   equal hashes: in a locale with collating rules, hash the strxfrm
+   transform of each null-terminated string in the line rather than
+   the bytes themselves.  */
+
+static size_t
+dedup_hash (char const *text, size_t len, unsigned int level)
+{
+  static char *xfrm_buf;
+  static size_t xfrm_bufsize;
+  uint64_t h = UINT64_C (0xcbf29ce484222325)
+               + level * UINT64_C (0x9e3779b97f4a7c15);
+
+  if (! hard_LC_COLLATE)
+    h = dedup_hash_bytes (h, text, len);
+  else
+    {
+      char const *lim = text + len;
+
+      do
+        {
+          size_t n = xstrxfrm (xfrm_buf, text, xfrm_bufsize);
+          if (xfrm_bufsize <= n)
+            {
+              free (xfrm_buf);
+              xfrm_bufsize = MAX (n + 1, xfrm_bufsize * 3 / 2);
+              xfrm_buf = xmalloc (xfrm_bufsize);
+              strxfrm (xfrm_buf, text, xfrm_bufsize);
+            }
+          h = dedup_hash_bytes (h, xfrm_buf, n + 1);
+          text += strlen (text) + 1;
+        }
+      while (text <= lim);
+    }
+
+  h ^= h >> 32;
+  return h;
+}
+
+static size_t
+dedup_hasher (void const *entry, size_t table_size)
+{
+  struct dedup_line const *line = entry;
+  return line->hash % table_size;
+}
+
+static bool
+dedup_compare (void const *entry_a, void const *entry_b)
+{
+  struct dedup_line const *a = entry_a;
+  struct dedup_line const *b = entry_b;
+
+  if (a->hash != b->hash)
+    return false;
+  if (hard_LC_COLLATE)
+    return xmemcoll0 (a->text, a->length + 1, b->text, b->length + 1) == 0;
+  return a->length == b->length && memcmp (a->text, b->text, a->length) == 0;
+}
+
+/* Initialize SET, at nesting LEVEL, to use LIMIT bytes of memory.  */
+
+static void
+dedup_init (struct dedup_set *set, size_t limit, unsigned int level)
+{
+  size_t i;
+
+  set->table = hash_initialize (1021, NULL, dedup_hasher, dedup_compare,
+                                NULL);
+  if (! set->table)
+    xalloc_die ();
+  set->lines = NULL;
+  set->nlines = set->nalloc = 0;
+  set->used = 0;
+  set->limit = limit;
+  set->level = level;
+  for (i = 0; i < DEDUP_PARTITIONS; i++)
+    set->part[i] = NULL;
+}
+
+/* Write LINE to the partition of SET that its hash selects.  */
+
+static void
+dedup_spill (struct dedup_set *set, struct dedup_line *line)
+{
+  size_t i = line->hash % DEDUP_PARTITIONS;
+  struct line l;
+
+  if (! set->part[i])
+    set->part[i] = create_temp (&set->part_fp[i]);
+  l.text = line->text;
+  l.length = line->length + 1;
+  write_line (&l, set->part_fp[i], set->part[i]->name);
+}
+
+/* Add the lines read from FP, whose name is FILE, to SET.  */
+
+static void
+dedup_read (struct dedup_set *set, FILE *fp, char const *file)
+{
+  char *buf = NULL;
+  size_t bufsize = 0;
+  struct dedup_line *probe = NULL;
+  size_t probe_size = 0;
+  ssize_t n;
+
+  while (0 <= (n = getdelim (&buf, &bufsize, eolchar, fp)))
+    {
+      size_t len = n;
+      size_t size;
+
+      if (len && buf[len - 1] == eolchar)
+        buf[--len] = '\0';
+
+      size = sizeof *probe + len + 1;
+      if (probe_size < size)
+        {
+          free (probe);
+          probe = xmalloc (size);
+          probe_size = size;
+        }
+      probe->hash = dedup_hash (buf, len, set->level);
+      probe->length = len;
+      probe->text = (char *) (probe + 1);
+      memcpy (probe->text, buf, len + 1);
+
+      /* Always insert at least one line, so that each partition is
+         smaller than its input and the recursion ends.  */
+      if (set->used <= set->limit || ! set->nlines)
+        {
+          int inserted = hash_insert_if_absent (set->table, probe, NULL);
+          if (inserted < 0)
+            xalloc_die ();
+          if (inserted)
+            {
+              if (set->nlines == set->nalloc)
+                set->lines = x2nrealloc (set->lines, &set->nalloc,
+                                         sizeof *set->lines);
+              set->lines[set->nlines++] = probe;
+              set->used += probe_size + 3 * sizeof (void *);
+              probe = NULL;
+              probe_size = 0;
+            }
+        }
+      else if (! hash_lookup (set->table, probe))
+        dedup_spill (set, probe);
+    }
+
+  free (probe);
+  free (buf);
+  if (ferror (fp))
+    die (_("read failed"), file);
+}
+
+/* Write the lines of SET to OFP, whose name is OUTPUT_FILE, and free
+   SET.  Then do the same for the lines of each of its partitions.  */
+
+static void
+dedup_output (struct dedup_set *set, FILE *ofp, char const *output_file)
+{
+  size_t i;
+
+  for (i = 0; i < set->nlines; i++)
+    {
+      struct line l;
+      l.text = set->lines[i]->text;
+      l.length = set->lines[i]->length + 1;
+      write_line (&l, ofp, output_file);
+      free (set->lines[i]);
+    }
+  free (set->lines);
+  hash_free (set->table);
+
+  for (i = 0; i < DEDUP_PARTITIONS; i++)
+    if (set->part[i])
+      xfclose (set->part_fp[i], set->part[i]->name);
+
+  for (i = 0; i < DEDUP_PARTITIONS; i++)
+    if (set->part[i])
+      {
+        char const *name = set->part[i]->name;
+        struct dedup_set sub;
+        FILE *fp = (set->part[i]->state != UNCOMPRESSED
+                    ? open_temp (set->part[i])
+                    : stream_open (name, "r"));
+        if (! fp)
+          die (_("open failed"), name);
+        dedup_init (&sub, set->limit, set->level + 1);
+        dedup_read (&sub, fp, name);
+        xfclose (fp, name);
+        zaptemp (name);
+        dedup_output (&sub, ofp, output_file);
+      }
+}
+
+/* Output the distinct lines of the NFILES FILES to OUTPUT_FILE, in
+   no particular order.  */
+
+static void
+sort_unordered_unique (char *const *files, size_t nfiles,
+                       char const *output_file)
+{
+  struct dedup_set set;
+  FILE *ofp;
+
+  dedup_init (&set, sort_size ? sort_size : default_sort_size (), 0);
+
+  for (; nfiles; files++, nfiles--)
+    {
+      FILE *fp = xfopen (*files, "r");
+      dedup_read (&set, fp, *files);
+      xfclose (fp, *files);
+    }
+
+  ofp = xfopen (output_file, "w");
+  dedup_output (&set, ofp, output_file);
+  xfclose (ofp, output_file);
+
+  reap_all ();
+}
+
+/* The default size of the input buffer with --top or --bottom.  The
+   buffer does not grow with the input, to keep memory use bounded.  */
+enum { TOP_BUFFER_SIZE = 8 * 1024 * 1024 };
+
+/* Compare lines A and B in the order in which --top selects lines:
+   the sorted order, reversed for --bottom.  INPUT_ORDER is negative,
+   zero or positive if A was read before, at the same time as, or
+   after B, and breaks ties as the sort would.  With --bottom and
+   without -u, later lines win ties, so that the last lines of the
+   sorted output are selected; -u keeps the first line of each run of
+   equal lines regardless.  */
+
+static int
+top_compare (struct line const *a, struct line const *b, int input_order)
+{
+  int diff = compare (a, b);
+  if (top_from_bottom)
+    diff = (diff < 0) - (diff > 0);
+  if (diff == 0)
+    diff = top_from_bottom && ! unique ? - input_order : input_order;
+  return diff;
+}
+
+/* Compare lines A and B of the same buffer, for the heap.  Lines
+   earlier in the input are at higher addresses.  */
+
+static int
+top_heap_compare (void const *a, void const *b)
+{
+  return top_compare (a, b, (a < b) - (a > b));
+}
+
+/* A line selected by --top or --bottom, and its line number.  */
+
+struct top_line
+{
+  struct line line;
+  uintmax_t seq;
+  bool owned;			/* LINE.text was allocated for this.  */
+};
+
+static int
+top_line_compare (void const *a, void const *b)
+{
+  struct top_line const *ta = a;
+  struct top_line const *tb = b;
+  return top_compare (&ta->line, &tb->line,
+                      (ta->seq > tb->seq) - (ta->seq < tb->seq));
+}
+
+/* Lines of a buffer, from which a top_thread selects at most
+   TOP_LINES.  */
+
+struct top_job
+{
+  struct line *lines;		/* Just past the first line.  */
+  size_t nlines;
+  struct line **sel;		/* The selected lines.  */
+  size_t nsel;
+};
+
+/* Select the first top_lines lines of JOB into JOB->sel, in no
+   particular order.  Keep them in a heap whose top is the greatest,
+   and skip lines no less than the last line removed from the heap,
+   which is usually most of them.  */
+
+static void *
+top_thread (void *data)
+{
+  struct top_job *job = data;
+  struct line *line = job->lines;
+  struct line *lim = line - job->nlines;
+  size_t n = MIN (top_lines, job->nlines);
+  struct heap *heap = heap_alloc (top_heap_compare, n + 1);
+  struct line *bound = NULL;
+  size_t count = 0;
+
+  job->sel = xnmalloc (n, sizeof *job->sel);
+  job->nsel = 0;
+  if (n == 0)
+    {
+      heap_free (heap);
+      return NULL;
+    }
+
+  while (lim < line--)
+    {
+      if (count < n)
+        {
+          heap_insert (heap, line);
+          count++;
+        }
+      else if (! bound || top_heap_compare (line, bound) < 0)
+        {
+          heap_insert (heap, line);
+          bound = heap_remove_top (heap);
+        }
+    }
+
+  while (job->nsel < count)
+    job->sel[job->nsel++] = heap_remove_top (heap);
+  heap_free (heap);
+  return NULL;
+}
+
+/* Like top_thread, but for -u: keep only the first line of each run
+   of equal lines.  A heap cannot find equal lines, so keep a sorted
+   array instead, and look up each line that may be selected.  */
+
+static void *
+top_unique_thread (void *data)
+{
+  struct top_job *job = data;
+  struct line *line = job->lines;
+  struct line *lim = line - job->nlines;
+  size_t n = MIN (top_lines, job->nlines);
+  struct line **sel = job->sel = xnmalloc (n + 1, sizeof *sel);
+  size_t nsel = 0;
+
+  while (n && lim < line--)
+    {
+      size_t lo = 0;
+      size_t hi = nsel;
+
+      if (nsel == n && 0 <= top_heap_compare (line, sel[nsel - 1]))
+        continue;
+
+      /* Find where LINE goes.  It follows any equal line, as it was
+         read later.  */
+      while (lo < hi)
+        {
+          size_t mid = lo + (hi - lo) / 2;
+          if (top_heap_compare (line, sel[mid]) < 0)
+            hi = mid;
+          else
+            lo = mid + 1;
+        }
+      if (lo && compare (line, sel[lo - 1]) == 0)
+        continue;
+
+      memmove (&sel[lo + 1], &sel[lo], (nsel - lo) * sizeof *sel);
+      sel[lo] = line;
+      nsel += nsel < n;
+    }
+
+  job->nsel = nsel;
+  return NULL;
+}
+
+/* Output the first (or with --bottom, the last) top_lines lines that
+   sorting FILES would output to OUTPUT_FILE, using up to NTHREADS
+   threads.  Split each buffer of input among the threads, each of
+   which selects at most top_lines lines from its part.  Then merge
+   those with the lines selected so far, copying the lines that stay
+   selected out of the buffer.  This takes O(N log K) time and O(K)
+   memory for N lines of input and K lines of output.  */
+
+static void
+sort_top (char *const *files, size_t nfiles, char const *output_file,
+          size_t nthreads)
+{
+  struct buffer buf;
+  struct top_line *best = NULL;
+  size_t nbest = 0;
+  uintmax_t seq = 0;
+  struct top_job *jobs = xnmalloc (nthreads, sizeof *jobs);
+  pthread_t *threads = xnmalloc (nthreads, sizeof *threads);
+  void *(*select) (void *) = unique ? top_unique_thread : top_thread;
+  FILE *ofp;
+  size_t i;
+
+  initbuf (&buf, sizeof (struct line),
+           MAX (merge_buffer_size, sort_size ? sort_size : TOP_BUFFER_SIZE));
+
+  for (; nfiles; files++, nfiles--)
+    {
+      FILE *fp = xfopen (*files, "r");
+      buf.eof = false;
+
+      while (fillbuf (&buf, fp, *files))
+        {
+          struct line *linelim = buffer_linelim (&buf);
+          size_t nlines = buf.nlines;
+          size_t njobs = MIN (nthreads,
+                              MAX (1, nlines / SUBTHREAD_LINES_HEURISTIC));
+          size_t ncand = nbest;
+          size_t nkept = 0;
+          struct top_line *cand;
+          size_t j;
+
+          for (i = 0; i < njobs; i++)
+            {
+              size_t lo = nlines / njobs * i;
+              jobs[i].lines = linelim - lo;
+              jobs[i].nlines = (i + 1 < njobs
+                                ? nlines / njobs * (i + 1) : nlines) - lo;
+            }
+          for (i = 1; i < njobs; i++)
+            if (pthread_create (&threads[i], NULL, select, &jobs[i]) != 0)
+              break;
+          select (&jobs[0]);
+          for (j = 1; j < i; j++)
+            pthread_join (threads[j], NULL);
+          for (; j < njobs; j++)
+            select (&jobs[j]);
+
+          /* Merge the selected lines with those kept so far, which
+             were all read earlier.  */
+          for (i = 0; i < njobs; i++)
+            ncand += jobs[i].nsel;
+          cand = xnmalloc (ncand, sizeof *cand);
+          memcpy (cand, best, nbest * sizeof *cand);
+          ncand = nbest;
+          for (i = 0; i < njobs; i++)
+            {
+              for (j = 0; j < jobs[i].nsel; j++)
+                {
+                  struct line *line = jobs[i].sel[j];
+                  cand[ncand].line = *line;
+                  cand[ncand].seq = seq + (linelim - 1 - line);
+                  cand[ncand].owned = false;
+                  ncand++;
+                }
+              free (jobs[i].sel);
+            }
+          seq += nlines;
+          qsort (cand, ncand, sizeof *cand, top_line_compare);
+
+          for (i = 0; i < ncand; i++)
+            {
+              struct top_line *t = &cand[i];
+              if (nkept < top_lines
+                  && ! (unique && nkept
+                        && compare (&cand[nkept - 1].line, &t->line) == 0))
+                {
+                  if (! t->owned)
+                    {
+                      struct line copy;
+                      size_t alloc = 0;
+                      copy.text = NULL;
+                      save_line (&copy, &alloc, &t->line);
+                      t->line = copy;
+                      t->owned = true;
+                    }
+                  cand[nkept++] = *t;
+                }
+              else if (t->owned)
+                free (t->line.text);
+            }
+
+          free (best);
+          best = cand;
+          nbest = nkept;
+        }
+
+      xfclose (fp, *files);
+    }
+
+  free (buf.buf);
+  free (threads);
+  free (jobs);
+
+  ofp = xfopen (output_file, "w");
+  for (i = 0; i < nbest; i++)
+    {
+      struct line *line = &best[top_from_bottom ? nbest - 1 - i : i].line;
+      write_line (line, ofp, output_file);
+      free (line->text);
+    }
+  xfclose (ofp, output_file);
+  free (best);
+}
+
 /* Insert a malloc'd copy of key KEY_ARG at the end of the key list.  */
 
 static void
@@ -4399,11 +6381,25 @@ main (int argc, char **argv)
           break;
 
         case COMPRESS_PROGRAM_OPTION:
-          if (compress_program && !STREQ (compress_program, optarg))
+          if (compress_builtin
+              || (compress_program && !STREQ (compress_program, optarg)))
             error (SORT_FAILURE, 0, _("multiple compress programs specified"));
           compress_program = optarg;
           break;
 
+        case CGROUP_ROOT_OPTION:
+          cgroup_root = optarg;
+          break;
+
+        case COMPRESS_TEMP_OPTION:
+          if (compress_program)
+            error (SORT_FAILURE, 0, _("multiple compress programs specified"));
+          compress_builtin = (XARGMATCH ("--compress-temp", optarg,
+                                         compress_temp_args,
+                                         compress_temp_types)
+                              == 'f');
+          break;
+
         case DEBUG_PROGRAM_OPTION:
           debug = true;
           break;
@@ -4520,6 +6516,23 @@ main (int argc, char **argv)
           add_temp_dir (optarg);
           break;
 
+        case UNORDERED_OPTION:
+          unordered = true;
+          break;
+
+        case TOP_OPTION:
+        case BOTTOM_OPTION:
+          {
+            bool from_bottom = c == BOTTOM_OPTION;
+            if (top_selected && top_from_bottom != from_bottom)
+              error (SORT_FAILURE, 0, _("options '%s %s' are incompatible"),
+                     "--top", "--bottom");
+            top_selected = true;
+            top_from_bottom = from_bottom;
+            top_lines = specify_top_lines (oi, c, optarg);
+          }
+          break;
+
         case PARALLEL_OPTION:
           nthreads = specify_nthreads (oi, c, optarg);
           break;
@@ -4671,6 +6684,10 @@ main (int argc, char **argv)
 
   reverse = gkey.reverse;
 
+  first_key_cached = (keylist && ! keylist->ignore && ! keylist->translate
+                      && (key_numeric (keylist) || keylist->month));
+  bytewise_order = ! keylist && ! hard_LC_COLLATE;
+
   if (need_random)
     random_md5_state_init (random_source);
 
@@ -4693,6 +6710,16 @@ main (int argc, char **argv)
   if (0 < sort_size)
     sort_size = MAX (sort_size, MIN_SORT_SIZE);
 
+  if (!nthreads)
+    {
+      unsigned long int np = num_processors (NPROC_CURRENT_OVERRIDABLE);
+      nthreads = MIN (np, DEFAULT_MAX_THREADS);
+    }
+
+  /* Avoid integer overflow later.  */
+  size_t nthreads_max = SIZE_MAX / (2 * sizeof (struct merge_node));
+  nthreads = MIN (nthreads, nthreads_max);
+
   if (checkonly)
     {
       if (nfiles > 1)
@@ -4706,9 +6733,18 @@ main (int argc, char **argv)
           incompatible_options (opts);
         }
 
+      if (top_selected)
+        {
+          static char opts[] = "X --top";
+          static char bottom_opts[] = "X --bottom";
+          opts[0] = bottom_opts[0] = checkonly;
+          incompatible_options (top_from_bottom ? bottom_opts : opts);
+        }
+
       /* POSIX requires that sort return 1 IFF invoked with -c or -C and the
          input is not properly sorted.  */
-      exit (check (files[0], checkonly) ? EXIT_SUCCESS : SORT_OUT_OF_ORDER);
+      exit (check (files[0], checkonly, nthreads)
+            ? EXIT_SUCCESS : SORT_OUT_OF_ORDER);
     }
 
   /* Check all inputs are accessible, or exit immediately.  */
@@ -4717,7 +6753,9 @@ main (int argc, char **argv)
   /* Check output is writable, or exit immediately.  */
   check_output (outfile);
 
-  if (mergeonly)
+  if (top_selected)
+    sort_top (files, nfiles, outfile, nthreads);
+  else if (mergeonly)
     {
       struct sortfile *sortfiles = xcalloc (nfiles, sizeof *sortfiles);
       size_t i;
@@ -4725,23 +6763,13 @@ main (int argc, char **argv)
       for (i = 0; i < nfiles; ++i)
         sortfiles[i].name = files[i];
 
-      merge (sortfiles, 0, nfiles, outfile);
+      merge (sortfiles, 0, nfiles, outfile, nthreads);
       IF_LINT (free (sortfiles));
     }
+  else if (unique && unordered && ! keylist && ! debug)
+    sort_unordered_unique (files, nfiles, outfile);
   else
-    {
-      if (!nthreads)
-        {
-          unsigned long int np = num_processors (NPROC_CURRENT_OVERRIDABLE);
-          nthreads = MIN (np, DEFAULT_MAX_THREADS);
-        }
-
-      /* Avoid integer overflow later.  */
-      size_t nthreads_max = SIZE_MAX / (2 * sizeof (struct merge_node));
-      nthreads = MIN (nthreads, nthreads_max);
-
-      sort (files, nfiles, outfile, nthreads);
-    }
+    sort (files, nfiles, outfile, nthreads);
 
   if (have_read_stdin && fclose (stdin) == EOF)
     die (_("close failed"), "-");
@@ -28,15 +28,18 @@
 #include <stdio.h>
 #include <assert.h>
 #include <getopt.h>
+#include <pthread.h>
 #include <sys/types.h>
 #include <signal.h>
 
 #include "system.h"
 #include "argmatch.h"
 #include "c-strtod.h"
+#include "count-newlines.h"
 #include "error.h"
 #include "fcntl--.h"
 #include "isapipe.h"
+#include "nproc.h"
 #include "posixver.h"
 #include "quote.h"
 #include "safe-read.h"
@@ -74,6 +77,12 @@
 /* Number of items to tail.  */
 #define DEFAULT_N_LINES 10
 
+/* Size of the blocks that file_lines reads backward.  */
+enum { TAIL_BLOCK_SIZE = 256 * 1024 };
+
+/* The most blocks that file_lines reads at once, in threads.  */
+enum { TAIL_BLOCKS_MAX = 16 };
+
 /* Special values for dump_remainder's N_BYTES parameter.  */
 #define COPY_TO_EOF UINTMAX_MAX
 #define COPY_A_BUFFER (UINTMAX_MAX - 1)
@@ -151,6 +160,9 @@ struct File_spec
 
   /* Offset in NAME of the basename part.  */
   size_t basename_start;
+
+  /* True if the file has been modified since it was last checked.  */
+  bool changed;
 #endif
 
   /* See description of DEFAULT_MAX_N_... below.  */
@@ -215,6 +227,14 @@ static bool presume_input_pipe;
 /* If nonzero then don't use inotify even if available.  */
 static bool disable_inotify;
 
+/* Output collected while handling a batch of inotify events, so that
+   the data appended to many files is written with one system call
+   rather than with one or more per file.  NULL if output is not being
+   collected.  */
+static char *batch;
+static size_t batch_used;
+enum { BATCH_SIZE = 1024 * 1024 };
+
 /* For long options that have no equivalent short option, use a
    non-character as a pseudo short option, starting with CHAR_MAX + 1.  */
 enum
@@ -369,32 +389,77 @@ close_fd (int fd, const char *filename)
     }
 }
 
+/* Write N_BYTES from BUFFER to stdout, bypassing any batch.
+   Exit immediately on error with a single diagnostic.  */
+
 static void
-write_header (const char *pretty_filename)
+fwrite_stdout (char const *buffer, size_t n_bytes)
 {
-  static bool first_file = true;
+  if (n_bytes > 0 && fwrite (buffer, 1, n_bytes, stdout) < n_bytes)
+    {
+      clearerr (stdout); /* To avoid redundant close_stdout diagnostic.  */
+      error (EXIT_FAILURE, errno, _("error writing %s"),
+             quote ("standard output"));
+    }
+}
 
-  printf ("%s==> %s <==\n", (first_file ? "" : "\n"), pretty_filename);
-  first_file = false;
+/* Write the output collected in the batch, and flush stdout.  */
+
+static void
+flush_batch (void)
+{
+  fwrite_stdout (batch, batch_used);
+  batch_used = 0;
+  if (fflush (stdout) != 0)
+    error (EXIT_FAILURE, errno, _("write error"));
 }
 
-/* Write N_BYTES from BUFFER to stdout.
+/* Write N_BYTES from BUFFER to stdout, or append them to the batch if
+   output is being collected.
    Exit immediately on error with a single diagnostic.  */
 
 static void
 xwrite_stdout (char const *buffer, size_t n_bytes)
 {
-  if (n_bytes > 0 && fwrite (buffer, 1, n_bytes, stdout) < n_bytes)
+  if (batch)
     {
-      clearerr (stdout); /* To avoid redundant close_stdout diagnostic.  */
-      error (EXIT_FAILURE, errno, _("error writing %s"),
-             quote ("standard output"));
+      if (BATCH_SIZE - batch_used < n_bytes)
+        flush_batch ();
+      if (n_bytes <= BATCH_SIZE)
+        {
+          memcpy (batch + batch_used, buffer, n_bytes);
+          batch_used += n_bytes;
+          return;
+        }
+    }
+  fwrite_stdout (buffer, n_bytes);
+}
+
+static void
+write_header (const char *pretty_filename)
+{
+  static bool first_file = true;
+
+  if (batch)
+    {
+      /* Keep the header in order with the collected output.  */
+      char *header = xmalloc (strlen (pretty_filename)
+                              + sizeof "\n==>  <==\n");
+      int len = sprintf (header, "%s==> %s <==\n", (first_file ? "" : "\n"),
+                         pretty_filename);
+      xwrite_stdout (header, len);
+      free (header);
     }
+  else
+    printf ("%s==> %s <==\n", (first_file ? "" : "\n"), pretty_filename);
+  first_file = false;
 }
 
 /* Read and output N_BYTES of file PRETTY_FILENAME starting at the current
    position in FD.  If N_BYTES is COPY_TO_EOF, then copy until end of file.
    If N_BYTES is COPY_A_BUFFER, then copy at most one buffer's worth.
+   If output is being collected, read straight into the batch, as much
+   as fits at once.
    Return the number of bytes read from the file.  */
 
 static uintmax_t
@@ -406,19 +471,36 @@ dump_remainder (const char *pretty_filename, int fd, uintmax_t n_bytes)
   n_written = 0;
   while (1)
     {
-      char buffer[BUFSIZ];
-      size_t n = MIN (n_remaining, BUFSIZ);
+      char stack_buffer[BUFSIZ];
+      char *buffer = stack_buffer;
+      size_t bufsize = BUFSIZ;
+      if (batch)
+        {
+          if (BATCH_SIZE - batch_used < BUFSIZ)
+            flush_batch ();
+          buffer = batch + batch_used;
+          bufsize = BATCH_SIZE - batch_used;
+        }
+      size_t n = MIN (n_remaining, bufsize);
       size_t bytes_read = safe_read (fd, buffer, n);
       if (bytes_read == SAFE_READ_ERROR)
         {
           if (errno != EAGAIN)
-            error (EXIT_FAILURE, errno, _("error reading %s"),
-                   quote (pretty_filename));
+            {
+              int read_errno = errno;
+              if (batch)
+                flush_batch ();
+              error (EXIT_FAILURE, read_errno, _("error reading %s"),
+                     quote (pretty_filename));
+            }
           break;
         }
       if (bytes_read == 0)
         break;
-      xwrite_stdout (buffer, bytes_read);
+      if (batch)
+        batch_used += bytes_read;
+      else
+        xwrite_stdout (buffer, bytes_read);
       n_written += bytes_read;
       if (n_bytes != COPY_TO_EOF)
         {
@@ -468,10 +550,56 @@ xlseek (int fd, off_t offset, int whence, char const *filename)
   exit (EXIT_FAILURE);
 }
 
+/* A block of a file read backward by file_lines.  */
+struct tail_block
+{
+  int fd;
+  off_t pos;
+  size_t size;
+  char *buf;
+
+  /* The number of bytes read, the newlines in them, and the errno of a
+     read error, or 0.  */
+  size_t nread;
+  size_t lines;
+  int err;
+};
+
+/* Read and count the newlines in the block described by ARG, a struct
+   tail_block *.  */
+
+static void *
+read_block (void *arg)
+{
+  struct tail_block *b = arg;
+
+  b->nread = 0;
+  b->err = 0;
+  while (b->nread < b->size)
+    {
+      ssize_t n = pread (b->fd, b->buf + b->nread, b->size - b->nread,
+                         b->pos + b->nread);
+      if (n < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          b->err = errno;
+          break;
+        }
+      if (n == 0)
+        break;
+      b->nread += n;
+    }
+  b->lines = count_newlines (b->buf, b->nread);
+  return NULL;
+}
+
 /* Print the last N_LINES lines from the end of file FD.
-   Go backward through the file, reading 'BUFSIZ' bytes at a time (except
-   probably the first), until we hit the start of the file or have
-   read NUMBER newlines.
+   Go backward through the file, reading blocks of 'TAIL_BLOCK_SIZE' bytes
+   (except probably the first) and counting their newlines, until we hit
+   the start of the file or have read NUMBER newlines.  When many lines
+   remain, estimate the blocks that hold them from the average length of
+   the lines so far, and read up to one block per processor at once.
    START_POS is the starting position of the read pointer for the file
    associated with FD (may be nonzero).
    END_POS is the file offset of EOF (one larger than offset of last byte).
@@ -481,83 +609,147 @@ static bool
 file_lines (const char *pretty_filename, int fd, uintmax_t n_lines,
             off_t start_pos, off_t end_pos, uintmax_t *read_pos)
 {
-  char buffer[BUFSIZ];
-  size_t bytes_read;
+  struct tail_block blocks[TAIL_BLOCKS_MAX];
+  pthread_t threads[TAIL_BLOCKS_MAX];
+  size_t nallocated = 0;
+  size_t max_blocks = 0;
+  size_t nblocks = 1;
+  uintmax_t scanned_bytes = 0;
+  uintmax_t scanned_lines = 0;
+  bool first = true;
+  bool ok = true;
   off_t pos = end_pos;
+  off_t copy_pos;
+  size_t i;
+  size_t j;
 
   if (n_lines == 0)
     return true;
 
-  /* Set 'bytes_read' to the size of the last, probably partial, buffer;
-     0 < 'bytes_read' <= 'BUFSIZ'.  */
-  bytes_read = (pos - start_pos) % BUFSIZ;
-  if (bytes_read == 0)
-    bytes_read = BUFSIZ;
-  /* Make 'pos' a multiple of 'BUFSIZ' (0 if the file is short), so that all
-     reads will be on block boundaries, which might increase efficiency.  */
-  pos -= bytes_read;
-  xlseek (fd, pos, SEEK_SET, pretty_filename);
-  bytes_read = safe_read (fd, buffer, bytes_read);
-  if (bytes_read == SAFE_READ_ERROR)
+  while (true)
     {
-      error (0, errno, _("error reading %s"), quote (pretty_filename));
-      return false;
-    }
-  *read_pos = pos + bytes_read;
+      size_t n;
 
-  /* Count the incomplete line on files that don't end with a newline.  */
-  if (bytes_read && buffer[bytes_read - 1] != '\n')
-    --n_lines;
+      /* Read the NBLOCKS blocks before POS, all but the last in threads.
+         Make 'pos' a multiple of 'TAIL_BLOCK_SIZE' after the first, so
+         that all reads will be on block boundaries, which might increase
+         efficiency.  */
+      for (n = 0; n < nblocks && start_pos < pos; n++)
+        {
+          size_t size = (pos - start_pos) % TAIL_BLOCK_SIZE;
+          if (size == 0)
+            size = TAIL_BLOCK_SIZE;
+          pos -= size;
+          if (nallocated == n)
+            blocks[nallocated++].buf = xmalloc (TAIL_BLOCK_SIZE);
+          blocks[n].fd = fd;
+          blocks[n].pos = pos;
+          blocks[n].size = size;
+        }
+      for (j = 1; j < n; j++)
+        if (pthread_create (&threads[j], NULL, read_block, &blocks[j]) != 0)
+          break;
+      read_block (&blocks[0]);
+      for (i = 1; i < j; i++)
+        pthread_join (threads[i], NULL);
+      for (; j < n; j++)
+        read_block (&blocks[j]);
+
+      /* Scan backward through the blocks, counting their newlines.  */
+      for (i = 0; i < n; i++)
+        {
+          struct tail_block const *b = &blocks[i];
 
-  do
-    {
-      /* Scan backward, counting the newlines in this bufferfull.  */
+          if (b->err)
+            {
+              error (0, b->err, _("error reading %s"),
+                     quote (pretty_filename));
+              ok = false;
+              goto free_blocks;
+            }
 
-      size_t n = bytes_read;
-      while (n)
-        {
-          char const *nl;
-          nl = memrchr (buffer, '\n', n);
-          if (nl == NULL)
-            break;
-          n = nl - buffer;
-          if (n_lines-- == 0)
+          if (first)
             {
-              /* If this newline isn't the last character in the buffer,
-                 output the part that is after it.  */
-              if (n != bytes_read - 1)
-                xwrite_stdout (nl + 1, bytes_read - (n + 1));
-              *read_pos += dump_remainder (pretty_filename, fd,
-                                           end_pos - (pos + bytes_read));
-              return true;
+              first = false;
+              *read_pos = b->pos + b->nread;
+
+              /* Count the incomplete line on files that don't end with
+                 a newline.  */
+              if (b->nread && b->buf[b->nread - 1] != '\n')
+                --n_lines;
+            }
+
+          if (n_lines < b->lines)
+            {
+              /* Find the newline before the lines to output, and output
+                 the part of the block that is after it.  */
+              char const *nl;
+              size_t k = b->nread;
+              do
+                {
+                  nl = memrchr (b->buf, '\n', k);
+                  k = nl - b->buf;
+                }
+              while (n_lines--);
+              xwrite_stdout (nl + 1, b->nread - (k + 1));
+              break;
             }
+          n_lines -= b->lines;
+          scanned_bytes += b->nread;
+          scanned_lines += b->lines;
         }
 
-      /* Not enough newlines in that bufferfull.  */
-      if (pos == start_pos)
+      /* Not enough newlines in these blocks.  Next, read as many blocks
+         as the remaining lines probably fill, at once if possible.  If
+         there are not enough lines in the file, print everything from
+         start_pos to the end.  */
+      if (i == n && start_pos < pos)
         {
-          /* Not enough lines in the file; print everything from
-             start_pos to the end.  */
-          xlseek (fd, start_pos, SEEK_SET, pretty_filename);
-          *read_pos = start_pos + dump_remainder (pretty_filename, fd,
-                                                  end_pos);
-          return true;
+          if (max_blocks == 0)
+            max_blocks = MIN (num_processors (NPROC_CURRENT_OVERRIDABLE),
+                              TAIL_BLOCKS_MAX);
+          double est = (scanned_lines
+                        ? ((double) n_lines * scanned_bytes
+                           / ((double) scanned_lines * TAIL_BLOCK_SIZE))
+                        : max_blocks);
+          nblocks = est < max_blocks ? est + 1 : max_blocks;
+          continue;
         }
-      pos -= BUFSIZ;
-      xlseek (fd, pos, SEEK_SET, pretty_filename);
 
-      bytes_read = safe_read (fd, buffer, BUFSIZ);
-      if (bytes_read == SAFE_READ_ERROR)
+      /* Output the blocks after the newline, which have been read
+         already, and then the rest, which was read in earlier rounds.  */
+      while (i--)
+        xwrite_stdout (blocks[i].buf, blocks[i].nread);
+      copy_pos = blocks[0].pos + blocks[0].nread;
+      if (copy_pos < end_pos)
         {
-          error (0, errno, _("error reading %s"), quote (pretty_filename));
-          return false;
+          xlseek (fd, copy_pos, SEEK_SET, pretty_filename);
+          while (copy_pos < end_pos)
+            {
+              size_t bytes_read = safe_read (fd, blocks[0].buf,
+                                             MIN (TAIL_BLOCK_SIZE,
+                                                  end_pos - copy_pos));
+              if (bytes_read == SAFE_READ_ERROR)
+                {
+                  error (0, errno, _("error reading %s"),
+                         quote (pretty_filename));
+                  ok = false;
+                  break;
+                }
+              if (bytes_read == 0)
+                break;
+              xwrite_stdout (blocks[0].buf, bytes_read);
+              copy_pos += bytes_read;
+            }
+          *read_pos = copy_pos;
         }
-
-      *read_pos = pos + bytes_read;
+      break;
     }
-  while (bytes_read > 0);
 
-  return true;
+ free_blocks:
+  for (i = 0; i < nallocated; i++)
+    free (blocks[i].buf);
+  return ok;
 }
 
 /* Print the last N_LINES lines from the end of the standard input,
@@ -1339,6 +1531,8 @@ check_fspec (struct File_spec *fspec, int wd, int *prev_wd)
 
   if (S_ISREG (fspec->mode) && stats.st_size < fspec->size)
     {
+      if (batch)
+        flush_batch ();
       error (0, 0, _("%s: file truncated"), name);
       *prev_wd = wd;
       xlseek (fspec->fd, stats.st_size, SEEK_SET, name);
@@ -1355,13 +1549,43 @@ check_fspec (struct File_spec *fspec, int wd, int *prev_wd)
       *prev_wd = wd;
     }
 
-  uintmax_t bytes_read = dump_remainder (name, fspec->fd, COPY_TO_EOF);
+  /* Read only what fstat reported for a regular file, rather than reading
+     again to find the end of file.  Data appended since then is read when
+     its own event is handled.  */
+  uintmax_t bytes_read = dump_remainder (name, fspec->fd,
+                                         (S_ISREG (fspec->mode)
+                                          ? stats.st_size - fspec->size
+                                          : COPY_TO_EOF));
   fspec->size += bytes_read;
 
-  if (fflush (stdout) != 0)
+  if (! batch && fflush (stdout) != 0)
     error (EXIT_FAILURE, errno, _("write error"));
 }
 
+/* Check the N_CHANGED files in CHANGED, which have been modified, and
+   output the data appended to them in one batch.  *PREV_WD is as for
+   check_fspec.  */
+static void
+check_changed_files (struct File_spec **changed, size_t n_changed,
+                     int *prev_wd)
+{
+  static char *batch_buffer;
+  size_t i;
+
+  if (! batch_buffer)
+    batch_buffer = xmalloc (BATCH_SIZE);
+  batch = batch_buffer;
+
+  for (i = 0; i < n_changed; i++)
+    {
+      changed[i]->changed = false;
+      check_fspec (changed[i], changed[i]->wd, prev_wd);
+    }
+
+  flush_batch ();
+  batch = NULL;
+}
+
 /* Attempt to tail N_FILES files forever, or until killed.
    Check modifications using the inotify events system.
    Return false on error, or true to revert to polling.  */
@@ -1384,6 +1608,11 @@ tail_forever_inotify (int wd, struct File_spec *f, size_t n_files,
   size_t evbuf_off = 0;
   size_t len = 0;
 
+  /* The files modified according to the events read so far that have not
+     been handled, in the order of their first such event.  */
+  struct File_spec **changed;
+  size_t n_changed = 0;
+
   wd_to_name = hash_initialize (n_files, NULL, wd_hasher, wd_comparator, NULL);
   if (! wd_to_name)
     xalloc_die ();
@@ -1401,6 +1630,7 @@ tail_forever_inotify (int wd, struct File_spec *f, size_t n_files,
             evlen = fnlen;
 
           f[i].wd = -1;
+          f[i].changed = false;
 
           if (follow_mode == Follow_name)
             {
@@ -1476,8 +1706,12 @@ tail_forever_inotify (int wd, struct File_spec *f, size_t n_files,
         check_fspec (&f[i], f[i].wd, &prev_wd);
     }
 
+  /* Read many events at once, so that a burst of changes to many files
+     is handled as one batch.  */
   evlen += sizeof (struct inotify_event) + 1;
+  evlen = MAX (evlen, 64 * 1024);
   evbuf = xmalloc (evlen);
+  changed = xnmalloc (n_files, sizeof *changed);
 
   /* Wait for inotify events and handle them.  Events on directories
      ensure that watched files can be re-added when following by name.
@@ -1489,6 +1723,14 @@ tail_forever_inotify (int wd, struct File_spec *f, size_t n_files,
       struct inotify_event *ev;
       void *void_ev;
 
+      /* Once all the events read have been handled, output the data
+         appended to the files they modified, before waiting for more.  */
+      if (n_changed && len <= evbuf_off)
+        {
+          check_changed_files (changed, n_changed, &prev_wd);
+          n_changed = 0;
+        }
+
       /* When following by name without --retry, and the last file has
          been unlinked or renamed-away, diagnose it and return.  */
       if (follow_mode == Follow_name
@@ -1553,6 +1795,28 @@ tail_forever_inotify (int wd, struct File_spec *f, size_t n_files,
       ev = void_ev;
       evbuf_off += sizeof (*ev) + ev->len;
 
+      /* Handle the modifications seen so far before anything else that
+         can change which file is followed.  */
+      if (n_changed
+          && (ev->len
+              || (ev->mask & (IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF))))
+        {
+          check_changed_files (changed, n_changed, &prev_wd);
+          n_changed = 0;
+        }
+
+      /* If events were lost, check every file.  */
+      if (ev->mask & IN_Q_OVERFLOW)
+        {
+          for (i = 0; i < n_files; i++)
+            if (! f[i].ignore && ! f[i].changed)
+              {
+                f[i].changed = true;
+                changed[n_changed++] = &f[i];
+              }
+          continue;
+        }
+
       if (ev->len) /* event on ev->name in watched directory  */
         {
           size_t j;
@@ -1631,7 +1895,14 @@ tail_forever_inotify (int wd, struct File_spec *f, size_t n_files,
 
           continue;
         }
-      check_fspec (fspec, ev->wd, &prev_wd);
+
+      if (ev->len)
+        check_fspec (fspec, ev->wd, &prev_wd);
+      else if (! fspec->changed)
+        {
+          fspec->changed = true;
+          changed[n_changed++] = fspec;
+        }
     }
 }
 #endif
@@ -2167,6 +2438,8 @@ main (int argc, char **argv)
 
   atexit (close_stdout);
 
+  init_count_newlines ();
+
   have_read_stdin = false;
 
   count_lines = true;
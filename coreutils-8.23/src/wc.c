@@ -22,12 +22,14 @@
 #include <stdio.h>
 #include <assert.h>
 #include <getopt.h>
+#include <pthread.h>
 #include <sys/types.h>
 #include <wchar.h>
 #include <wctype.h>
 
 #include "system.h"
 #include "argv-iter.h"
+#include "count-newlines.h"
 #include "error.h"
 #include "fadvise.h"
 #include "mbchar.h"
@@ -37,12 +39,17 @@
 #include "readtokens0.h"
 #include "safe-read.h"
 #include "xfreopen.h"
+#include "xstrtol.h"
 
 #if !defined iswspace && !HAVE_ISWSPACE
 # define iswspace(wc) \
     ((wc) == to_uchar (wc) && isspace (to_uchar (wc)))
 #endif
 
+/* Whether to use the SSE2 and AVX2 word counting kernels, which are
+   built and selected as the line counting kernels are.  */
+#define WC_X86_SIMD COUNT_NEWLINES_X86_SIMD
+
 /* The official name of this program (e.g., no 'g' prefix).  */
 #define PROGRAM_NAME "wc"
 
@@ -53,6 +60,22 @@
 /* Size of atomic reads. */
 #define BUFFER_SIZE (16 * 1024)
 
+/* Size of the reads of each thread counting part of a file.  */
+enum { PART_BUFFER_SIZE = 128 * 1024 };
+
+/* Minimum size of each part of a file counted by its own thread.  */
+enum { PART_SIZE_MIN = 1024 * 1024 };
+
+/* Counts for one file, or for part of one.  */
+struct counts
+{
+  uintmax_t lines;
+  uintmax_t words;
+  uintmax_t chars;
+  uintmax_t bytes;
+  uintmax_t linelength;
+};
+
 /* Cumulative number of lines, words, chars and bytes in all files so far.
    max_line_length is the maximum over all files processed so far.  */
 static uintmax_t total_lines;
@@ -68,9 +91,16 @@ static bool print_linelength;
 /* The print width of each count.  */
 static int number_width;
 
+/* True if ASCII characters are classified as in the C locale, so that
+   count_ascii can be used for words.  */
+static bool ascii_kernel_ok;
+
 /* True if we have ever read the standard input. */
 static bool have_read_stdin;
 
+/* The maximum number of threads to count with.  */
+static size_t nthreads = 1;
+
 /* The result of calling fstat or stat on a file descriptor or file.  */
 struct fstatus
 {
@@ -86,7 +116,8 @@ struct fstatus
    non-character as a pseudo short option, starting with CHAR_MAX + 1.  */
 enum
 {
-  FILES0_FROM_OPTION = CHAR_MAX + 1
+  FILES0_FROM_OPTION = CHAR_MAX + 1,
+  THREADS_OPTION
 };
 
 static struct option const longopts[] =
@@ -97,6 +128,7 @@ static struct option const longopts[] =
   {"words", no_argument, NULL, 'w'},
   {"files0-from", required_argument, NULL, FILES0_FROM_OPTION},
   {"max-line-length", no_argument, NULL, 'L'},
+  {"threads", required_argument, NULL, THREADS_OPTION},
   {GETOPT_HELP_OPTION_DECL},
   {GETOPT_VERSION_OPTION_DECL},
   {NULL, 0, NULL, 0}
@@ -130,6 +162,8 @@ the following order: newline, word, character, byte, maximum line length.\n\
                            NUL-terminated names in file F;\n\
                            If F is - then read names from standard input\n\
   -L, --max-line-length  print the length of the longest line\n\
+      --threads=N        count up to N files at once, or split a large\n\
+                           regular file into up to N parts counted at once\n\
   -w, --words            print the word counts\n\
 "), stdout);
       fputs (HELP_OPTION_DESCRIPTION, stdout);
@@ -182,18 +216,433 @@ write_counts (uintmax_t lines,
   putchar ('\n');
 }
 
-/* Count words.  FILE_X is the name of the file (or NULL for standard
-   input) that is open on descriptor FD.  *FSTATUS is its status.
-   Return true if successful.  */
+/* Count the lines and the ends of words in the longest prefix of the
+   N bytes at P that contains only ASCII characters, adding them to
+   *LINES and *WORDS.  *IN_WORD tells whether a word is in progress,
+   and is updated.  Return the length of the prefix.
+
+   The characters are classified as in the C locale: a word is ended
+   by white space, continued by other printable characters, and
+   unaffected by control characters.  Each of the vectorized versions
+   of this handles blocks without control characters, where each byte
+   can be classified independently of the previous ones, and uses
+   this for the others.  */
+
+static size_t
+count_ascii_generic (char const *p, size_t n, uintmax_t *lines,
+                     uintmax_t *words, bool *in_word)
+{
+  char const *q = p;
+  char const *lim = p + n;
+  bool in = *in_word;
+
+  for (; q < lim; q++)
+    {
+      unsigned char c = *q;
+      if (0x80 <= c)
+        break;
+      if (c == ' ' || ('\t' <= c && c <= '\r'))
+        {
+          *lines += c == '\n';
+          *words += in;
+          in = false;
+        }
+      else if (' ' < c && c < 0x7f)
+        in = true;
+    }
+
+  *in_word = in;
+  return q - p;
+}
+
+#if WC_X86_SIMD
+static size_t
+count_ascii_sse2 (char const *p, size_t n, uintmax_t *lines,
+                  uintmax_t *words, bool *in_word)
+{
+  __m128i const space = _mm_set1_epi8 (' ');
+  __m128i const newline = _mm_set1_epi8 ('\n');
+  __m128i const before_tab = _mm_set1_epi8 ('\t' - 1);
+  __m128i const after_cr = _mm_set1_epi8 ('\r' + 1);
+  __m128i const del = _mm_set1_epi8 (0x7f);
+  unsigned int in = *in_word;
+  size_t i = 0;
+
+  for (; 16 <= n - i; i += 16)
+    {
+      __m128i v = _mm_loadu_si128 ((__m128i const *) (p + i));
+      unsigned int wm, sm;
+
+      if (_mm_movemask_epi8 (v))
+        break;
+
+      /* As the bytes are ASCII, signed comparisons work.  */
+      wm = _mm_movemask_epi8 (_mm_and_si128 (_mm_cmpgt_epi8 (v, space),
+                                             _mm_cmplt_epi8 (v, del)));
+      sm = _mm_movemask_epi8
+        (_mm_or_si128 (_mm_cmpeq_epi8 (v, space),
+                       _mm_and_si128 (_mm_cmpgt_epi8 (v, before_tab),
+                                      _mm_cmplt_epi8 (v, after_cr))));
+      if ((wm | sm) != 0xffff)
+        {
+          bool b = in;
+          count_ascii_generic (p + i, 16, lines, words, &b);
+          in = b;
+          continue;
+        }
+
+      *lines += __builtin_popcount (_mm_movemask_epi8
+                                    (_mm_cmpeq_epi8 (v, newline)));
+      *words += __builtin_popcount (sm & ((wm << 1) | in));
+      in = wm >> 15;
+    }
+
+  *in_word = in;
+  return i + count_ascii_generic (p + i, n - i, lines, words, in_word);
+}
+
+static size_t __attribute__ ((__target__ ("avx2,popcnt")))
+count_ascii_avx2 (char const *p, size_t n, uintmax_t *lines,
+                  uintmax_t *words, bool *in_word)
+{
+  __m256i const space = _mm256_set1_epi8 (' ');
+  __m256i const newline = _mm256_set1_epi8 ('\n');
+  __m256i const before_tab = _mm256_set1_epi8 ('\t' - 1);
+  __m256i const after_cr = _mm256_set1_epi8 ('\r' + 1);
+  __m256i const del = _mm256_set1_epi8 (0x7f);
+  unsigned int in = *in_word;
+  size_t i = 0;
+
+  for (; 32 <= n - i; i += 32)
+    {
+      __m256i v = _mm256_loadu_si256 ((__m256i const *) (p + i));
+      unsigned int wm, sm;
+
+      if (_mm256_movemask_epi8 (v))
+        break;
+
+      wm = _mm256_movemask_epi8
+        (_mm256_and_si256 (_mm256_cmpgt_epi8 (v, space),
+                           _mm256_cmpgt_epi8 (del, v)));
+      sm = _mm256_movemask_epi8
+        (_mm256_or_si256 (_mm256_cmpeq_epi8 (v, space),
+                          _mm256_and_si256 (_mm256_cmpgt_epi8 (v, before_tab),
+                                            _mm256_cmpgt_epi8 (after_cr, v))));
+      if ((wm | sm) != 0xffffffff)
+        {
+          bool b = in;
+          count_ascii_generic (p + i, 32, lines, words, &b);
+          in = b;
+          continue;
+        }
+
+      *lines += __builtin_popcount (_mm256_movemask_epi8
+                                    (_mm256_cmpeq_epi8 (v, newline)));
+      *words += __builtin_popcount (sm & ((wm << 1) | in));
+      in = wm >> 31;
+    }
+
+  *in_word = in;
+  return i + count_ascii_generic (p + i, n - i, lines, words, in_word);
+}
+#endif
+
+/* The word counting kernel for this processor.  */
+static size_t (*count_ascii) (char const *, size_t, uintmax_t *, uintmax_t *,
+                              bool *) = count_ascii_generic;
+
+/* Select the counting kernels, and check whether count_ascii agrees
+   with the current locale.  */
+
+static void
+init_kernels (void)
+{
+  int c;
+
+  init_count_newlines ();
+#if WC_X86_SIMD
+  if (__builtin_cpu_supports ("avx2"))
+    count_ascii = count_ascii_avx2;
+  else
+    count_ascii = count_ascii_sse2;
+#endif
+
+  /* White space that wc handles specially is always a separator;
+     otherwise wc goes by whether a character is printable and white
+     space.  */
+  ascii_kernel_ok = true;
+  for (c = 0; c < 0x80; c++)
+    if (! (c == ' ' || ('\t' <= c && c <= '\r')))
+      {
+        bool printable, space;
+#if MB_LEN_MAX > 1
+        if (MB_CUR_MAX > 1)
+          {
+            wint_t wc = btowc (c);
+            printable = wc != WEOF && iswprint (wc);
+            space = wc != WEOF && iswspace (wc);
+          }
+        else
+#endif
+          {
+            printable = isprint (c) != 0;
+            space = isspace (c) != 0;
+          }
+        if (printable != (' ' < c && c < 0x7f) || (printable && space))
+          ascii_kernel_ok = false;
+      }
+}
+
+/* Count the N bytes at P in a single-byte locale, adding to the
+   lines, words and maximum line length in *C.  *IN_WORD and *LINEPOS
+   are the state of the current word and line, and are updated; a
+   word still in progress after the last byte is not counted.  Use
+   count_ascii if USE_ASCII_KERNEL.  N must be positive.  */
+
+static void
+count_sb (char const *p, size_t n, struct counts *c, bool *in_word,
+          uintmax_t *linepos, bool use_ascii_kernel)
+{
+  uintmax_t lines = c->lines;
+  uintmax_t words = c->words;
+  uintmax_t linelength = c->linelength;
+  uintmax_t pos = *linepos;
+  bool in = *in_word;
+
+  do
+    {
+      if (use_ascii_kernel)
+        {
+          size_t k = count_ascii (p, n, &lines, &words, &in);
+          p += k;
+          n -= k;
+          if (n == 0)
+            break;
+        }
+
+      switch (*p++)
+        {
+        case '\n':
+          lines++;
+          /* Fall through. */
+        case '\r':
+        case '\f':
+          if (pos > linelength)
+            linelength = pos;
+          pos = 0;
+          goto word_separator;
+        case '\t':
+          pos += 8 - (pos % 8);
+          goto word_separator;
+        case ' ':
+          pos++;
+          /* Fall through. */
+        case '\v':
+        word_separator:
+          words += in;
+          in = false;
+          break;
+        default:
+          if (isprint (to_uchar (p[-1])))
+            {
+              pos++;
+              if (isspace (to_uchar (p[-1])))
+                goto word_separator;
+              in = true;
+            }
+          break;
+        }
+    }
+  while (--n);
+
+  c->lines = lines;
+  c->words = words;
+  c->linelength = linelength;
+  *linepos = pos;
+  *in_word = in;
+}
+
+/* How the first byte of part of a file that is not a control
+   character affects counting words, in a single-byte locale.  */
+enum word_lead
+{
+  LEAD_NONE,			/* There is no such byte.  */
+  LEAD_SPACE,			/* It ends any word in progress.  */
+  LEAD_WORD			/* It starts or continues a word.  */
+};
+
+/* Return how the N bytes at P start, as far as words go.  */
+
+static enum word_lead _GL_ATTRIBUTE_PURE
+word_lead (char const *p, size_t n)
+{
+  char const *lim = p + n;
+
+  for (; p < lim; p++)
+    {
+      unsigned char c = *p;
+      if (c == ' ' || ('\t' <= c && c <= '\r'))
+        return LEAD_SPACE;
+      if (isprint (c))
+        return isspace (c) ? LEAD_SPACE : LEAD_WORD;
+    }
+  return LEAD_NONE;
+}
+
+/* Part of a regular file, counted by one thread.  */
+struct wc_part
+{
+  int fd;
+  off_t start;
+
+  /* The end of the part, or -1 to read to the end of the file.  */
+  off_t end;
+
+  /* The lines and bytes in the part and, if words are counted, the
+     words that end within it when it is counted from outside a word.  */
+  struct counts c;
+
+  /* How the part starts, and whether it ends within a word.  */
+  enum word_lead lead;
+  bool in_word;
+
+  /* The errno of a read error, or 0.  */
+  int err;
+};
+
+/* Count the part of a file described by ARG, a struct wc_part *.  */
+
+static void *
+part_thread (void *arg)
+{
+  struct wc_part *part = arg;
+  char *buf = xmalloc (PART_BUFFER_SIZE);
+  off_t pos = part->start;
+  uintmax_t linepos = 0;
+
+  while (part->end < 0 || pos < part->end)
+    {
+      size_t size = (part->end < 0
+                     ? PART_BUFFER_SIZE
+                     : MIN (PART_BUFFER_SIZE, part->end - pos));
+      ssize_t nread = pread (part->fd, buf, size, pos);
+      if (nread < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          part->err = errno;
+          break;
+        }
+      if (nread == 0)
+        break;
+
+      pos += nread;
+      part->c.bytes += nread;
+      if (print_words)
+        {
+          if (part->lead == LEAD_NONE)
+            part->lead = word_lead (buf, nread);
+          count_sb (buf, nread, &part->c, &part->in_word, &linepos,
+                    ascii_kernel_ok);
+        }
+      else
+        part->c.lines += count_newlines (buf, nread);
+    }
+
+  free (buf);
+  return NULL;
+}
+
+/* Add the lines, words and bytes of the file open on FD to *LINES,
+   *WORDS and *BYTES, as wc does in a single-byte locale, but by
+   splitting the file into up to NPARTS parts of roughly equal size
+   that are counted in threads.  Store the errno of the first read
+   error into *ERR, or 0.  Return false without reading anything if FD
+   is not a regular file large enough to be worth splitting.
+
+   A word that spans parts is counted in the part where it ends: a
+   part counted from outside a word ends one more word if the first
+   byte that affects words is white space, and the previous part
+   ended within a word.  */
+
 static bool
-wc (int fd, char const *file_x, struct fstatus *fstatus)
+wc_parallel (int fd, size_t nparts, uintmax_t *lines, uintmax_t *words,
+             uintmax_t *bytes, int *err)
 {
-  bool ok = true;
+  struct stat st;
+  off_t start;
+  off_t size;
+  struct wc_part *parts;
+  pthread_t *threads;
+  bool in_word = false;
+  uintmax_t nread = 0;
+  size_t i;
+  size_t j;
+
+  if (fstat (fd, &st) != 0 || ! S_ISREG (st.st_mode)
+      || (start = lseek (fd, 0, SEEK_CUR)) < 0
+      || st.st_size - start < 2 * PART_SIZE_MIN)
+    return false;
+
+  size = st.st_size - start;
+  nparts = MIN (nparts, size / PART_SIZE_MIN);
+  parts = xcalloc (nparts, sizeof *parts);
+  threads = xnmalloc (nparts, sizeof *threads);
+
+  for (i = 0; i < nparts; i++)
+    {
+      parts[i].fd = fd;
+      parts[i].start = start + size / nparts * i;
+      parts[i].end = -1;
+      if (i + 1 < nparts)
+        parts[i].end = parts[i].start + size / nparts;
+    }
+
+  for (i = 1; i < nparts; i++)
+    if (pthread_create (&threads[i], NULL, part_thread, &parts[i]) != 0)
+      break;
+  part_thread (&parts[0]);
+  for (j = 1; j < i; j++)
+    pthread_join (threads[j], NULL);
+  for (; j < nparts; j++)
+    part_thread (&parts[j]);
+
+  *err = 0;
+  for (i = 0; i < nparts; i++)
+    {
+      struct wc_part const *part = &parts[i];
+      *lines += part->c.lines;
+      *words += part->c.words + (in_word && part->lead == LEAD_SPACE);
+      nread += part->c.bytes;
+      if (part->lead != LEAD_NONE)
+        in_word = part->in_word;
+      if (! *err)
+        *err = part->err;
+    }
+  *words += in_word;
+  *bytes += nread;
+
+  /* Leave the file offset where reading the file serially would.  */
+  lseek (fd, start + nread, SEEK_SET);
+
+  free (threads);
+  free (parts);
+  return true;
+}
+
+/* Count the file open on descriptor FD into *C.  *FSTATUS is its
+   status.  If the counts allow it, split a large regular file into up
+   to NPARTS parts that are counted in threads.  Return 0 if
+   successful, and otherwise the errno of the read error.  */
+static int
+wc (int fd, struct fstatus *fstatus, size_t nparts, struct counts *c)
+{
+  int err = 0;
   char buf[BUFFER_SIZE + 1];
   size_t bytes_read;
   uintmax_t lines, words, chars, bytes, linelength;
   bool count_bytes, count_chars, count_complicated;
-  char const *file = file_x ? file_x : _("standard input");
+  bool use_ascii_kernel = ascii_kernel_ok && !print_linelength;
 
   lines = words = chars = bytes = linelength = 0;
 
@@ -249,34 +698,32 @@ wc (int fd, char const *file_x, struct fstatus *fstatus)
             {
               if (bytes_read == SAFE_READ_ERROR)
                 {
-                  error (0, errno, "%s", file);
-                  ok = false;
+                  err = errno;
                   break;
                 }
               bytes += bytes_read;
             }
         }
     }
+  else if (1 < nparts && !count_chars && !print_linelength
+           && ! (print_words && 1 < MB_CUR_MAX)
+           && wc_parallel (fd, nparts, &lines, &words, &bytes, &err))
+    {
+      /* The file was counted in parallel.  */
+    }
   else if (!count_chars && !count_complicated)
     {
       /* Use a separate loop when counting only lines or lines and bytes --
          but not chars or words.  */
       while ((bytes_read = safe_read (fd, buf, BUFFER_SIZE)) > 0)
         {
-          char *p = buf;
-
           if (bytes_read == SAFE_READ_ERROR)
             {
-              error (0, errno, "%s", file);
-              ok = false;
+              err = errno;
               break;
             }
 
-          while ((p = memchr (p, '\n', (buf + bytes_read) - p)))
-            {
-              ++p;
-              ++lines;
-            }
+          lines += count_newlines (buf, bytes_read);
           bytes += bytes_read;
         }
     }
@@ -309,8 +756,7 @@ wc (int fd, char const *file_x, struct fstatus *fstatus)
 # endif
           if (bytes_read == SAFE_READ_ERROR)
             {
-              error (0, errno, "%s", file);
-              ok = false;
+              err = errno;
               break;
             }
 
@@ -322,6 +768,17 @@ wc (int fd, char const *file_x, struct fstatus *fstatus)
               wchar_t wide_char;
               size_t n;
 
+              if (use_ascii_kernel && !in_shift)
+                {
+                  /* Handle runs of ASCII characters a block at a time.  */
+                  n = count_ascii (p, bytes_read, &lines, &words, &in_word);
+                  p += n;
+                  bytes_read -= n;
+                  chars += n;
+                  if (bytes_read == 0)
+                    break;
+                }
+
               if (!in_shift && is_basic (*p))
                 {
                   /* Handle most ASCII characters quickly, without calling
@@ -422,57 +879,25 @@ wc (int fd, char const *file_x, struct fstatus *fstatus)
 #endif
   else
     {
+      struct counts sb = { 0, };
       bool in_word = false;
       uintmax_t linepos = 0;
 
       while ((bytes_read = safe_read (fd, buf, BUFFER_SIZE)) > 0)
         {
-          const char *p = buf;
           if (bytes_read == SAFE_READ_ERROR)
             {
-              error (0, errno, "%s", file);
-              ok = false;
+              err = errno;
               break;
             }
 
           bytes += bytes_read;
-          do
-            {
-              switch (*p++)
-                {
-                case '\n':
-                  lines++;
-                  /* Fall through. */
-                case '\r':
-                case '\f':
-                  if (linepos > linelength)
-                    linelength = linepos;
-                  linepos = 0;
-                  goto word_separator;
-                case '\t':
-                  linepos += 8 - (linepos % 8);
-                  goto word_separator;
-                case ' ':
-                  linepos++;
-                  /* Fall through. */
-                case '\v':
-                word_separator:
-                  words += in_word;
-                  in_word = false;
-                  break;
-                default:
-                  if (isprint (to_uchar (p[-1])))
-                    {
-                      linepos++;
-                      if (isspace (to_uchar (p[-1])))
-                        goto word_separator;
-                      in_word = true;
-                    }
-                  break;
-                }
-            }
-          while (--bytes_read);
+          count_sb (buf, bytes_read, &sb, &in_word, &linepos,
+                    use_ascii_kernel);
         }
+      lines = sb.lines;
+      words = sb.words;
+      linelength = sb.linelength;
       if (linepos > linelength)
         linelength = linepos;
       words += in_word;
@@ -481,46 +906,215 @@ wc (int fd, char const *file_x, struct fstatus *fstatus)
   if (count_chars < print_chars)
     chars = bytes;
 
-  write_counts (lines, words, chars, bytes, linelength, file_x);
-  total_lines += lines;
-  total_words += words;
-  total_chars += chars;
-  total_bytes += bytes;
-  if (linelength > max_line_length)
-    max_line_length = linelength;
+  c->lines = lines;
+  c->words = words;
+  c->chars = chars;
+  c->bytes = bytes;
+  c->linelength = linelength;
+  return err;
+}
+
+/* The result of counting a file.  */
+struct wc_result
+{
+  struct counts c;
+
+  /* The errno of failing to open, read or close the file, or 0.  */
+  int open_errno;
+  int read_errno;
+  int close_errno;
+};
+
+/* Count FILE, the name of a file other than standard input, into *R.
+   *FSTATUS is its status.  Split it into up to NPARTS parts as wc
+   does.  */
 
-  return ok;
+static void
+count_file (char const *file, struct fstatus *fstatus, size_t nparts,
+            struct wc_result *r)
+{
+  int fd = open (file, O_RDONLY | O_BINARY);
+
+  r->open_errno = r->read_errno = r->close_errno = 0;
+  if (fd == -1)
+    r->open_errno = errno;
+  else
+    {
+      r->read_errno = wc (fd, fstatus, nparts, &r->c);
+      if (close (fd) != 0)
+        r->close_errno = errno;
+    }
+}
+
+/* Diagnose the errors in the result *R of counting FILE (or NULL for
+   standard input), and print the counts and add them to the totals
+   if the file was opened.  Return true if successful.  */
+
+static bool
+report_file (char const *file, struct wc_result const *r)
+{
+  struct counts const *c = &r->c;
+
+  if (r->open_errno)
+    {
+      error (0, r->open_errno, "%s", file);
+      return false;
+    }
+  if (r->read_errno)
+    error (0, r->read_errno, "%s", file ? file : _("standard input"));
+
+  write_counts (c->lines, c->words, c->chars, c->bytes, c->linelength, file);
+  total_lines += c->lines;
+  total_words += c->words;
+  total_chars += c->chars;
+  total_bytes += c->bytes;
+  if (c->linelength > max_line_length)
+    max_line_length = c->linelength;
+
+  if (r->close_errno)
+    {
+      error (0, r->close_errno, "%s", file);
+      return false;
+    }
+  return ! r->read_errno;
 }
 
 static bool
 wc_file (char const *file, struct fstatus *fstatus)
 {
+  struct wc_result r;
+
   if (! file || STREQ (file, "-"))
     {
       have_read_stdin = true;
       if (O_BINARY && ! isatty (STDIN_FILENO))
         xfreopen (NULL, "rb", stdin);
-      return wc (STDIN_FILENO, file, fstatus);
+      r.open_errno = r.close_errno = 0;
+      r.read_errno = wc (STDIN_FILENO, fstatus, nthreads, &r.c);
     }
   else
+    count_file (file, fstatus, nthreads, &r);
+
+  return report_file (file, &r);
+}
+
+/* A file operand counted by any of the threads, with --threads.  */
+struct file_job
+{
+  /* The file name, or NULL if the main loop counts the file itself.  */
+  char const *file;
+
+  struct fstatus *fstatus;
+  struct wc_result result;
+  bool done;
+};
+
+/* The file operands, and the index of the next one to count.  That
+   index and the DONE members are protected by JOB_LOCK.  */
+static struct file_job *jobs;
+static size_t njobs;
+static size_t next_job;
+static pthread_mutex_t job_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t job_done = PTHREAD_COND_INITIALIZER;
+
+/* Count the next file operand that no thread has started on.
+   Return false if there is none.  */
+
+static bool
+run_job (void)
+{
+  struct file_job *job;
+
+  pthread_mutex_lock (&job_lock);
+  while (next_job < njobs && ! jobs[next_job].file)
+    next_job++;
+  job = next_job < njobs ? &jobs[next_job++] : NULL;
+  pthread_mutex_unlock (&job_lock);
+  if (! job)
+    return false;
+
+  count_file (job->file, job->fstatus, 1, &job->result);
+
+  pthread_mutex_lock (&job_lock);
+  job->done = true;
+  pthread_cond_broadcast (&job_done);
+  pthread_mutex_unlock (&job_lock);
+  return true;
+}
+
+/* Count file operands until none are left.  */
+
+static void *
+job_thread (void *arg _GL_UNUSED)
+{
+  while (run_job ())
+    continue;
+  return NULL;
+}
+
+/* Return the result of counting the file operand with index I,
+   counting later operands while waiting for it.  */
+
+static struct wc_result const *
+wait_job (size_t i)
+{
+  bool done;
+
+  do
     {
-      int fd = open (file, O_RDONLY | O_BINARY);
-      if (fd == -1)
-        {
-          error (0, errno, "%s", file);
-          return false;
-        }
-      else
-        {
-          bool ok = wc (fd, file, fstatus);
-          if (close (fd) != 0)
-            {
-              error (0, errno, "%s", file);
-              return false;
-            }
-          return ok;
-        }
+      pthread_mutex_lock (&job_lock);
+      done = jobs[i].done;
+      pthread_mutex_unlock (&job_lock);
+    }
+  while (! done && run_job ());
+
+  pthread_mutex_lock (&job_lock);
+  while (! jobs[i].done)
+    pthread_cond_wait (&job_done, &job_lock);
+  pthread_mutex_unlock (&job_lock);
+  return &jobs[i].result;
+}
+
+/* Start counting the NFILES FILES, whose status is in FSTATUS, with
+   up to nthreads threads including this one.  The files are counted
+   in any order, but the main loop reports them in order, so that the
+   output is the same as when counting serially.  Standard input and
+   empty file names are left to the main loop.  Store the number of
+   threads started into *NWORKERS and return their IDs.  Leave JOBS
+   null if there are too few files to count in parallel.  */
+
+static pthread_t *
+start_jobs (int nfiles, char *const *files, struct fstatus *fstatus,
+            size_t *nworkers)
+{
+  pthread_t *workers;
+  size_t nvalid = 0;
+  size_t i;
+
+  if (nthreads < 2)
+    return NULL;
+  njobs = nfiles;
+  for (i = 0; i < njobs; i++)
+    nvalid += files[i] && files[i][0] && ! STREQ (files[i], "-");
+  if (nvalid < 2)
+    return NULL;
+
+  jobs = xnmalloc (njobs, sizeof *jobs);
+  for (i = 0; i < njobs; i++)
+    {
+      jobs[i].file = (files[i] && files[i][0] && ! STREQ (files[i], "-")
+                      ? files[i] : NULL);
+      jobs[i].fstatus = &fstatus[i];
+      jobs[i].done = false;
     }
+
+  *nworkers = MIN (nthreads, nvalid) - 1;
+  workers = xnmalloc (*nworkers, sizeof *workers);
+  for (i = 0; i < *nworkers; i++)
+    if (pthread_create (&workers[i], NULL, job_thread, NULL) != 0)
+      break;
+  *nworkers = i;
+  return workers;
 }
 
 /* Return the file status for the NFILES files addressed by FILE.
@@ -597,6 +1191,8 @@ main (int argc, char **argv)
   char *files_from = NULL;
   struct fstatus *fstatus;
   struct Tokens tok;
+  pthread_t *workers;
+  size_t nworkers = 0;
 
   initialize_main (&argc, &argv);
   set_program_name (argv[0]);
@@ -610,6 +1206,8 @@ main (int argc, char **argv)
      so that processes running in parallel do not intersperse their output.  */
   setvbuf (stdout, NULL, _IOLBF, 0);
 
+  init_kernels ();
+
   print_lines = print_words = print_chars = print_bytes = false;
   print_linelength = false;
   total_lines = total_words = total_chars = total_bytes = max_line_length = 0;
@@ -641,6 +1239,20 @@ main (int argc, char **argv)
         files_from = optarg;
         break;
 
+      case THREADS_OPTION:
+        {
+          unsigned long int n;
+          enum strtol_error e = xstrtoul (optarg, NULL, 10, &n, "");
+          if (e == LONGINT_OVERFLOW || SIZE_MAX < n)
+            nthreads = SIZE_MAX;
+          else if (e != LONGINT_OK || n == 0)
+            error (EXIT_FAILURE, 0, _("invalid number of threads: %s"),
+                   quote (optarg));
+          else
+            nthreads = n;
+        }
+        break;
+
       case_GETOPT_HELP_CHAR;
 
       case_GETOPT_VERSION_CHAR (PROGRAM_NAME, AUTHORS);
@@ -715,6 +1327,7 @@ main (int argc, char **argv)
 
   fstatus = get_input_fstatus (nfiles, files);
   number_width = compute_number_width (nfiles, fstatus);
+  workers = start_jobs (nfiles, files, fstatus, &nworkers);
 
   int i;
   ok = true;
@@ -772,6 +1385,8 @@ main (int argc, char **argv)
 
       if (skip_file)
         ok = false;
+      else if (jobs && jobs[i].file)
+        ok &= report_file (file_name, wait_job (i));
       else
         ok &= wc_file (file_name, &fstatus[nfiles ? i : 0]);
     }
@@ -783,6 +1398,15 @@ main (int argc, char **argv)
   if (ok && !files_from && argv_iter_n_args (ai) == 0)
     ok &= wc_file (NULL, &fstatus[0]);
 
+  if (jobs)
+    {
+      size_t j;
+      for (j = 0; j < nworkers; j++)
+        pthread_join (workers[j], NULL);
+      free (workers);
+      free (jobs);
+    }
+
   if (read_tokens)
     readtokens0_free (&tok);
 
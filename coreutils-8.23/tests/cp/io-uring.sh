@@ -0,0 +1,72 @@
+#!/bin/sh
+# Test that cp -R copies small files the same with and without io_uring.
+
+# Copyright (C) 2014 Free Software Foundation, Inc.
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. "${srcdir=.}/tests/init.sh"; path_prepend_ ./src
+print_ver_ cp
+
+# Make a tree with more small files than are copied at once, files of
+# sizes around the largest copied with io_uring, an empty file, hard
+# links, and a dangling symlink.
+mkdir -p src/d/sub || framework_failure_
+for i in 1 2 3 4 5 6 7 8 9; do
+  for j in 0 1 2 3 4 5 6 7 8 9; do
+    echo $i $j > src/d/f$i$j || framework_failure_
+  done
+done
+for size in 65535 65536 65537; do
+  head -c $size /dev/urandom > src/d/sub/s$size || framework_failure_
+done
+touch src/d/empty || framework_failure_
+ln src/d/f11 src/d/sub/link || framework_failure_
+ln -s nowhere src/d/dangling || framework_failure_
+chmod 750 src/d/f22 || framework_failure_
+
+list() { (cd "$1" && find . -printf '%p %m %n %y %s\n' | LC_ALL=C sort); }
+
+cp -R ---disable-io-uring src exp-dst || fail=1
+list exp-dst > exp || framework_failure_
+
+cp -R src dst || fail=1
+diff -r --no-dereference exp-dst dst || fail=1
+list dst > out || framework_failure_
+compare exp out || fail=1
+
+cp -R --preserve=links src dst-links || fail=1
+test $(stat --format %i dst-links/d/f11) \
+  = $(stat --format %i dst-links/d/sub/link) || fail=1
+
+# Errors in the files copied with io_uring are diagnosed as usual.
+mkdir -p dst2/src/d || framework_failure_
+ln -s nowhere dst2/src/d/f55 || framework_failure_
+cp -R src dst2 2> err && fail=1
+echo "cp: not writing through dangling symlink 'dst2/src/d/f55'" > exp-err \
+  || framework_failure_
+compare exp-err err || fail=1
+cmp src/d/f56 dst2/src/d/f56 || fail=1
+
+# So is a source that cannot be opened, which is opened as by copy_reg.
+chmod a-r src/d/f33 || framework_failure_
+if ! cat src/d/f33 > /dev/null 2>&1; then
+  cp -R ---disable-io-uring src exp-dst3 2> exp-err && fail=1
+  cp -R src dst3 2> err && fail=1
+  compare exp-err err || fail=1
+  test -e dst3/d/f33 && fail=1
+  cmp src/d/f34 dst3/d/f34 || fail=1
+fi
+
+Exit $fail
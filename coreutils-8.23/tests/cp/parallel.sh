@@ -0,0 +1,67 @@
+#!/bin/sh
+# Test cp -R --parallel.
+
+# Copyright (C) 2014 Free Software Foundation, Inc.
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. "${srcdir=.}/tests/init.sh"; path_prepend_ ./src
+print_ver_ cp
+
+# Make a tree with many small files, hard links within and across
+# directories, a symlink, a read-only directory, and old time stamps.
+mkdir src || framework_failure_
+for i in 1 2 3 4 5 6 7 8; do
+  mkdir -p src/d$i/sub || framework_failure_
+  for j in 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16; do
+    echo $i $j > src/d$i/f$j || framework_failure_
+  done
+  head -c 100000 /dev/zero > src/d$i/sub/big || framework_failure_
+  ln src/d$i/f1 src/d$i/sub/link || framework_failure_
+  ln src/d1/f2 src/d$i/sub/shared 2> /dev/null
+done
+ln -s f1 src/d2/symlink || framework_failure_
+touch -d 2001-01-01 src/d3/f3 src/d3/sub src/d3 || framework_failure_
+chmod a-w src/d4/sub src/d4 || framework_failure_
+
+list() { (cd "$1" && find . -printf '%p %m %T@ %n %y %s\n' | LC_ALL=C sort); }
+
+cp -a src serial || fail=1
+list serial > exp || framework_failure_
+
+for n in 1 2 8; do
+  cp -a --parallel=$n src par$n || fail=1
+  diff -r serial par$n || fail=1
+  list par$n > out || framework_failure_
+  compare exp out || fail=1
+  test $(stat --format %i par$n/d1/f2) = $(stat --format %i par$n/d8/sub/shared) \
+    || fail=1
+done
+
+# Errors in the files copied in threads are diagnosed, and cause failure.
+mkdir -p dst/src/d5 || framework_failure_
+ln -s nowhere dst/src/d5/f7 || framework_failure_
+cp -R --parallel=4 src dst 2> err && fail=1
+echo "cp: not writing through dangling symlink 'dst/src/d5/f7'" > exp-err \
+  || framework_failure_
+compare exp-err err || fail=1
+cmp src/d5/f8 dst/src/d5/f8 || fail=1
+
+cp -R --parallel=0 src bad 2> err && fail=1
+echo "cp: invalid number of threads: '0'" > exp-err || framework_failure_
+compare exp-err err || fail=1
+
+chmod -R u+w src serial par1 par2 par8 dst
+
+Exit $fail
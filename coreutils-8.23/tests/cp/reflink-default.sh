@@ -0,0 +1,62 @@
+#!/bin/sh
+# Test the default cloning and the kernel copying of cp.
+
+# Copyright (C) 2014 Free Software Foundation, Inc.
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. "${srcdir=.}/tests/init.sh"; path_prepend_ ./src
+print_ver_ cp
+require_sparse_support_
+
+# Make a file with data, then a hole, then more data, then a hole at EOF.
+printf 'head\n' > f || framework_failure_
+dd bs=1 seek=1M of=f < /dev/null 2> /dev/null || framework_failure_
+head -c 300000 /dev/urandom >> f || framework_failure_
+dd bs=1 seek=3M of=f < /dev/null 2> /dev/null || framework_failure_
+
+# By default, cp clones if it can, and otherwise copies the data,
+# preserving the holes whether or not it copies within the kernel.
+cp f default || fail=1
+cmp f default || fail=1
+test $(stat --printf %b default) -le $(stat --printf %b f) || fail=1
+
+cp --reflink=auto f auto || fail=1
+cmp f auto || fail=1
+
+cp --reflink=never f never || fail=1
+cmp f never || fail=1
+test $(stat --printf %b never) -le $(stat --printf %b f) || fail=1
+
+# Copying over a larger file truncates it.
+head -c 4M /dev/zero | tr '\0' x > larger || framework_failure_
+cp f larger || fail=1
+cmp f larger || fail=1
+
+# --sparse=always and --sparse=never turn off the default cloning,
+# but still conflict with an explicit --reflink.
+for sparse in always never; do
+  cp --sparse=$sparse f sparse-$sparse || fail=1
+  cmp f sparse-$sparse || fail=1
+  cp --sparse=$sparse --reflink=never f sparse-$sparse || fail=1
+  cmp f sparse-$sparse || fail=1
+  cp --sparse=$sparse --reflink f sparse-$sparse && fail=1
+done
+test $(stat --printf %b sparse-never) -ge $(stat --printf %b never) || fail=1
+
+# Copying to something other than a regular file still works.
+cp f /dev/null || fail=1
+cp f /dev/stdout | cmp f - || fail=1
+
+Exit $fail
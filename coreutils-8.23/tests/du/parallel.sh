@@ -0,0 +1,72 @@
+#!/bin/sh
+# Test du --parallel.
+
+# Copyright (C) 2014 Free Software Foundation, Inc.
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. "${srcdir=.}/tests/init.sh"; path_prepend_ ./src
+print_ver_ du
+
+# Make a tree with many directories, files of different sizes, symlinks
+# and hard links between directories, and a chain of directories deeper
+# than a thread keeps open.
+for i in 1 2 3 4 5 6 7 8; do
+  for j in 1 2 3 4; do
+    mkdir -p t/d$i/e$j/f || framework_failure_
+    for k in 1 2 3; do
+      head -c $(($i * $j * $k * 1000)) /dev/zero > t/d$i/e$j/f/g$k \
+        || framework_failure_
+    done
+    ln -s nowhere t/d$i/e$j/dangling || framework_failure_
+  done
+done
+ln t/d1/e1/f/g3 t/d2/e2/f/link || framework_failure_
+ln t/d3/e4/f/g3 t/link || framework_failure_
+deep=t/deep/$(seq 40 | tr -sc '\n' k | tr '\n' /)
+mkdir -p $deep || framework_failure_
+echo bottom > $deep/bottom || framework_failure_
+
+# The output is the same as without --parallel, for the options that
+# leave directories unprinted, which are those counted in threads.
+for opts in -s -sb -sl -sS -d1 -d2 '-d1 -S' '-a -d1' '-s --inodes' \
+            '-s --exclude=g2' '-c -s t/d1 t/d2 t/link' '-d1 --time'; do
+  case $opts in
+    *' t/'*) files= ;;
+    *) files=t ;;
+  esac
+  du $opts $files > exp || fail=1
+  for n in 2 8; do
+    du --parallel=$n $opts $files > out || fail=1
+    compare exp out || fail=1
+  done
+done
+
+# An unreadable directory is diagnosed, and the others are counted.
+if ! uid_is_privileged_; then
+  mkdir -p t/d5/unreadable/sub || framework_failure_
+  chmod a-r t/d5/unreadable || framework_failure_
+  du -s t > exp 2> err-exp
+  status=$?
+  du -s --parallel=4 t > out 2> err
+  test $? = $status || fail=1
+  test $status = 1 || fail=1
+  compare exp out || fail=1
+  compare err-exp err || fail=1
+  chmod a+r t/d5/unreadable
+fi
+
+du --parallel=0 t 2> /dev/null && fail=1
+
+Exit $fail
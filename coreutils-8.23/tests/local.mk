@@ -170,6 +170,7 @@ all_tests =					\
   tests/tail-2/F-vs-missing.sh			\
   tests/tail-2/F-vs-rename.sh			\
   tests/tail-2/inotify-rotate.sh		\
+  tests/tail-2/follow-benchmark.sh		\
   tests/chmod/no-x.sh				\
   tests/chgrp/basic.sh				\
   tests/rm/dangling-symlink.sh			\
@@ -200,6 +201,7 @@ all_tests =					\
   tests/rm/interactive-once.sh			\
   tests/rm/ir-1.sh				\
   tests/rm/one-file-system2.sh			\
+  tests/rm/parallel.sh				\
   tests/rm/r-1.sh				\
   tests/rm/r-2.sh				\
   tests/rm/r-3.sh				\
@@ -234,6 +236,7 @@ all_tests =					\
   tests/misc/head.pl				\
   tests/misc/head-elide-tail.pl			\
   tests/tail-2/tail-n0f.sh			\
+  tests/tail-2/tail-n-large.sh			\
   tests/misc/ls-misc.pl				\
   tests/misc/date.pl				\
   tests/misc/date-next-dow.pl			\
@@ -255,9 +258,13 @@ all_tests =					\
   tests/misc/wc.pl				\
   tests/misc/wc-files0-from.pl			\
   tests/misc/wc-files0.sh			\
+  tests/misc/wc-benchmark.sh			\
   tests/misc/wc-parallel.sh			\
+  tests/misc/wc-threads.sh			\
   tests/misc/cat-proc.sh			\
   tests/misc/cat-buf.sh				\
+  tests/misc/cat-kernel-copy.sh			\
+  tests/misc/cat-show.sh			\
   tests/misc/base64.pl				\
   tests/misc/basename.pl			\
   tests/misc/close-stdout.sh			\
@@ -281,10 +288,13 @@ all_tests =					\
   tests/misc/head-c.sh				\
   tests/misc/head-pos.sh			\
   tests/misc/head-write-error.sh		\
+  tests/misc/cksum-engines.sh			\
   tests/misc/md5sum.pl				\
   tests/misc/md5sum-bsd.sh			\
   tests/misc/md5sum-newline.pl			\
   tests/misc/md5sum-parallel.sh			\
+  tests/misc/md5sum-jobs.sh			\
+  tests/misc/md5sum-tree.sh			\
   tests/misc/mknod.sh				\
   tests/misc/nice.sh				\
   tests/misc/nice-fail.sh			\
@@ -314,6 +324,7 @@ all_tests =					\
   tests/misc/sha256sum.pl			\
   tests/misc/sha384sum.pl			\
   tests/misc/sha512sum.pl			\
+  tests/misc/sha-kernels.sh			\
   tests/misc/shred-exact.sh			\
   tests/misc/shred-negative.sh			\
   tests/misc/shred-passes.sh			\
@@ -322,6 +333,8 @@ all_tests =					\
   tests/misc/shuf-reservoir.sh			\
   tests/misc/sort.pl				\
   tests/misc/sort-benchmark-random.sh		\
+  tests/misc/sort-cgroup.sh			\
+  tests/misc/sort-check-parallel.sh		\
   tests/misc/sort-compress.sh			\
   tests/misc/sort-compress-hang.sh		\
   tests/misc/sort-compress-proc.sh		\
@@ -333,8 +346,13 @@ all_tests =					\
   tests/misc/sort-float.sh			\
   tests/misc/sort-merge.pl			\
   tests/misc/sort-merge-fdlimit.sh		\
+  tests/misc/sort-merge-parallel.sh		\
+  tests/misc/sort-mmap-truncate.sh		\
   tests/misc/sort-month.sh			\
   tests/misc/sort-exit-early.sh			\
+  tests/misc/sort-radix.sh			\
+  tests/misc/sort-unordered.sh			\
+  tests/misc/sort-top.sh			\
   tests/misc/sort-rand.sh			\
   tests/misc/sort-spinlock-abuse.sh		\
   tests/misc/sort-stale-thread-mem.sh		\
@@ -435,6 +453,7 @@ all_tests =					\
   tests/cp/fiemap-2.sh				\
   tests/cp/file-perm-race.sh			\
   tests/cp/into-self.sh				\
+  tests/cp/io-uring.sh				\
   tests/cp/link.sh				\
   tests/cp/link-deref.sh			\
   tests/cp/link-no-deref.sh			\
@@ -444,6 +463,7 @@ all_tests =					\
   tests/cp/no-deref-link1.sh			\
   tests/cp/no-deref-link2.sh			\
   tests/cp/no-deref-link3.sh			\
+  tests/cp/parallel.sh			\
   tests/cp/parent-perm.sh			\
   tests/cp/parent-perm-race.sh			\
   tests/cp/perm.sh				\
@@ -455,6 +475,7 @@ all_tests =					\
   tests/cp/proc-zero-len.sh			\
   tests/cp/r-vs-symlink.sh			\
   tests/cp/reflink-auto.sh			\
+  tests/cp/reflink-default.sh			\
   tests/cp/reflink-perm.sh			\
   tests/cp/same-file.sh				\
   tests/cp/slink-2-slink.sh			\
@@ -511,6 +532,7 @@ all_tests =					\
   tests/du/no-deref.sh				\
   tests/du/no-x.sh				\
   tests/du/one-file-system.sh			\
+  tests/du/parallel.sh				\
   tests/du/restore-wd.sh			\
   tests/du/slash.sh				\
   tests/du/threshold.sh				\
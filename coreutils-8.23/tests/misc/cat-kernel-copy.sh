@@ -0,0 +1,58 @@
+#!/bin/sh
+# Test that cat copies correctly when the kernel copies the data.
+
+# Copyright (C) 2014 Free Software Foundation, Inc.
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. "${srcdir=.}/tests/init.sh"; path_prepend_ ./src
+print_ver_ cat
+
+seq 100000 > in || framework_failure_
+seq 10 > in2 || framework_failure_
+
+# Regular file to regular file.
+cat in > out || fail=1
+compare in out || fail=1
+
+# Several operands, including standard input.
+cat in - in < in2 > out || fail=1
+{ cat in; cat in2; cat in; } > exp || framework_failure_
+compare exp out || fail=1
+
+# Regular file to pipe, and pipe to regular file.
+cat in | cat > out || fail=1
+compare in out || fail=1
+
+# Input that does not start at the beginning of the file.
+(dd bs=1000 skip=1 count=0 2>/dev/null; cat) < in > out || fail=1
+tail -c +1001 in > exp || framework_failure_
+compare exp out || fail=1
+
+# Output appended to a regular file.
+cp in2 out || framework_failure_
+cat in >> out || fail=1
+cat in2 in > exp || framework_failure_
+compare exp out || fail=1
+
+# Files that appear empty to some system calls.
+for f in /proc/self/status /sys/kernel/mm/transparent_hugepage/enabled; do
+  test -r $f || continue
+  cat $f > out || fail=1
+  test -s out || fail=1
+  cat $f | cat > out || fail=1
+  test -s out || fail=1
+done
+
+Exit $fail
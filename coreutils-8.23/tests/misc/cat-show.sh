@@ -0,0 +1,69 @@
+#!/bin/sh
+# Test cat's -v, -T, -E and -n on long runs of bytes of all values.
+
+# Copyright (C) 2014 Free Software Foundation, Inc.
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. "${srcdir=.}/tests/init.sh"; path_prepend_ ./src
+print_ver_ cat
+
+printf 'a\tb\001\037 ~\177\200\237\240\376\377\n' > in || framework_failure_
+printf 'a^Ib^A^_ ~^?M-^@M-^_M- M-~M-^?$\n' > exp || framework_failure_
+cat -A in > out || fail=1
+compare exp out || fail=1
+
+# A line with every byte but newline, and runs of printable bytes
+# long enough to be scanned in blocks, repeated over many input
+# buffers so that lines span buffer boundaries.
+printf '%s\n' \
+  '\000\001\002\003\004\005\006\007\010\011\013\014\015\016\017' \
+  '\020\021\022\023\024\025\026\027\030\031\032\033\034\035\036\037' \
+  ' !"#$%%&'\''()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ' \
+  '[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~\177' \
+  '\200\201\202\203\204\205\206\207\210\211\212\213\214\215\216\217' \
+  '\220\221\222\223\224\225\226\227\230\231\232\233\234\235\236\237' \
+  '\240\241\242\243\244\245\246\247\250\251\252\253\254\255\256\257' \
+  '\260\261\262\263\264\265\266\267\270\271\272\273\274\275\276\277' \
+  '\300\301\302\303\304\305\306\307\310\311\312\313\314\315\316\317' \
+  '\320\321\322\323\324\325\326\327\330\331\332\333\334\335\336\337' \
+  '\340\341\342\343\344\345\346\347\350\351\352\353\354\355\356\357' \
+  '\360\361\362\363\364\365\366\367\370\371\372\373\374\375\376\377' \
+  | tr -d '\n' > line || framework_failure_
+printf '\n\n\n%0100d\n' 0 >> line || framework_failure_
+for i in 1 2 3 4 5 6 7 8 9 10 11; do
+  cat line line > line2 && mv line2 line || framework_failure_
+done
+
+for opts in -A -v -T -E -vT -vE -ET -s -sA; do
+  head -n 4 line | cat $opts > exp1 || fail=1
+  for i in 1 2 3 4 5 6 7 8 9 10 11; do
+    cat exp1 exp1 > exp2 && mv exp2 exp1 || framework_failure_
+  done
+  case $opts in
+    -s*) cat -s exp1 > exp ;;
+    *) mv exp1 exp ;;
+  esac
+  cat $opts line > out || fail=1
+  compare exp out || fail=1
+done
+
+# Line numbers, past the width of their initial field.
+seq 1234567 > in || framework_failure_
+cat -n in | tail -n 3 > out || fail=1
+printf '%6d\t%d\n' 1234565 1234565 1234566 1234566 1234567 1234567 > exp \
+  || framework_failure_
+compare exp out || fail=1
+
+Exit $fail
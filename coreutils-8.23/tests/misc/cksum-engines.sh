@@ -0,0 +1,63 @@
+#!/bin/sh
+# Test that each way of computing cksum's CRC gives the same result.
+
+# Copyright (C) 2014 Free Software Foundation, Inc.
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. "${srcdir=.}/tests/init.sh"; path_prepend_ ./src
+print_ver_ cksum
+
+# A known checksum, with the byte-at-a-time reference.
+printf 'abc\n' > in || framework_failure_
+echo '1112837078 4' > exp || framework_failure_
+cksum ---engine=bytewise < in > out || fail=1
+compare exp out || fail=1
+
+seq 100000 > data || framework_failure_
+
+# Every length up to 300 bytes, and lengths around the multiples of the
+# 64 KiB read size.
+i=0
+while test $i -lt 300; do
+  echo $i
+  i=$(expr $i + 1)
+done > lengths || framework_failure_
+for n in 65536 131072 196608; do
+  for d in -65 -64 -63 -1 0 1 63 64 65; do
+    expr $n + $d
+  done
+done >> lengths || framework_failure_
+for n in $(cat lengths); do
+  head -c $n data > f$n || framework_failure_
+done
+
+# Each engine gives the data at each offset within a 16-byte block, and
+# at offsets that are not a multiple of 16 within larger blocks, as the
+# hidden ---buffer-offset option misaligns the read buffer.
+cksum ---engine=bytewise f* > exp || fail=1
+for off in 0 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 17 31 33 63; do
+  for engine in bytewise slice8 pclmul; do
+    cksum ---engine=$engine f1 > /dev/null 2>&1 || continue
+    cksum ---engine=$engine ---buffer-offset=$off f* > out || fail=1
+    compare exp out || fail=1
+  done
+  cksum ---buffer-offset=$off f* > out || fail=1
+  compare exp out || fail=1
+done
+
+cksum ---engine=no-such-engine in 2>/dev/null && fail=1
+cksum ---buffer-offset=64 in 2>/dev/null && fail=1
+
+Exit $fail
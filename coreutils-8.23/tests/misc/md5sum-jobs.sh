@@ -0,0 +1,69 @@
+#!/bin/sh
+# Test that md5sum --jobs outputs and diagnoses as it does serially.
+
+# Copyright (C) 2014 Free Software Foundation, Inc.
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. "${srcdir=.}/tests/init.sh"; path_prepend_ ./src
+print_ver_ md5sum sha256sum
+
+mkdir dir || framework_failure_
+for i in $(seq 100); do
+  seq $(expr $i \* 100) > f$i || framework_failure_
+done
+set -- f1 missing dir f2 - $(seq -f f%g 3 100)
+
+for prog in md5sum sha256sum; do
+  for opts in '' --tag; do
+    echo in | $prog $opts "$@" > exp 2>&1; echo $? >> exp
+    for n in 2 7 1000; do
+      echo in | $prog $opts --jobs=$n "$@" > out 2>&1; echo $? >> out
+      compare exp out || fail=1
+    done
+  done
+
+  # Check a list with mismatches, unreadable files, standard input
+  # and improperly formatted lines among the good ones.
+  $prog f* > sums || framework_failure_
+  sed 's/^[0-9a-f]/0/' sums | head -n 5 > bad || framework_failure_
+  sum=$(cut -c1-20 sums | head -n 1)
+  { cat bad; echo "$sum invalid"; sed -n '6,$p' sums
+    echo 'f1 missing'
+    for name in missing - dir f1; do sed -n "s/ f1\$/ $name/p" sums; done
+  } > check || framework_failure_
+  for opts in '' --quiet --status --warn --strict; do
+    echo in | $prog -c $opts check > exp 2>&1; echo $? >> exp
+    $prog -c $opts < check > exp-stdin 2>&1; echo $? >> exp-stdin
+    for n in 2 7; do
+      echo in | $prog -c $opts --jobs=$n check > out 2>&1; echo $? >> out
+      compare exp out || fail=1
+      $prog -c $opts --jobs=$n < check > out 2>&1; echo $? >> out
+      compare exp-stdin out || fail=1
+    done
+  done
+done
+
+# A large number of jobs is capped, rather than exhausting memory.
+md5sum f1 f2 > sums12 || framework_failure_
+for n in 4294967296 1180591620717411303424; do
+  md5sum -c --jobs=$n sums12 > out || fail=1
+  printf 'f1: OK\nf2: OK\n' > exp || framework_failure_
+  compare exp out || fail=1
+done
+
+md5sum --jobs=0 f1 2>/dev/null && fail=1
+md5sum --jobs=x f1 2>/dev/null && fail=1
+
+Exit $fail
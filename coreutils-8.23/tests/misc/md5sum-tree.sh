@@ -0,0 +1,80 @@
+#!/bin/sh
+# Test md5sum --tree-chunk.
+
+# Copyright (C) 2014 Free Software Foundation, Inc.
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. "${srcdir=.}/tests/init.sh"; path_prepend_ ./src
+print_ver_ md5sum sha256sum
+
+seq 3000 > in || framework_failure_
+: > empty || framework_failure_
+split -b 1024 in chunk. || framework_failure_
+
+# Output the binary checksums of the FILEs, concatenated, with PROG.
+cat_sums()
+{
+  prog=$1; shift
+  for f; do
+    printf "$($prog < $f | sed 's/ .*//; s/../\\x&/g')"
+  done
+}
+
+for prog in md5sum sha256sum; do
+  case $prog in
+    md5sum) tag=MD5;;
+    sha256sum) tag=SHA256;;
+  esac
+
+  sum=$(cat_sums $prog chunk.* | $prog | sed 's/ .*//')
+  esum=$(printf '' | $prog | sed 's/ .*//')
+  printf '%s\n' "$tag-TREE-1024 (in) = $sum" \
+    "$tag-TREE-1024 (empty) = $esum" > exp || framework_failure_
+  printf '%s\n' "$tag-TREE-1024 (-) = $sum" > exp-stdin || framework_failure_
+
+  for opts in '' --jobs=1 --jobs=3 --tag; do
+    $prog --tree-chunk=1K $opts in empty > out || fail=1
+    compare exp out || fail=1
+    $prog --tree-chunk=1K $opts < in > out || fail=1
+    compare exp-stdin out || fail=1
+    cat in | $prog --tree-chunk=1K $opts - > out || fail=1
+    compare exp-stdin out || fail=1
+  done
+
+  # A chunk covering the whole file yields the checksum of its checksum.
+  sum=$(cat_sums $prog in | $prog | sed 's/ .*//')
+  echo "$tag-TREE-1048576 (in) = $sum" > exp || framework_failure_
+  $prog --tree-chunk=1M in > out || fail=1
+  compare exp out || fail=1
+
+  # Check tree and classic lines together.
+  { $prog --tree-chunk=1K in empty; $prog --tree-chunk=100 in; $prog in
+  } > sums || framework_failure_
+  $prog --check --strict sums > out || fail=1
+  printf '%s\n' 'in: OK' 'empty: OK' 'in: OK' 'in: OK' > exp
+  compare exp out || fail=1
+  sed '1s/-TREE-1024/-TREE-2048/' sums > bad || framework_failure_
+  $prog --check --quiet bad > out && fail=1
+  echo 'in: FAILED' > exp
+  compare exp out || fail=1
+  sed '1s/-TREE-1024/-TREE-/' sums > bad || framework_failure_
+  $prog --check --strict --quiet bad 2> /dev/null && fail=1
+
+  $prog --tree-chunk=0 in 2> /dev/null && fail=1
+  $prog --tree-chunk=1K --text in 2> /dev/null && fail=1
+  $prog --tree-chunk=1K --check sums 2> /dev/null && fail=1
+done
+
+Exit $fail
@@ -0,0 +1,55 @@
+#!/bin/sh
+# Test that each way of processing SHA-2 blocks gives the same digests.
+
+# Copyright (C) 2014 Free Software Foundation, Inc.
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. "${srcdir=.}/tests/init.sh"; path_prepend_ ./src
+print_ver_ sha224sum sha256sum sha384sum sha512sum
+
+# The hidden ---kernel option is not there when OpenSSL does the work.
+sha256sum ---kernel=generic /dev/null > /dev/null 2>&1 \
+  || skip_ 'sha256sum has no ---kernel option'
+
+# A known digest, with the generic kernel.
+printf abc > in || framework_failure_
+echo 'ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad  in' \
+  > exp || framework_failure_
+sha256sum ---kernel=generic in > out || fail=1
+compare exp out || fail=1
+
+seq 200000 > data || framework_failure_
+
+# The lengths around the 64-byte and 128-byte block sizes, where the
+# padding needs one block or two, and lengths around the 32 KiB
+# multiples that are given to the kernels at once.
+for n in 0 1 55 56 57 63 64 65 111 112 113 119 120 127 128 129 \
+         255 256 257 32767 32768 32769 65535 65536 65663 1000001; do
+  head -c $n data > f$n || framework_failure_
+done
+
+for prog in sha224sum sha256sum sha384sum sha512sum; do
+  $prog ---kernel=generic f* > exp || fail=1
+  for kernel in bmi2 sha; do
+    $prog ---kernel=$kernel f1 > /dev/null 2>&1 || continue
+    $prog ---kernel=$kernel f* > out || fail=1
+    compare exp out || fail=1
+  done
+  $prog f* > out || fail=1
+  compare exp out || fail=1
+  $prog ---kernel=no-such-kernel in 2>/dev/null && fail=1
+done
+
+Exit $fail
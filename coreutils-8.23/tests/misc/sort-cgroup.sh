@@ -0,0 +1,59 @@
+#!/bin/sh
+# Test that sort's default buffer size is capped by cgroup memory limits.
+
+# Copyright (C) 2014 Free Software Foundation, Inc.
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. "${srcdir=.}/tests/init.sh"; path_prepend_ ./src
+print_ver_ sort
+
+# The hidden ---cgroup-root=DIR option reads DIR/cgroup in place of
+# /proc/self/cgroup, and DIR in place of /sys/fs/cgroup.  Two input
+# files, so that neither is mapped into memory, fit in a default buffer
+# but not in one capped at 64 KiB.  Whether the buffer was capped shows
+# in whether sort needs a temporary file, which it cannot create in the
+# nonexistent directory given with -T.
+seq 20000 > in1 || framework_failure_
+seq 20001 40000 > in2 || framework_failure_
+
+# cgroup v2, with the limit on an ancestor, and "max" below it.
+mkdir -p v2/a/b || framework_failure_
+echo 0::/a/b > v2/cgroup || framework_failure_
+echo max > v2/a/b/memory.max || framework_failure_
+echo max > v2/a/memory.max || framework_failure_
+sort ---cgroup-root=v2 -T no-such-dir in1 in2 > /dev/null || fail=1
+echo 65536 > v2/a/memory.max || framework_failure_
+sort ---cgroup-root=v2 -T no-such-dir in1 in2 > /dev/null 2> err && fail=1
+grep 'cannot create temporary file' err || fail=1
+
+# An explicit --buffer-size is not capped.
+sort ---cgroup-root=v2 -S 10M -T no-such-dir in1 in2 > /dev/null || fail=1
+
+# cgroup v1, with the memory controller among others.
+mkdir -p v1/memory/c || framework_failure_
+printf '4:cpu,memory:/c\n1:pids:/\n' > v1/cgroup || framework_failure_
+echo 9223372036854771712 > v1/memory/c/memory.limit_in_bytes \
+  || framework_failure_
+sort ---cgroup-root=v1 -T no-such-dir in1 in2 > /dev/null || fail=1
+echo 65536 > v1/memory/c/memory.limit_in_bytes || framework_failure_
+sort ---cgroup-root=v1 -T no-such-dir in1 in2 > /dev/null 2> err && fail=1
+grep 'cannot create temporary file' err || fail=1
+
+# With a usable temporary directory, the capped sort still works.
+sort ---cgroup-root=v1 in1 in2 > out || fail=1
+sort -S 10M in1 in2 > exp || framework_failure_
+compare exp out || fail=1
+
+Exit $fail
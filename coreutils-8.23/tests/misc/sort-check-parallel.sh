@@ -0,0 +1,50 @@
+#!/bin/sh
+# Test that sort -c checks large files in parallel as it does serially.
+
+# Copyright (C) 2014 Free Software Foundation, Inc.
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. "${srcdir=.}/tests/init.sh"; path_prepend_ ./src
+print_ver_ sort
+
+LC_ALL=C
+export LC_ALL
+
+# 4 MiB of 8-byte lines, so that each of 4 chunks has 131072 lines.
+seq -w 1000000 1524287 > in || framework_failure_
+
+for opts in -c -C -cu -Cu; do
+  sort $opts --parallel=4 in || fail=1
+done
+
+# Put a line out of order at and around the chunk boundaries, and
+# also repeat a line there, which only -u considers out of order.
+for n in 1 2 131071 131072 131073 262144 262145 393216 524288; do
+  sed "${n}s/.*/0000000/" in > out-of-order || framework_failure_
+  sed "${n}p" in > repeated || framework_failure_
+  for opts in -c -C -cu; do
+    for f in out-of-order repeated; do
+      sort $opts --parallel=1 $f > exp 2>&1; echo $? >> exp
+      sort $opts --parallel=4 $f > out 2>&1; echo $? >> out
+      compare exp out || fail=1
+    done
+  done
+done
+
+# An input that does not start at the beginning of the file.
+printf '9999999\n0000000\n' | cat - in > in2 || framework_failure_
+(head -n 2 >/dev/null; sort -c --parallel=4) < in2 || fail=1
+
+Exit $fail
@@ -69,4 +69,11 @@ compare exp out || fail=1
 test -f ok || fail=1
 rm -f dzip ok
 
+# The built-in method, also with merges done concurrently.
+for p in 1 3; do
+  sort --compress-temp=fast --parallel=$p -S 1k in > out || fail=1
+  compare exp out || fail=1
+done
+sort --compress-temp=fast --compress-program=gzip in > out 2>err && fail=1
+
 Exit $fail
@@ -0,0 +1,45 @@
+#!/bin/sh
+# Test that merging temporary files concurrently gives the same output
+# as merging them serially.
+
+# Copyright (C) 2014 Free Software Foundation, Inc.
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. "${srcdir=.}/tests/init.sh"; path_prepend_ ./src
+print_ver_ sort
+
+seq -w 5000 > exp || framework_failure_
+tac exp > in || framework_failure_
+cat in in > in2 || framework_failure_
+
+# A small buffer and batch size force several passes of merges,
+# each pass with many independent groups of temporary files.
+for batch in 2 3 16; do
+  for p in 1 2 5; do
+    sort -S 1k --batch-size=$batch --parallel=$p in > out || fail=1
+    compare exp out || fail=1
+
+    sort -u -S 1k --batch-size=$batch --parallel=$p in2 > out || fail=1
+    compare exp out || fail=1
+  done
+done
+
+# Merging many input files, rather than temporary files.
+mkdir dir || framework_failure_
+split -l 100 exp dir/ || framework_failure_
+sort -m --batch-size=2 --parallel=4 dir/* > out || fail=1
+compare exp out || fail=1
+
+Exit $fail
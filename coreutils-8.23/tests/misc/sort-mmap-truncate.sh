@@ -0,0 +1,44 @@
+#!/bin/sh
+# Test that sort diagnoses a mapped input file that is truncated.
+
+# Copyright (C) 2014 Free Software Foundation, Inc.
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. "${srcdir=.}/tests/init.sh"; path_prepend_ ./src
+print_ver_ sort truncate
+
+seq 200000 > in || framework_failure_
+mkdir tmp || framework_failure_
+
+# The compressor of the first temporary file truncates the input.
+# sort cannot go on to the next part of the input until the compressor
+# has read some of the first part, so the truncation happens while the
+# input is mapped and still needed.
+cat > trunc <<\EOF_TRUNC || framework_failure_
+#!/bin/sh
+truncate -s 0 in
+exec cat
+EOF_TRUNC
+chmod +x trunc || framework_failure_
+
+LC_ALL=C sort -S 1M -T tmp --compress-program=./trunc in > /dev/null 2> err
+test $? = 2 || fail=1
+echo 'sort: input file truncated: in' > exp || framework_failure_
+compare exp err || fail=1
+
+# The temporary files are removed.
+rmdir tmp || fail=1
+
+Exit $fail
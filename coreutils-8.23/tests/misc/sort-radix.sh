@@ -0,0 +1,42 @@
+#!/bin/sh
+# Test that the radix sort used for bytewise comparisons orders lines
+# as the general comparison does.
+
+# Copyright (C) 2014 Free Software Foundation, Inc.
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. "${srcdir=.}/tests/init.sh"; path_prepend_ ./src
+print_ver_ sort
+
+LC_ALL=C
+export LC_ALL
+
+# Many lines sharing long prefixes, with empty lines, duplicates,
+# embedded NULs and bytes with the high bit set.
+for i in $(seq 3000); do
+  printf '%s\n' "$(printf '%0*d' $((i % 37)) 0)$((i * 7919 % 1000))"
+done > in || framework_failure_
+printf '\n\na\0b\na\0a\na\n\200\377\n\377\200\n' >> in || framework_failure_
+cat in in > in2 || framework_failure_
+
+# -k1 compares the whole line as a key, avoiding the radix sort,
+# and also the mapping of a single regular input file into memory.
+for opts in '' -r -u -ru -s --parallel=3 '-S 1k' '-u -S 1k'; do
+  sort -k1 $opts in2 > exp || fail=1
+  sort $opts in2 > out || fail=1
+  compare exp out || fail=1
+done
+
+Exit $fail
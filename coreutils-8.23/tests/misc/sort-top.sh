@@ -0,0 +1,50 @@
+#!/bin/sh
+# Test that sort --top and --bottom output what head and tail would.
+
+# Copyright (C) 2014 Free Software Foundation, Inc.
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. "${srcdir=.}/tests/init.sh"; path_prepend_ ./src
+print_ver_ sort
+
+LC_ALL=C
+export LC_ALL
+
+# Many lines with equal keys, so that the order of ties matters.
+for i in $(seq 5000); do
+  echo "$((i * 7919 % 97)) $(echo abcde | cut -c$((i % 5 + 1))-) $i"
+done > in || framework_failure_
+
+# -S 1k has the selected lines kept across many buffers.
+for opts in '' -n -r '-k2,2' '-k2,2 -s' '-k2,2 -u' '-k2,2 -ru' '-k1,1n -u' \
+            '-k2,2 -S 1k' '-k1,1n -u -S 1k' '--parallel=3'; do
+  for k in 0 1 7 5000 6000; do
+    sort $opts in > sorted || framework_failure_
+    head -n $k sorted > exp || framework_failure_
+    sort $opts --top=$k in > out || fail=1
+    compare exp out || fail=1
+    tail -n $k sorted > exp || framework_failure_
+    sort $opts --bottom=$k in > out || fail=1
+    compare exp out || fail=1
+  done
+done
+
+sort --top=1 --bottom=1 in 2> err && fail=1
+echo "sort: options '--top --bottom' are incompatible" > exp || framework_failure_
+compare exp err || fail=1
+sort -c --top=1 in 2>/dev/null && fail=1
+sort --top=-1 in 2>/dev/null && fail=1
+
+Exit $fail
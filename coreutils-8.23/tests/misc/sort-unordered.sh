@@ -0,0 +1,57 @@
+#!/bin/sh
+# Test that sort -u --unordered outputs each distinct line once.
+
+# Copyright (C) 2014 Free Software Foundation, Inc.
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. "${srcdir=.}/tests/init.sh"; path_prepend_ ./src
+print_ver_ sort
+
+LC_ALL=C
+export LC_ALL
+
+for i in $(seq 4000); do
+  echo $((i * 7919 % 1500))
+done > in || framework_failure_
+printf 'a\0b\na\0a\n\na\0b\n\n' >> in || framework_failure_
+printf 'last' > in2 || framework_failure_
+
+sort -u in in2 > exp || framework_failure_
+
+# Without -u, the output is sorted as usual.
+sort --unordered in in2 > out || fail=1
+sort in in2 | compare - out || fail=1
+
+# The output is the first occurrence of each line, in any order.
+# A small buffer has the lines spilled to temporary files.
+for opts in '' '-S 1k' '-S 1k --compress-temp=fast' '-S 1k -o out2'; do
+  rm -f out2
+  sort -u --unordered $opts in in2 > out || fail=1
+  test -f out2 && mv out2 out
+  sort out | compare exp - || fail=1
+  test $(wc -l < out) = $(wc -l < exp) || fail=1
+done
+
+# Keys are honored, by sorting.
+printf '1 a\n2 a\n1 b\n' > in3 || framework_failure_
+sort -u --unordered -k1,1 in3 > out || fail=1
+printf '1 a\n2 a\n' | compare - out || fail=1
+
+# -z
+printf 'x\0y\0x\0' | sort -z -u --unordered | tr '\0' '\n' | sort > out \
+  || fail=1
+printf 'x\ny\n' | compare - out || fail=1
+
+Exit $fail
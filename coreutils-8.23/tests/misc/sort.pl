@@ -53,6 +53,13 @@ my @Tests =
 ["n10b", '-s -n -k1,1', {IN=>".00b\n.000a\n"}, {OUT=>".00b\n.000a\n"}],
 ["n11a", '-s -n -k1,1', {IN=>".01a\n.010\n"}, {OUT=>".01a\n.010\n"}],
 ["n11b", '-s -n -k1,1', {IN=>".010\n.01a\n"}, {OUT=>".010\n.01a\n"}],
+# Integer parts that differ decide the order; equal or overlong ones do not.
+["n12", '-n', {IN=>"-2.5\n-0.5\n-10\n0.5\n007\n-0\n"
+                  . "12345678901234567891\n12345678901234567890\n3\n"},
+ {OUT=>"-10\n-2.5\n-0.5\n-0\n0.5\n3\n007\n"
+       . "12345678901234567890\n12345678901234567891\n"}],
+["n13", '-k2,2n -k1,1', {IN=>"c 1.5\nb 1.25\na 01.5\nd -1.5\n"},
+ {OUT=>"d -1.5\nb 1.25\na 01.5\nc 1.5\n"}],
 
 # human readable suffixes
 ["h1", '-h',
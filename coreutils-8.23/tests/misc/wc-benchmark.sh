@@ -0,0 +1,61 @@
+#!/bin/sh
+# Benchmark wc for each combination of -l, -w, -m and -L.
+
+# Copyright (C) 2014 Free Software Foundation, Inc.
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. "${srcdir=.}/tests/init.sh"; path_prepend_ ./src
+print_ver_ wc
+
+very_expensive_
+
+# 64 MiB of text like a log file, with some multibyte characters.
+perl -e '
+my @words = (qw(lorem ipsum dolor sit amet consectetur adipiscing elit
+                GET /index.html 200 0.003), "caf\xc3\xa9", "\xe2\x82\xac12");
+srand (1);
+my $size = 0;
+while ($size < 64 * 1024 * 1024)
+{
+  my $line = join (" ", map { $words[rand @words] } 1 .. 3 + rand 12);
+  print "$line\n";
+  $size += length ($line) + 1;
+}' > in || framework_failure_
+
+: ${LOCALE_FR_UTF8=none}
+locales=C
+test "$LOCALE_FR_UTF8" != none && locales="C $LOCALE_FR_UTF8"
+
+# Report the throughput of each combination of options.  The words and
+# lines counted are also checked against those counted along with -L,
+# which does not use the vectorized kernels.
+for loc in $locales; do
+  for opts in -l -w -m -L -lw -lm -lL -wm -wL -mL -lwm -lwL -lmL -wmL -lwmL
+  do
+    LC_ALL=$loc perl -MTime::HiRes=time -e '
+      my ($opts, $loc) = @ARGV;
+      my $start = time;
+      system ("wc $opts < in > out") == 0 or exit 1;
+      my $secs = time - $start;
+      printf "%-8s %-6s %6.2f GB/s\n", $loc, $opts,
+        (-s "in") / 1e9 / ($secs || 1e-9);' -- $opts $loc || fail=1
+  done
+
+  LC_ALL=$loc wc -lw in > exp || fail=1
+  LC_ALL=$loc wc -lwL in | sed 's/ *[0-9]* in$/ in/' > out || fail=1
+  compare exp out || fail=1
+done
+
+Exit $fail
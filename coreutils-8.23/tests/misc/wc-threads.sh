@@ -0,0 +1,71 @@
+#!/bin/sh
+# Test that wc --threads counts as it does serially.
+
+# Copyright (C) 2014 Free Software Foundation, Inc.
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. "${srcdir=.}/tests/init.sh"; path_prepend_ ./src
+print_ver_ wc
+
+LC_ALL=C
+export LC_ALL
+
+# 4 MiB files, split into parts of 1 MiB with --threads=4.  Put words
+# and control characters across the part boundaries.
+printf '%04194303d\n' 0 > one-word || framework_failure_
+printf '%04194304d' 0 | tr 0 x > no-newline || framework_failure_
+i=0
+for sep in ' ' '\001' '\n\001\001' '\t\t'; do
+  i=$(expr $i + 1)
+  printf "%01048575d$sep" 0 0 0 0 | tr 0 y > words-$i || framework_failure_
+done
+seq 1000000 | tr '\n' ' ' | head -c 4194304 > numbers || framework_failure_
+
+for f in one-word no-newline words-* numbers; do
+  for opts in '' -l -w -lw -c -m -L -wL; do
+    wc $opts "$f" > exp || fail=1
+    wc $opts < "$f" > exp-stdin || fail=1
+    for n in 2 3 4 7; do
+      wc --threads=$n $opts "$f" > out || fail=1
+      compare exp out || fail=1
+      wc --threads=$n $opts < "$f" > out || fail=1
+      compare exp-stdin out || fail=1
+    done
+  done
+done
+
+# Many files, with errors among them, are reported in order.
+mkdir dir || framework_failure_
+for i in $(seq 100); do
+  seq $i > f$i || framework_failure_
+done
+set -- f1 missing dir f2 - $(seq -f f%g 3 100) numbers
+echo in | wc "$@" > exp 2>&1; echo $? >> exp
+echo in | wc --threads=4 "$@" > out 2>&1; echo $? >> out
+compare exp out || fail=1
+
+printf '%s\0' "$@" > names || framework_failure_
+wc --files0-from=names > exp 2>&1; echo $? >> exp
+wc --threads=4 --files0-from=names > out 2>&1; echo $? >> out
+compare exp out || fail=1
+
+# The file offset is left at the end of the file.
+(wc -l --threads=4 >/dev/null; wc -c) < numbers > out || fail=1
+echo 0 > exp
+compare exp out || fail=1
+
+wc --threads=0 f1 2>/dev/null && fail=1
+
+Exit $fail
@@ -41,6 +41,16 @@ my @Tests =
      ['c0', '-L',  {IN_PIPE=>"1\n12\n"},     {OUT=>"2\n"}],
      ['c1', '-L',  {IN_PIPE=>"1\n123\n1\n"}, {OUT=>"3\n"}],
      ['c2', '-L',  {IN_PIPE=>"\n123456"},    {OUT=>"6\n"}],
+     # Inputs longer than the blocks of the vectorized kernels, with
+     # control characters, which do not end words, and non-ASCII bytes.
+     ['d0', '-lw', {IN_PIPE=>"x " x 40},         {OUT=>"      0      40\n"}],
+     ['d1', '-lw', {IN_PIPE=>"word\n" x 50},     {OUT=>"     50      50\n"}],
+     ['d2', '-w',  {IN_PIPE=>"ab\x01cd " x 20},   {OUT=>"20\n"}],
+     ['d3', '-lw', {IN_PIPE=>"a\tb\x7f\x7fc\n" x 17},
+      {OUT=>"     17      34\n"}],
+     ['d4', '-w',  {IN_PIPE=>"\x80 a" x 30},      {OUT=>"30\n"}],
+     ['d5', '-w',  {IN_PIPE=>("y" x 100) . "\0" . ("z" x 100)},
+      {OUT=>"1\n"}],
     );
 
 my $save_temps = $ENV{DEBUG};
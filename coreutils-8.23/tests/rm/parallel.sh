@@ -0,0 +1,76 @@
+#!/bin/sh
+# Test rm -r --parallel.
+
+# Copyright (C) 2014 Free Software Foundation, Inc.
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. "${srcdir=.}/tests/init.sh"; path_prepend_ ./src
+print_ver_ rm
+
+# Make a tree with many directories, files and symlinks, and a chain of
+# directories deeper than a thread keeps open.
+mktree()
+{
+  for i in 1 2 3 4 5 6 7 8; do
+    for j in 1 2 3 4; do
+      mkdir -p $1/d$i/e$j/f || framework_failure_
+      for k in 1 2 3 4 5; do
+        echo $k > $1/d$i/e$j/f/g$k || framework_failure_
+      done
+      ln -s nowhere $1/d$i/e$j/dangling || framework_failure_
+    done
+  done
+  touch $1/top || framework_failure_
+  deep=$1/deep/$(seq 40 | tr -sc '\n' k | tr '\n' /)
+  mkdir -p $deep || framework_failure_
+  touch $deep/bottom || framework_failure_
+}
+
+for n in 1 2 8; do
+  mktree t$n
+  rm -r --parallel=$n t$n < /dev/null || fail=1
+  test -e t$n && fail=1
+done
+
+# --verbose lists the same files, in some order.
+mktree serial
+rm -rv serial < /dev/null | sed 's/serial/t/' | LC_ALL=C sort > exp \
+  || fail=1
+mktree t
+rm -rv --parallel=4 t < /dev/null | LC_ALL=C sort > out || fail=1
+compare exp out || fail=1
+
+# A directory that cannot be removed is diagnosed, and the directories
+# containing it are left, as without --parallel.  As root, the file in
+# the unwritable directory is removed anyway.
+mkdir -p serial/d1/ro serial/d2 || framework_failure_
+touch serial/d1/ro/f serial/d2/f || framework_failure_
+chmod a-w serial/d1/ro || framework_failure_
+cp -a serial t || framework_failure_
+rm -r serial < /dev/null 2> err-serial
+status=$?
+rm -r --parallel=4 t < /dev/null 2> err
+test $? = $status || fail=1
+sed 's/serial/t/' err-serial > exp || framework_failure_
+compare exp err || fail=1
+find serial 2> /dev/null | sed 's/serial/t/' | LC_ALL=C sort > exp
+find t 2> /dev/null | LC_ALL=C sort > out
+compare exp out || fail=1
+chmod -R u+w serial t 2> /dev/null
+
+rm -rf --parallel=4 nonexistent || fail=1
+rm -r --parallel=0 nonexistent 2> /dev/null && fail=1
+
+Exit $fail
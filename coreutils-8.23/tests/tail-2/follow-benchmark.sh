@@ -0,0 +1,109 @@
+#!/bin/sh
+# Benchmark tail -f following many files that writers append to quickly.
+
+# Copyright (C) 2014 Free Software Foundation, Inc.
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. "${srcdir=.}/tests/init.sh"; path_prepend_ ./src
+print_ver_ tail
+
+very_expensive_
+
+# The number of files followed, the number of writers appending lines
+# to them in turn, and the number of lines each writer appends.
+: ${TAIL_BENCH_FILES=2000} ${TAIL_BENCH_WRITERS=8} ${TAIL_BENCH_LINES=50000}
+n_files=$TAIL_BENCH_FILES
+test $(ulimit -n) -gt $(expr $n_files + 20) \
+  || skip_ "too few file descriptors for $n_files files"
+
+# Output the user and system CPU seconds used so far by process PID.
+cpu_seconds()
+{
+  perl -e 'open S, "/proc/$ARGV[0]/stat" or exit 1;
+    my @f = split / /, (split /\) /, <S>)[1];
+    printf "%.2f\n", ($f[11] + $f[12]) / 100' $1
+}
+
+# Output the time in seconds since the epoch.
+now() { perl -MTime::HiRes=time -e 'printf "%.2f\n", time'; }
+
+# Wait up to a minute for FILE to have LINES lines of data.
+wait_for_lines()
+{
+  for i in $(seq 600); do
+    test $(grep -c 'of f[0-9]*$' $1) -ge $2 && return 0
+    sleep .1
+  done
+  return 1
+}
+
+# In each mode, with inotify and with polling, follow the files while the
+# writers append, then check that the data of each file was output.
+for mode in inotify ---disable-inotify; do
+  opt=$mode; test $mode = inotify && opt=
+  rm -f f* out || framework_failure_
+  for i in $(seq $n_files); do : > f$i || framework_failure_; done
+
+  tail -n0 -s.1 -f $opt f* > out & pid=$!
+  sleep 1
+
+  start=$(now)
+  writers=
+  for w in $(seq $TAIL_BENCH_WRITERS); do
+    perl -e '
+      my ($w, $n_writers, $n_files, $n_lines) = @ARGV;
+      for my $l (1 .. $n_lines)
+        {
+          my $f = 1 + ($w + $l * $n_writers) % $n_files;
+          open F, ">>", "f$f" or die "f$f: $!\n";
+          syswrite F, "writer $w line $l of f$f\n";
+          close F;
+        }' $w $TAIL_BENCH_WRITERS $n_files $TAIL_BENCH_LINES &
+    writers="$writers $!"
+  done
+  wait $writers
+  lines=$(expr $TAIL_BENCH_WRITERS \* $TAIL_BENCH_LINES)
+  wait_for_lines out $lines || fail=1
+  end=$(now)
+  cpu=$(cpu_seconds $pid)
+  kill $pid
+  wait $pid
+
+  echo "$mode: $n_files files, $lines lines:" \
+       "$(perl -e "printf q(%.2f), $end - $start") s elapsed, $cpu s tail CPU"
+
+  # Reassemble the data output for each file from the parts between the
+  # headers.  A line can be split across parts, as a reader can see a
+  # write that crosses a page boundary before it is complete.
+  perl -e '
+    local $/;
+    $_ = <STDIN>;
+    s/\A==> (.*?) <==\n// or exit 1;
+    my ($name, %data) = ($1);
+    my @parts = split /\n==> (.*?) <==\n/;
+    while (@parts)
+      {
+        $data{$name} .= shift @parts;
+        $name = shift @parts;
+      }
+    for my $f (sort keys %data)
+      {
+        open F, "<", $f or die "$f: $!\n";
+        my $exp = <F>;
+        $data{$f} eq $exp or die "$f: wrong output\n";
+      }' < out || fail=1
+done
+
+Exit $fail
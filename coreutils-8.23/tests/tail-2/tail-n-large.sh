@@ -0,0 +1,55 @@
+#!/bin/sh
+# Test tail -n on files much larger than the blocks it reads backward.
+
+# Copyright (C) 2014 Free Software Foundation, Inc.
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. "${srcdir=.}/tests/init.sh"; path_prepend_ ./src
+print_ver_ tail
+
+# About 2 MiB of short lines, then lines longer than a block, and the
+# same without the final newline.
+seq 300000 > short || framework_failure_
+printf '%0300000d\n' 0 1 2 > long || framework_failure_
+cat short long short > in || framework_failure_
+head -c -1 in > in-nonl || framework_failure_
+n_in=$(wc -l < in)
+
+for f in in in-nonl; do
+  for n in 1 2 3 4 1000 299999 300000 300001 300003 300004 $n_in \
+           $(expr $n_in + 1) 10000000; do
+    # Compute the expected output by counting from the start.
+    total=$(wc -l < $f)
+    test "$(tail -c 1 $f)" && total=$(expr $total + 1)
+    skip=$(expr $total - $n + 1)
+    test $skip -lt 1 && skip=1
+    tail -n +$skip $f > exp || framework_failure_
+
+    # The blocks are read by up to as many threads as there are
+    # processors, whose number can be overridden.
+    for threads in 1 4; do
+      OMP_NUM_THREADS=$threads tail -n $n $f > out || fail=1
+      compare exp out || fail=1
+    done
+  done
+done
+
+# Read from a nonzero offset, leaving it at the end.
+(echo x; seq 100000) > in || framework_failure_
+(read x; tail -n 100001; echo end) < in > out || fail=1
+{ seq 100000; echo end; } > exp || framework_failure_
+compare exp out || fail=1
+
+Exit $fail